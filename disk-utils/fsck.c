@@ -204,6 +204,7 @@ static int is_mounted(struct libmnt_fs *fs)
 		if (!mtab)
 			err(FSCK_EX_ERROR, ("failed to initialize libmount table"));
 		mnt_table_set_cache(mtab, mntcache);
+		mnt_table_enable_index(mtab, 1);
 		mnt_table_parse_mtab(mtab, NULL);
 	}
 
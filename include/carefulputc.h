@@ -11,6 +11,7 @@
 #include <ctype.h>
 
 #include "cctype.h"
+#include "swar.h"
 
 static inline int fputc_careful(int c, FILE *fp, const char fail)
 {
@@ -28,6 +29,34 @@ static inline int fputc_careful(int c, FILE *fp, const char fail)
 	return (ret < 0) ? EOF : 0;
 }
 
+static inline int json_need_escape(unsigned char c)
+{
+	return c == '"' || c == '\\' || c < 0x20;
+}
+
+/*
+ * Returns number of bytes at the begin of @p (max @sz bytes) which don't
+ * require JSON escaping. The string is scanned by words (SWAR), so long
+ * strings without special chars are not processed byte by byte.
+ */
+static inline size_t json_safe_span(const char *p, size_t sz)
+{
+	size_t i = 0;
+
+	for (; i + sizeof(unsigned long) <= sz; i += sizeof(unsigned long)) {
+		unsigned long v;
+
+		memcpy(&v, p + i, sizeof(v));
+		if (SWAR_HASLESS(v, 0x20)
+		    || SWAR_HASBYTE(v, '"')
+		    || SWAR_HASBYTE(v, '\\'))
+			break;
+	}
+	while (i < sz && !json_need_escape((unsigned char) p[i]))
+		i++;
+	return i;
+}
+
 /*
  * Requirements enumerated via testing (V8, Firefox, IE11):
  *
@@ -42,12 +71,35 @@ static inline int fputc_careful(int c, FILE *fp, const char fail)
  */
 static inline void fputs_quoted_case_json(const char *data, FILE *out, int dir)
 {
-	const char *p;
+	const char *p = data, *end = data ? data + strlen(data) : NULL;
+	char buf[128];
+	size_t n = 0;
 
 	fputc('"', out);
-	for (p = data; p && *p; p++) {
+	while (p && p < end) {
+		unsigned char c;
+
+		/* Write not-escaped chunks directly, without the buffer. */
+		if (dir == 0) {
+			size_t sz = json_safe_span(p, end - p);
+
+			if (sz) {
+				if (n)
+					fwrite(buf, 1, n, out);
+				n = 0;
+				fwrite(p, 1, sz, out);
+				p += sz;
+				continue;
+			}
+		}
 
-		const unsigned char c = (unsigned char) *p;
+		c = (unsigned char) *p++;
+
+		/* keep space for the longest sequence (\u00XX) */
+		if (n + 6 > sizeof(buf)) {
+			fwrite(buf, 1, n, out);
+			n = 0;
+		}
 
 		/* From http://www.json.org
 		 *
@@ -58,21 +110,22 @@ static inline void fputs_quoted_case_json(const char *data, FILE *out, int dir)
 		 * in the JSON spec, don't break double-quoted strings.
 		 */
 		if (c == '"' || c == '\\') {
-			fputc('\\', out);
-			fputc(c, out);
+			buf[n++] = '\\';
+			buf[n++] = c;
 			continue;
 		}
 
 		/* All non-control characters OK; do the case swap as required. */
 		if (c >= 0x20) {
-			fputc(dir ==  1 ? toupper(c) :
-			      dir == -1 ? tolower(c) : *p, out);
+			buf[n++] = dir ==  1 ? toupper(c) :
+				   dir == -1 ? tolower(c) : c;
 			continue;
 		}
 
 		/* In addition, all chars under ' ' break Node's/V8/Chrome's, and
 		 * Firefox's JSON.parse function
 		 */
+		buf[n++] = '\\';
 		switch (c) {
 			/* Handle short-hand cases to reduce output size.  C
 			 * has most of the same stuff here, so if there's an
@@ -80,26 +133,33 @@ static inline void fputs_quoted_case_json(const char *data, FILE *out, int dir)
 			 * should probably be using it.
 			 */
 			case '\b':
-				fputs("\\b", out);
+				buf[n++] = 'b';
 				break;
 			case '\t':
-				fputs("\\t", out);
+				buf[n++] = 't';
 				break;
 			case '\n':
-				fputs("\\n", out);
+				buf[n++] = 'n';
 				break;
 			case '\f':
-				fputs("\\f", out);
+				buf[n++] = 'f';
 				break;
 			case '\r':
-				fputs("\\r", out);
+				buf[n++] = 'r';
 				break;
 			default:
-				/* Other assorted control characters */
-				fprintf(out, "\\u00%02x", c);
+				/* Other assorted control characters; no sprintf(),
+				 * its terminating zero does not fit to the buffer */
+				buf[n++] = 'u';
+				buf[n++] = '0';
+				buf[n++] = '0';
+				buf[n++] = "0123456789abcdef"[c >> 4];
+				buf[n++] = "0123456789abcdef"[c & 0xf];
 				break;
 		}
 	}
+	if (n)
+		fwrite(buf, 1, n, out);
 	fputc('"', out);
 }
 
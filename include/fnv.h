@@ -0,0 +1,55 @@
+/*
+ * No copyright is claimed.  This code is in the public domain; do with
+ * it what you wish.
+ *
+ * FNV-1a 64-bit hash, see http://www.isthe.com/chongo/tech/comp/fnv/
+ */
+#ifndef UTIL_LINUX_FNV_H
+#define UTIL_LINUX_FNV_H
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+
+#define UL_FNV64_INIT		0xcbf29ce484222325ULL
+#define UL_FNV64_PRIME		0x100000001b3ULL
+
+static inline uint64_t ul_fnv1a64_add(uint64_t h, uint64_t v)
+{
+	return (h ^ v) * UL_FNV64_PRIME;
+}
+
+static inline uint64_t ul_fnv1a64_str(uint64_t h, const char *str)
+{
+	for (; str && *str; str++)
+		h = ul_fnv1a64_add(h, (unsigned char) *str);
+	return h;
+}
+
+/* hashes @buf by 64-bit words, the rest by bytes */
+static inline uint64_t ul_fnv1a64_buf(uint64_t h, const void *buf, size_t sz)
+{
+	const unsigned char *p = (const unsigned char *) buf;
+	size_t i;
+
+	for (i = 0; i + sizeof(uint64_t) <= sz; i += sizeof(uint64_t)) {
+		uint64_t w;
+
+		memcpy(&w, p + i, sizeof(w));
+		h = ul_fnv1a64_add(h, w);
+	}
+	for (; i < sz; i++)
+		h = ul_fnv1a64_add(h, p[i]);
+	return h;
+}
+
+/* final mix (from MurmurHash3 fmix64), FNV has poor low bits for masks */
+static inline uint64_t ul_hash_mix64(uint64_t h)
+{
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+#endif /* UTIL_LINUX_FNV_H */
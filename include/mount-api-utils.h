@@ -0,0 +1,76 @@
+#ifndef UTIL_LINUX_MOUNT_API_UTILS
+#define UTIL_LINUX_MOUNT_API_UTILS
+
+#if defined(__linux__)
+# include <sys/syscall.h>
+# if defined(SYS_open_tree) && defined(SYS_move_mount) && defined(SYS_mount_setattr)
+#  include <stdint.h>
+#  include <unistd.h>
+#  include <fcntl.h>
+#  include <sys/mount.h>
+
+#  ifndef OPEN_TREE_CLONE
+#   define OPEN_TREE_CLONE	1
+#  endif
+#  ifndef OPEN_TREE_CLOEXEC
+#   define OPEN_TREE_CLOEXEC	O_CLOEXEC
+#  endif
+#  ifndef MOVE_MOUNT_F_EMPTY_PATH
+#   define MOVE_MOUNT_F_EMPTY_PATH	0x00000004
+#  endif
+#  ifndef AT_RECURSIVE
+#   define AT_RECURSIVE		0x8000
+#  endif
+
+#  ifndef MOUNT_ATTR_SIZE_VER0
+#   define MOUNT_ATTR_SIZE_VER0	32
+
+#   define MOUNT_ATTR_RDONLY	0x00000001
+#   define MOUNT_ATTR_NOSUID	0x00000002
+#   define MOUNT_ATTR_NODEV	0x00000004
+#   define MOUNT_ATTR_NOEXEC	0x00000008
+#   define MOUNT_ATTR__ATIME	0x00000070
+#   define MOUNT_ATTR_RELATIME	0x00000000
+#   define MOUNT_ATTR_NOATIME	0x00000010
+#   define MOUNT_ATTR_STRICTATIME	0x00000020
+#   define MOUNT_ATTR_NODIRATIME	0x00000080
+#   define MOUNT_ATTR_IDMAP	0x00100000
+
+struct mount_attr {
+	uint64_t attr_set;
+	uint64_t attr_clr;
+	uint64_t propagation;
+	uint64_t userns_fd;
+};
+#  endif /* MOUNT_ATTR_SIZE_VER0 */
+
+#  ifndef HAVE_OPEN_TREE
+static inline int open_tree(int dfd, const char *filename, unsigned int flags)
+{
+	return syscall(SYS_open_tree, dfd, filename, flags);
+}
+#  endif
+
+#  ifndef HAVE_MOVE_MOUNT
+static inline int move_mount(int from_dfd, const char *from_pathname,
+			     int to_dfd, const char *to_pathname,
+			     unsigned int flags)
+{
+	return syscall(SYS_move_mount, from_dfd, from_pathname,
+				       to_dfd, to_pathname, flags);
+}
+#  endif
+
+#  ifndef HAVE_MOUNT_SETATTR
+static inline int mount_setattr(int dfd, const char *path, unsigned int flags,
+				struct mount_attr *attr, size_t size)
+{
+	return syscall(SYS_mount_setattr, dfd, path, flags, attr, size);
+}
+#  endif
+
+#  define UL_HAVE_MOUNT_API 1
+
+# endif	/* SYS_open_tree && SYS_move_mount && SYS_mount_setattr */
+#endif /* __linux__ */
+#endif /* UTIL_LINUX_MOUNT_API_UTILS */
@@ -0,0 +1,13 @@
+/*
+ * No copyright is claimed.  This code is in the public domain; do with
+ * it what you wish.
+ */
+#ifndef UTIL_LINUX_PARALLEL_H
+#define UTIL_LINUX_PARALLEL_H
+
+#include <sys/types.h>
+
+extern size_t ul_get_nthreads(const char *envname, size_t nitems,
+			      size_t minitems, size_t maxthreads);
+
+#endif /* UTIL_LINUX_PARALLEL_H */
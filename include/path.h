@@ -9,6 +9,8 @@
 
 #include "c.h"
 
+struct path_cache_entry;
+
 struct path_cxt {
 	int	dir_fd;
 	char	*dir_path;
@@ -21,6 +23,9 @@ struct path_cxt {
 	void	*dialect;
 	void	(*free_dialect)(struct path_cxt *);
 	int	(*redirect_on_enoent)(struct path_cxt *, const char *, int *);
+
+	struct path_cache_entry	*cache;		/* see ul_path_prefetch() */
+	size_t			ncache;
 };
 
 struct path_cxt *ul_new_path(const char *dir, ...);
@@ -44,6 +49,9 @@ void ul_path_close_dirfd(struct path_cxt *pc);
 int ul_path_isopen_dirfd(struct path_cxt *pc);
 int ul_path_is_accessible(struct path_cxt *pc);
 
+int ul_path_prefetch(struct path_cxt *pc, const char **paths, size_t npaths);
+void ul_path_drop_cache(struct path_cxt *pc);
+
 char *ul_path_get_abspath(struct path_cxt *pc, char *buf, size_t bufsz, const char *path, ...)
 				__attribute__ ((__format__ (__printf__, 4, 5)));
 
@@ -0,0 +1,22 @@
+/*
+ * No copyright is claimed.  This code is in the public domain; do with
+ * it what you wish.
+ *
+ * SIMD within a register -- test all bytes of the machine word at once.
+ */
+#ifndef UTIL_LINUX_SWAR_H
+#define UTIL_LINUX_SWAR_H
+
+#define SWAR_ONES		(~(unsigned long) 0 / 0xff)	/* 0x0101...01 */
+#define SWAR_HIGHS		(SWAR_ONES * 0x80)		/* 0x8080...80 */
+
+/* non-zero if any byte in @v is zero */
+#define SWAR_HASZERO(v)		(((v) - SWAR_ONES) & ~(v) & SWAR_HIGHS)
+
+/* non-zero if any byte in @v is less than @n (@n <= 128) */
+#define SWAR_HASLESS(v, n)	(((v) - SWAR_ONES * (n)) & ~(v) & SWAR_HIGHS)
+
+/* non-zero if any byte in @v is @c */
+#define SWAR_HASBYTE(v, c)	SWAR_HASZERO((v) ^ (SWAR_ONES * (unsigned char) (c)))
+
+#endif /* UTIL_LINUX_SWAR_H */
@@ -22,10 +22,17 @@ void ul_jsonwrt_init(struct ul_jsonwrt *fmt, FILE *out, int indent)
 
 void ul_jsonwrt_indent(struct ul_jsonwrt *fmt)
 {
-	int i;
+	static const char spaces[] =
+		"                                                "
+		"                                                ";
+	size_t sz = fmt->indent > 0 ? (size_t) fmt->indent * 3 : 0;
 
-	for (i = 0; i < fmt->indent; i++)
-		fputs("   ", fmt->out);
+	while (sz) {
+		size_t n = min(sz, sizeof(spaces) - 1);
+
+		fwrite(spaces, 1, n, fmt->out);
+		sz -= n;
+	}
 }
 
 void ul_jsonwrt_open(struct ul_jsonwrt *fmt, const char *name, int type)
@@ -27,6 +27,36 @@
 #include "mbsalign.h"
 #include "strutils.h"
 #include "widechar.h"
+#include "swar.h"
+
+/*
+ * Fast path for the most common case. Returns 1 if the first @bufsz bytes of
+ * @buf are printable ASCII chars (0x20..0x7e) and there is no backslash. Such
+ * string does not require any encoding and number of cells is the same as
+ * number of bytes, so mbrtowc() and wcwidth() are unnecessary.
+ *
+ * The string is checked by machine words (SIMD within a register).
+ */
+static int is_safe_ascii(const char *buf, size_t bufsz)
+{
+	const char *p = buf, *end = buf + bufsz;
+
+	for (; p + sizeof(unsigned long) <= end; p += sizeof(unsigned long)) {
+		unsigned long v;
+
+		memcpy(&v, p, sizeof(v));
+		if ((v & SWAR_HIGHS)			/* non-ASCII */
+		    || SWAR_HASLESS(v, 0x20)		/* control chars */
+		    || SWAR_HASBYTE(v, 0x7f)		/* DEL */
+		    || SWAR_HASBYTE(v, '\\'))
+			return 0;
+	}
+	for (; p < end; p++) {
+		if (*p < 0x20 || *p > 0x7e || *p == '\\')
+			return 0;
+	}
+	return 1;
+}
 
 /*
  * Counts number of cells in multibyte string. All control and
@@ -39,6 +69,9 @@ size_t mbs_nwidth(const char *buf, size_t bufsz)
 	const char *p = buf, *last = buf;
 	size_t width = 0;
 
+	if (p && is_safe_ascii(p, bufsz))
+		return bufsz;
+
 #ifdef HAVE_WIDECHAR
 	mbstate_t st;
 	memset(&st, 0, sizeof(st));
@@ -106,6 +139,11 @@ size_t mbs_safe_nwidth(const char *buf, size_t bufsz, size_t *sz)
 	mbstate_t st;
 	memset(&st, 0, sizeof(st));
 #endif
+	if (p && is_safe_ascii(p, bufsz)) {
+		if (sz)
+			*sz = bufsz;
+		return bufsz;
+	}
 	if (p && *p && bufsz)
 		last = p + (bufsz - 1);
 
@@ -183,6 +221,12 @@ char *mbs_safe_encode_to_buffer(const char *s, size_t *width, char *buf, const c
 	if (!sz || !buf)
 		return NULL;
 
+	if (is_safe_ascii(s, sz)) {
+		memcpy(buf, s, sz + 1);
+		*width = sz;
+		return buf;
+	}
+
 	r = buf;
 	*width = 0;
 
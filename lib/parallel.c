@@ -0,0 +1,42 @@
+/*
+ * No copyright is claimed.  This code is in the public domain; do with
+ * it what you wish.
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include "c.h"
+#include "parallel.h"
+
+/*
+ * Returns number of threads to process @nitems items. The threads are used
+ * only if there is at least @minitems items and more online CPUs, the
+ * result is never larger than @maxthreads.
+ *
+ * The environment variable @envname (e.g. LSBLK_THREADS=<num>) overrides
+ * the heuristic; it's usable for debugging and regression tests, which
+ * have usually small number of items.
+ */
+size_t ul_get_nthreads(const char *envname, size_t nitems,
+		       size_t minitems, size_t maxthreads)
+{
+	const char *str = envname ? getenv(envname) : NULL;
+	long n;
+
+	if (str && *str) {
+		char *end = NULL;
+
+		errno = 0;
+		n = strtol(str, &end, 10);
+		if (!errno && end && !*end && n > 0)
+			return min((size_t) n, maxthreads);
+	}
+
+	if (nitems < minitems)
+		return 1;
+	n = sysconf(_SC_NPROCESSORS_ONLN);
+	if (n <= 1)
+		return 1;
+	return min((size_t) n, maxthreads);
+}
@@ -8,6 +8,10 @@
  * The ul_path_read_* API is possible to use without path_cxt handler. In this
  * case is not possible to use global prefix and printf-like formatting.
  *
+ * The small files (e.g. sysfs attributes) which will be used later is possible
+ * to read in advance by ul_path_prefetch(). The ul_path_read* and
+ * ul_path_scanf() functions return data from the cache for these files.
+ *
  * No copyright is claimed.  This code is in the public domain; do with
  * it what you wish.
  *
@@ -42,6 +46,19 @@ UL_DEBUG_DEFINE_MASKNAMES(ulpath) = UL_DEBUG_EMPTY_MASKNAMES;
 #define UL_DEBUG_CURRENT_MASK	UL_DEBUG_MASK(ulpath)
 #include "debugobj.h"
 
+/* Maximal size of the cached file, sysfs attributes are never larger than
+ * page size */
+#define PATH_CACHE_MAXSZ	4096
+
+struct path_cache_entry {
+	char	*path;		/* relative to the context directory */
+	char	*data;		/* terminated by zero, NULL on error */
+	size_t	datasz;
+
+	int	rc;		/* ul_path_read() return code on error */
+	int	errsv;		/* errno on error */
+};
+
 void ul_path_init_debug(void)
 {
 	if (ulpath_debug_mask)
@@ -95,6 +112,7 @@ void ul_unref_path(struct path_cxt *pc)
 		DBG(CXT, ul_debugobj(pc, "dealloc"));
 		if (pc->dialect)
 			pc->free_dialect(pc);
+		ul_path_drop_cache(pc);
 		ul_path_close_dirfd(pc);
 		free(pc->dir_path);
 		free(pc->prefix);
@@ -116,6 +134,7 @@ int ul_path_set_prefix(struct path_cxt *pc, const char *prefix)
 
 	free(pc->prefix);
 	pc->prefix = p;
+	ul_path_drop_cache(pc);
 	DBG(CXT, ul_debugobj(pc, "new prefix: '%s'", p));
 	return 0;
 }
@@ -142,6 +161,7 @@ int ul_path_set_dir(struct path_cxt *pc, const char *dir)
 
 	free(pc->dir_path);
 	pc->dir_path = p;
+	ul_path_drop_cache(pc);
 	DBG(CXT, ul_debugobj(pc, "new dir: '%s'", p));
 	return 0;
 }
@@ -243,6 +263,127 @@ int ul_path_isopen_dirfd(struct path_cxt *pc)
 	return pc && pc->dir_fd >= 0;
 }
 
+static struct path_cache_entry *path_cache_get(struct path_cxt *pc, const char *path)
+{
+	size_t i;
+
+	if (!pc || !pc->ncache)
+		return NULL;
+	if (*path == '/')
+		path++;
+
+	for (i = 0; i < pc->ncache; i++) {
+		if (strcmp(pc->cache[i].path, path) == 0)
+			return &pc->cache[i];
+	}
+	return NULL;
+}
+
+/*
+ * Reads all @paths (relative to @pc directory) and keeps the content in
+ * memory. The next ul_path_read*() and ul_path_scanf() calls for the paths
+ * do not access the files. The cache is valid until ul_path_drop_cache(),
+ * any write by ul_path_write*() or the context change.
+ *
+ * The errors are cached too (the missing attributes are usual in sysfs). The
+ * files larger than 4KiB are not cached.
+ *
+ * Returns: 0 on success, <0 on error.
+ */
+int ul_path_prefetch(struct path_cxt *pc, const char **paths, size_t npaths)
+{
+	struct path_cache_entry *cache;
+	char buf[PATH_CACHE_MAXSZ];
+	size_t i;
+	int dir;
+
+	assert(pc);
+
+	if (!npaths)
+		return 0;
+
+	dir = ul_path_get_dirfd(pc);
+	if (dir < 0)
+		return dir;
+
+	cache = realloc(pc->cache, (pc->ncache + npaths) * sizeof(*cache));
+	if (!cache)
+		return -ENOMEM;
+	pc->cache = cache;
+
+	for (i = 0; i < npaths; i++) {
+		struct path_cache_entry *ce;
+		const char *path = paths[i];
+		int fd, fdir = dir, rc = 0;
+
+		if (*path == '/')
+			path++;
+		if (path_cache_get(pc, path))
+			continue;
+
+		fd = openat(dir, path, O_RDONLY|O_CLOEXEC);
+		if (fd < 0 && errno == ENOENT
+		    && pc->redirect_on_enoent
+		    && pc->redirect_on_enoent(pc, path, &fdir) == 0)
+			fd = openat(fdir, path, O_RDONLY|O_CLOEXEC);
+		if (fd >= 0) {
+			int errsv;
+
+			rc = read_all(fd, buf, sizeof(buf));
+			errsv = errno;
+			close(fd);
+			errno = errsv;
+
+			if (rc == sizeof(buf))
+				continue;	/* too large, don't cache */
+		}
+
+		ce = &pc->cache[pc->ncache];
+		memset(ce, 0, sizeof(*ce));
+
+		ce->path = strdup(path);
+		if (!ce->path)
+			return -ENOMEM;
+
+		if (fd < 0 || rc < 0) {
+			ce->errsv = errno;
+			ce->rc = fd < 0 ? -errno : rc;
+		} else {
+			ce->data = malloc(rc + 1);
+			if (!ce->data) {
+				free(ce->path);
+				return -ENOMEM;
+			}
+			memcpy(ce->data, buf, rc);
+			ce->data[rc] = '\0';
+			ce->datasz = rc;
+		}
+		pc->ncache++;
+	}
+
+	DBG(CXT, ul_debugobj(pc, "prefetched %zu files [cache size=%zu]", npaths, pc->ncache));
+	return 0;
+}
+
+/* Deallocates all data read by ul_path_prefetch() */
+void ul_path_drop_cache(struct path_cxt *pc)
+{
+	size_t i;
+
+	if (!pc || !pc->cache)
+		return;
+
+	DBG(CXT, ul_debugobj(pc, "drop cache"));
+
+	for (i = 0; i < pc->ncache; i++) {
+		free(pc->cache[i].path);
+		free(pc->cache[i].data);
+	}
+	free(pc->cache);
+	pc->cache = NULL;
+	pc->ncache = 0;
+}
+
 static const char *ul_path_mkpath(struct path_cxt *pc, const char *path, va_list ap)
 {
 	int rc;
@@ -577,9 +718,21 @@ ssize_t ul_path_readlinkf(struct path_cxt *pc, char *buf, size_t bufsiz, const c
 
 int ul_path_read(struct path_cxt *pc, char *buf, size_t len, const char *path)
 {
+	struct path_cache_entry *ce = path_cache_get(pc, path);
 	int rc, errsv;
 	int fd;
 
+	if (ce) {
+		if (!ce->data) {
+			errno = ce->errsv;
+			return ce->rc;
+		}
+		DBG(CXT, ul_debug(" reading '%s' [cached]", path));
+		rc = min(len, ce->datasz);
+		memcpy(buf, ce->data, rc);
+		return rc;
+	}
+
 	fd = ul_path_open(pc, O_RDONLY|O_CLOEXEC, path);
 	if (fd < 0)
 		return -errno;
@@ -683,15 +836,35 @@ int ul_path_readf_buffer(struct path_cxt *pc, char *buf, size_t bufsz, const cha
 	return !p ? -errno : ul_path_read_buffer(pc, buf, bufsz, p);
 }
 
+/* fscanf() like for data in cache */
+static int path_cache_vscanf(struct path_cache_entry *ce, const char *fmt, va_list ap)
+{
+	if (!ce->data) {
+		errno = ce->errsv;
+		return ce->errsv ? -ce->errsv : -EINVAL;	/* read or open error */
+	}
+	return vsscanf(ce->data, fmt, ap);
+}
+
 int ul_path_scanf(struct path_cxt *pc, const char *path, const char *fmt, ...)
 {
+	struct path_cache_entry *ce = path_cache_get(pc, path);
 	FILE *f;
 	va_list fmt_ap;
 	int rc;
 
+	if (ce) {
+		DBG(CXT, ul_debug(" sscanf [%s] '%s' [cached]", fmt, path));
+
+		va_start(fmt_ap, fmt);
+		rc = path_cache_vscanf(ce, fmt, fmt_ap);
+		va_end(fmt_ap);
+		return rc;
+	}
+
 	f = ul_path_fopen(pc, "r" UL_CLOEXECSTR, path);
 	if (!f)
-		return -EINVAL;
+		return errno ? -errno : -EINVAL;	/* as from the cache */
 
 	DBG(CXT, ul_debug(" fscanf [%s] '%s'", fmt, path));
 
@@ -705,14 +878,28 @@ int ul_path_scanf(struct path_cxt *pc, const char *path, const char *fmt, ...)
 
 int ul_path_scanff(struct path_cxt *pc, const char *path, va_list ap, const char *fmt, ...)
 {
+	struct path_cache_entry *ce;
+	const char *p;
 	FILE *f;
 	va_list fmt_ap;
 	int rc;
 
-	f = ul_path_vfopenf(pc, "r" UL_CLOEXECSTR, path, ap);
-	if (!f)
+	p = ul_path_mkpath(pc, path, ap);
+	if (!p)
 		return -EINVAL;
 
+	ce = path_cache_get(pc, p);
+	if (ce) {
+		va_start(fmt_ap, fmt);
+		rc = path_cache_vscanf(ce, fmt, fmt_ap);
+		va_end(fmt_ap);
+		return rc;
+	}
+
+	f = ul_path_fopen(pc, "r" UL_CLOEXECSTR, p);
+	if (!f)
+		return errno ? -errno : -EINVAL;
+
 	va_start(fmt_ap, fmt);
 	rc = vfscanf(f, fmt, fmt_ap);
 	va_end(fmt_ap);
@@ -845,12 +1032,22 @@ int ul_path_readf_majmin(struct path_cxt *pc, dev_t *res, const char *path, ...)
 	return !p ? -errno : ul_path_read_majmin(pc, res, p);
 }
 
+/*
+ * Opens @path for write and drops the cache, the write usually modifies
+ * also another attributes.
+ */
+static int path_open_write(struct path_cxt *pc, const char *path)
+{
+	ul_path_drop_cache(pc);
+	return ul_path_open(pc, O_WRONLY|O_CLOEXEC, path);
+}
+
 int ul_path_write_string(struct path_cxt *pc, const char *str, const char *path)
 {
 	int rc, errsv;
 	int fd;
 
-	fd = ul_path_open(pc, O_WRONLY|O_CLOEXEC, path);
+	fd = path_open_write(pc, path);
 	if (fd < 0)
 		return -errno;
 
@@ -880,7 +1077,7 @@ int ul_path_write_s64(struct path_cxt *pc, int64_t num, const char *path)
 	int rc, errsv;
 	int fd, len;
 
-	fd = ul_path_open(pc, O_WRONLY|O_CLOEXEC, path);
+	fd = path_open_write(pc, path);
 	if (fd < 0)
 		return -errno;
 
@@ -902,7 +1099,7 @@ int ul_path_write_u64(struct path_cxt *pc, uint64_t num, const char *path)
 	int rc, errsv;
 	int fd, len;
 
-	fd = ul_path_open(pc, O_WRONLY|O_CLOEXEC, path);
+	fd = path_open_write(pc, path);
 	if (fd < 0)
 		return -errno;
 
@@ -983,19 +1180,39 @@ static int ul_path_cpuparse(struct path_cxt *pc, cpu_set_t **set, int maxcpus, i
 	FILE *f;
 	size_t setsize, len = maxcpus * 7;
 	char buf[len];
+	struct path_cache_entry *ce;
+	const char *p;
 	int rc;
 
 	*set = NULL;
 
-	f = ul_path_vfopenf(pc, "r" UL_CLOEXECSTR, path, ap);
-	if (!f)
+	p = ul_path_mkpath(pc, path, ap);
+	if (!p)
 		return -errno;
 
-	rc = fgets(buf, len, f) == NULL ? -errno : 0;
-	fclose(f);
+	ce = path_cache_get(pc, p);
+	if (ce) {
+		char *end;
 
-	if (rc)
-		return rc;
+		if (!ce->data)
+			return -ce->errsv;
+		if (!ce->datasz)
+			return -EINVAL;
+		xstrncpy(buf, ce->data, len);
+		end = strchr(buf, '\n');
+		if (end)
+			*(end + 1) = '\0';	/* like fgets() */
+	} else {
+		f = ul_path_fopen(pc, "r" UL_CLOEXECSTR, p);
+		if (!f)
+			return -errno;
+
+		rc = fgets(buf, len, f) == NULL ? -errno : 0;
+		fclose(f);
+
+		if (rc)
+			return rc;
+	}
 
 	len = strlen(buf);
 	if (buf[len - 1] == '\n')
@@ -1053,6 +1270,7 @@ static void __attribute__((__noreturn__)) usage(void)
 {
 	fprintf(stdout, " %s [options] <dir> <command>\n\n", program_invocation_short_name);
 	fputs(" -p, --prefix <dir>      redirect hardcoded paths to <dir>\n", stdout);
+	fputs(" -P, --prefetch <list>   read comma separated list of files in advance\n", stdout);
 
 	fputs(" Commands:\n", stdout);
 	fputs(" read-u64 <file>            read uint64_t from file\n", stdout);
@@ -1062,6 +1280,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(" read-string <file>         read string  from file\n", stdout);
 	fputs(" read-majmin <file>         read devno from file\n", stdout);
 	fputs(" read-link <file>           read symlink\n", stdout);
+	fputs(" scanf <file>               scan int from file, print return code\n", stdout);
 	fputs(" write-string <file> <str>  write string from file\n", stdout);
 	fputs(" write-u64 <file> <str>     write uint64_t from file\n", stdout);
 
@@ -1072,19 +1291,24 @@ int main(int argc, char *argv[])
 {
 	int c;
 	const char *prefix = NULL, *dir, *file, *command;
+	char *prefetch = NULL;
 	struct path_cxt *pc = NULL;
 
 	static const struct option longopts[] = {
 		{ "prefix",	1, NULL, 'p' },
+		{ "prefetch",	1, NULL, 'P' },
 		{ "help",       0, NULL, 'h' },
 		{ NULL, 0, NULL, 0 },
 	};
 
-	while((c = getopt_long(argc, argv, "p:h", longopts, NULL)) != -1) {
+	while((c = getopt_long(argc, argv, "p:P:h", longopts, NULL)) != -1) {
 		switch(c) {
 		case 'p':
 			prefix = optarg;
 			break;
+		case 'P':
+			prefetch = optarg;
+			break;
 		case 'h':
 			usage();
 			break;
@@ -1104,6 +1328,18 @@ int main(int argc, char *argv[])
 		err(EXIT_FAILURE, "failed to initialize path context");
 	if (prefix)
 		ul_path_set_prefix(pc, prefix);
+	if (prefetch) {
+		const char *files[32];
+		size_t n = 0;
+		char *tk, *save = NULL;
+
+		for (tk = strtok_r(prefetch, ",", &save); tk && n < ARRAY_SIZE(files);
+		     tk = strtok_r(NULL, ",", &save))
+			files[n++] = tk;
+
+		if (ul_path_prefetch(pc, files, n) != 0)
+			err(EXIT_FAILURE, "prefetch failed");
+	}
 
 	if (optind == argc)
 		errx(EXIT_FAILURE, "<command> not defined");
@@ -1214,6 +1450,19 @@ int main(int argc, char *argv[])
 			err(EXIT_FAILURE, "readf symlink failed");
 		printf("readf: %s: %s\n", file, res);
 
+	} else if (strcmp(command, "scanf") == 0) {
+		int res = 0, rc;
+
+		if (optind == argc)
+			errx(EXIT_FAILURE, "<file> not defined");
+		file = argv[optind++];
+
+		rc = ul_path_scanf(pc, file, "%d", &res);
+		printf("scanf: %s: rc=%d", file, rc);
+		if (rc == 1)
+			printf(" value=%d", res);
+		putchar('\n');
+
 	} else if (strcmp(command, "write-string") == 0) {
 		char *str;
 
@@ -0,0 +1,582 @@
+/* SPDX-License-Identifier: LGPL-2.1-or-later */
+/*
+ * This file is part of libmount from util-linux project.
+ *
+ * libmount is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ *
+ * Synthetic benchmark for libmount tables. It generates mountinfo, fstab and
+ * utab files shaped like systemd and Kubernetes nodes (container rootfs
+ * overlays, secret tmpfs volumes, network namespaces, CSI mounts, snaps, ...)
+ * and measures parsing, lookups, diff, is-mounted checks, tree iteration and
+ * options string routines.
+ *
+ * The results are in operations (entries, lookups, ...) per second. The
+ * number of allocations is counted on glibc only.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <limits.h>
+
+#include "mountP.h"
+#include "closestream.h"
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+/*
+ * Count allocations; glibc allows to replace malloc() and friends, the
+ * original implementation is still available by __libc_ prefixed symbols.
+ * (Don't do it with ASan which replaces the allocator too.)
+ */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static size_t nallocs;
+
+void *malloc(size_t size)
+{
+	nallocs++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	nallocs++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	nallocs++;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+# define get_nallocs()	nallocs
+#else
+# define get_nallocs()	((size_t) 0)
+#endif /* __GLIBC__ && !__SANITIZE_ADDRESS__ */
+
+struct bench_files {
+	char	mountinfo[PATH_MAX];
+	char	mountinfo2[PATH_MAX];	/* mountinfo after some changes, for diff */
+	char	fstab[PATH_MAX];
+	char	utab[PATH_MAX];
+};
+
+struct bench_stat {
+	const char	*name;
+	struct timespec	start;
+	size_t		allocs;
+};
+
+static void bench_files_init(struct bench_files *bf, const char *dir)
+{
+	snprintf(bf->mountinfo, sizeof(bf->mountinfo), "%s/mountinfo", dir);
+	snprintf(bf->mountinfo2, sizeof(bf->mountinfo2), "%s/mountinfo2", dir);
+	snprintf(bf->fstab, sizeof(bf->fstab), "%s/fstab", dir);
+	snprintf(bf->utab, sizeof(bf->utab), "%s/utab", dir);
+}
+
+static void bench_start(struct bench_stat *st, const char *name)
+{
+	st->name = name;
+	st->allocs = get_nallocs();
+	clock_gettime(CLOCK_MONOTONIC, &st->start);
+}
+
+static void bench_end(struct bench_stat *st, size_t ops)
+{
+	struct timespec end;
+	double sec;
+	size_t allocs = get_nallocs() - st->allocs;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	sec = (end.tv_sec - st->start.tv_sec) +
+	      (end.tv_nsec - st->start.tv_nsec) / 1000000000.0;
+
+	printf("%-24s %10zu ops %10.3f s %14.0f ops/s %10.1f allocs/op\n",
+			st->name, ops, sec,
+			sec > 0 ? ops / sec : 0.0,
+			ops ? (double) allocs / ops : 0.0);
+}
+
+/*
+ * Generator
+ */
+static unsigned int bench_rand(unsigned int *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return (*seed >> 16) & 0x7fff;
+}
+
+static void bench_uuid(unsigned int *seed, char *buf, size_t bufsz)
+{
+	snprintf(buf, bufsz, "%04x%04x-%04x-%04x-%04x-%04x%04x%04x",
+			bench_rand(seed), bench_rand(seed), bench_rand(seed),
+			bench_rand(seed), bench_rand(seed), bench_rand(seed),
+			bench_rand(seed), bench_rand(seed));
+}
+
+/* the basic systemd node */
+static const char *bench_base[] = {
+	"2 0 253:1 / / rw,relatime shared:1 - ext4 /dev/vda1 rw",
+	"3 2 0:5 / /dev rw,nosuid shared:2 - devtmpfs devtmpfs rw,size=8167644k,nr_inodes=2041911,mode=755",
+	"4 2 0:21 / /proc rw,nosuid,nodev,noexec,relatime shared:12 - proc proc rw",
+	"5 2 0:20 / /sys rw,nosuid,nodev,noexec,relatime shared:7 - sysfs sysfs rw",
+	"6 2 0:22 / /run rw,nosuid,nodev shared:14 - tmpfs tmpfs rw,size=3273696k,nr_inodes=819200,mode=755",
+	"7 5 0:26 / /sys/fs/cgroup rw,nosuid,nodev,noexec,relatime shared:4 - cgroup2 cgroup2 rw,nsdelegate,memory_recursiveprot",
+	"8 3 0:23 / /dev/shm rw,nosuid,nodev shared:3 - tmpfs tmpfs rw,size=8184236k,nr_inodes=1048576",
+	"9 3 0:24 / /dev/pts rw,nosuid,noexec,relatime shared:5 - devpts devpts rw,gid=5,mode=620,ptmxmode=000",
+	"10 2 253:2 / /var rw,relatime shared:30 - xfs /dev/vda2 rw,attr2,inode64,logbufs=8,logbsize=32k,noquota",
+	"11 2 253:3 / /boot rw,relatime shared:31 - ext4 /dev/vda3 rw",
+	"12 10 253:4 / /var/lib/containerd rw,relatime shared:32 - xfs /dev/vdb1 rw,attr2,inode64,prjquota",
+	"13 10 253:5 / /var/lib/kubelet rw,relatime shared:33 - xfs /dev/vdb2 rw,attr2,inode64,noquota",
+	"14 2 0:30 / /tmp rw,nosuid,nodev shared:18 - tmpfs tmpfs rw,size=8184236k,nr_inodes=1048576"
+};
+
+#define BENCH_ID_ROOT		2
+#define BENCH_ID_RUN		6
+#define BENCH_ID_KUBELET	13
+#define BENCH_ID_FIRST		(BENCH_ID_ROOT + (int) ARRAY_SIZE(bench_base))
+
+static int bench_generate(const char *dir, size_t nents)
+{
+	struct bench_files bf;
+	FILE *mi = NULL, *mi2 = NULL, *fstab = NULL, *utab = NULL;
+	unsigned int seed = 42;
+	size_t i;
+	int rc = -errno;
+
+	bench_files_init(&bf, dir);
+
+	mi = fopen(bf.mountinfo, "w" UL_CLOEXECSTR);
+	mi2 = fopen(bf.mountinfo2, "w" UL_CLOEXECSTR);
+	fstab = fopen(bf.fstab, "w" UL_CLOEXECSTR);
+	utab = fopen(bf.utab, "w" UL_CLOEXECSTR);
+	if (!mi || !mi2 || !fstab || !utab) {
+		rc = -errno;
+		goto done;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bench_base); i++) {
+		fprintf(mi, "%s\n", bench_base[i]);
+		fprintf(mi2, "%s\n", bench_base[i]);
+	}
+	fputs("/dev/vda1 / ext4 defaults 1 1\n"
+	      "/dev/vda2 /var xfs defaults 1 2\n"
+	      "/dev/vda3 /boot ext4 defaults 1 2\n"
+	      "/dev/vdb1 /var/lib/containerd xfs defaults,prjquota 1 2\n"
+	      "/dev/vdb2 /var/lib/kubelet xfs defaults 1 2\n"
+	      "tmpfs /tmp tmpfs defaults,nosuid,nodev 0 0\n", fstab);
+
+	for (i = ARRAY_SIZE(bench_base); i < nents; i++) {
+		char pod[37], line[1024];
+		int id = BENCH_ID_FIRST + i, parent = BENCH_ID_KUBELET;
+		unsigned int minor = 100 + i;
+		const char *fmt_fstab = NULL, *fmt_utab = NULL;
+		char src[64], tgt[256], type[32];
+
+		bench_uuid(&seed, pod, sizeof(pod));
+
+		switch (i % 8) {
+		case 0:		/* secret volume */
+		case 1:
+			snprintf(src, sizeof(src), "tmpfs");
+			snprintf(tgt, sizeof(tgt), "/var/lib/kubelet/pods/%s/volumes/kubernetes.io~projected/kube-api-access-%05zu", pod, i);
+			snprintf(type, sizeof(type), "tmpfs");
+			snprintf(line, sizeof(line), "%d %d 0:%u / %s rw,relatime shared:%u - %s %s rw,size=%uk,inode64",
+					id, parent, minor, tgt, minor, type, src, 1024 + bench_rand(&seed));
+			break;
+		case 2:		/* container rootfs */
+			parent = BENCH_ID_RUN;
+			snprintf(src, sizeof(src), "overlay");
+			snprintf(tgt, sizeof(tgt), "/run/containerd/io.containerd.runtime.v2.task/k8s.io/%s/rootfs", pod);
+			snprintf(type, sizeof(type), "overlay");
+			snprintf(line, sizeof(line), "%d %d 0:%u / %s rw,relatime shared:%u - %s %s rw,"
+					"lowerdir=/var/lib/containerd/io.containerd.snapshotter.v1.overlayfs/snapshots/%u/fs:"
+					"/var/lib/containerd/io.containerd.snapshotter.v1.overlayfs/snapshots/%u/fs,"
+					"upperdir=/var/lib/containerd/io.containerd.snapshotter.v1.overlayfs/snapshots/%zu/fs,"
+					"workdir=/var/lib/containerd/io.containerd.snapshotter.v1.overlayfs/snapshots/%zu/work",
+					id, parent, minor, tgt, minor, type, src,
+					bench_rand(&seed), bench_rand(&seed), i, i);
+			break;
+		case 3:		/* sandbox shm */
+			parent = BENCH_ID_RUN;
+			snprintf(src, sizeof(src), "shm");
+			snprintf(tgt, sizeof(tgt), "/run/containerd/io.containerd.grpc.v1.cri/sandboxes/%s/shm", pod);
+			snprintf(type, sizeof(type), "tmpfs");
+			snprintf(line, sizeof(line), "%d %d 0:%u / %s rw,nosuid,nodev,noexec,relatime shared:%u - %s %s rw,size=65536k,inode64",
+					id, parent, minor, tgt, minor, type, src);
+			break;
+		case 4:		/* network namespace */
+			parent = BENCH_ID_RUN;
+			snprintf(src, sizeof(src), "nsfs");
+			snprintf(tgt, sizeof(tgt), "/run/netns/cni-%s", pod);
+			snprintf(type, sizeof(type), "nsfs");
+			snprintf(line, sizeof(line), "%d %d 0:4 net:[40265%05zu] %s rw shared:%u - %s %s rw",
+					id, parent, i, tgt, minor, type, src);
+			break;
+		case 5:		/* CSI volume */
+			snprintf(src, sizeof(src), "/dev/sd%c%c", 'a' + (int) (i / 26 % 26), 'a' + (int) (i % 26));
+			snprintf(tgt, sizeof(tgt), "/var/lib/kubelet/pods/%s/volumes/kubernetes.io~csi/pvc-%s/mount", pod, pod);
+			snprintf(type, sizeof(type), "ext4");
+			snprintf(line, sizeof(line), "%d %d 8:%u / %s rw,relatime shared:%u - %s %s rw,stripe=16",
+					id, parent, minor, tgt, minor, type, src);
+			fmt_fstab = "%s %s %s defaults,nofail 0 2\n";
+			fmt_utab = "SRC=%s TARGET=%s ROOT=/ OPTS=_netdev,x-kubernetes.io/csi\n";
+			break;
+		case 6:		/* user runtime dir */
+			parent = BENCH_ID_RUN;
+			snprintf(src, sizeof(src), "tmpfs");
+			snprintf(tgt, sizeof(tgt), "/run/user/%zu", 1000 + i);
+			snprintf(type, sizeof(type), "tmpfs");
+			snprintf(line, sizeof(line), "%d %d 0:%u / %s rw,nosuid,nodev,relatime shared:%u - %s %s rw,size=1636844k,nr_inodes=409211,mode=700,uid=%zu,gid=%zu,inode64",
+					id, parent, minor, tgt, minor, type, src, 1000 + i, 1000 + i);
+			fmt_fstab = "%s %s %s defaults,mode=700 0 0\n";
+			break;
+		default:	/* snap */
+			parent = BENCH_ID_ROOT;
+			snprintf(src, sizeof(src), "/dev/loop%zu", i);
+			snprintf(tgt, sizeof(tgt), "/snap/app%zu/%u", i, bench_rand(&seed));
+			snprintf(type, sizeof(type), "squashfs");
+			snprintf(line, sizeof(line), "%d %d 7:%zu / %s ro,nodev,relatime shared:%u - %s %s ro,errors=continue,threads=single",
+					id, parent, i, tgt, minor, type, src);
+			fmt_fstab = "%s %s %s ro,nodev,x-gdu.hide 0 0\n";
+			fmt_utab = "SRC=%s TARGET=%s ROOT=/ OPTS=x-gdu.hide\n";
+			break;
+		}
+
+		fprintf(mi, "%s\n", line);
+
+		/* remove 1% of the mounts, remount ro another 1% */
+		if (i % 100 == 17)
+			;
+		else if (i % 100 == 42) {
+			char *p = strstr(line, " rw,");
+			if (p)
+				memcpy(p, " ro,", 4);
+			fprintf(mi2, "%s\n", line);
+		} else
+			fprintf(mi2, "%s\n", line);
+
+		if (fmt_fstab)
+			fprintf(fstab, fmt_fstab, src, tgt, type);
+		if (fmt_utab)
+			fprintf(utab, fmt_utab, src, tgt);
+	}
+
+	/* new mounts in the second mountinfo */
+	for (i = 0; i < nents / 100; i++)
+		fprintf(mi2, "%zu %d 0:%zu / /run/netns/cni-new-%zu rw shared:%zu - nsfs nsfs rw\n",
+				BENCH_ID_FIRST + nents + i, BENCH_ID_RUN,
+				100 + nents + i, i, 100 + nents + i);
+
+	/* not mounted fstab entries */
+	for (i = 0; i < nents / 100 + 1; i++)
+		fprintf(fstab, "/dev/vdc%zu /srv/data%zu ext4 defaults,noauto 0 2\n", i, i);
+
+	rc = 0;
+done:
+	if (mi && close_stream(mi) != 0 && !rc)
+		rc = -errno;
+	if (mi2 && close_stream(mi2) != 0 && !rc)
+		rc = -errno;
+	if (fstab && close_stream(fstab) != 0 && !rc)
+		rc = -errno;
+	if (utab && close_stream(utab) != 0 && !rc)
+		rc = -errno;
+	return rc;
+}
+
+/*
+ * Benchmarks
+ */
+static size_t bench_parse(const char *name, const char *filename, int fmt, int loops)
+{
+	struct bench_stat st;
+	size_t ops = 0;
+	int i;
+
+	bench_start(&st, name);
+	for (i = 0; i < loops; i++) {
+		struct libmnt_table *tb = __mnt_new_table_from_file(filename, fmt, 0);
+
+		if (!tb)
+			return 0;
+		ops += mnt_table_get_nents(tb);
+		mnt_unref_table(tb);
+	}
+	bench_end(&st, ops);
+	return ops;
+}
+
+static void bench_find(struct libmnt_table *tb, struct libmnt_table *fstab, int loops)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	struct bench_stat st;
+	size_t ops = 0;
+	int i, idx;
+
+	bench_start(&st, "find-target");
+	for (i = 0; i < loops; i++) {
+		mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+		while (mnt_table_next_fs(fstab, &itr, &fs) == 0) {
+			mnt_table_find_target(tb, mnt_fs_get_target(fs), MNT_ITER_BACKWARD);
+			ops++;
+		}
+	}
+	bench_end(&st, ops);
+
+	for (idx = 0; idx < 2; idx++) {
+		mnt_table_enable_index(tb, idx);
+
+		bench_start(&st, idx ? "find-source-index" : "find-source");
+		for (ops = 0, i = 0; i < loops; i++) {
+			mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+			while (mnt_table_next_fs(fstab, &itr, &fs) == 0) {
+				mnt_table_find_source(tb, mnt_fs_get_source(fs), MNT_ITER_BACKWARD);
+				ops++;
+			}
+		}
+		bench_end(&st, ops);
+	}
+	mnt_table_enable_index(tb, 0);
+}
+
+static void bench_is_mounted(struct libmnt_table *tb, struct libmnt_table *fstab, int loops)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	struct bench_stat st;
+	size_t ops;
+	int i, idx;
+
+	for (idx = 0; idx < 2; idx++) {
+		mnt_table_enable_index(tb, idx);
+
+		bench_start(&st, idx ? "is-mounted-index" : "is-mounted");
+		for (ops = 0, i = 0; i < loops; i++) {
+			mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+			while (mnt_table_next_fs(fstab, &itr, &fs) == 0) {
+				mnt_table_is_fs_mounted(tb, fs);
+				ops++;
+			}
+		}
+		bench_end(&st, ops);
+	}
+	mnt_table_enable_index(tb, 0);
+}
+
+static size_t walk_children(struct libmnt_table *tb, struct libmnt_fs *parent)
+{
+	struct libmnt_iter *itr = mnt_new_iter(MNT_ITER_FORWARD);
+	struct libmnt_fs *fs;
+	size_t n = 0;
+
+	if (!itr)
+		return 0;
+	while (mnt_table_next_child_fs(tb, itr, parent, &fs) == 0)
+		n += 1 + walk_children(tb, fs);
+	mnt_free_iter(itr);
+	return n;
+}
+
+static void bench_tree(struct libmnt_table *tb, int loops)
+{
+	struct bench_stat st;
+	size_t ops = 0;
+	int i;
+
+	bench_start(&st, "tree-walk");
+	for (i = 0; i < loops; i++) {
+		struct libmnt_fs *root;
+
+		if (mnt_table_get_root_fs(tb, &root) != 0)
+			break;
+		ops += 1 + walk_children(tb, root);
+	}
+	bench_end(&st, ops);
+}
+
+static void bench_diff(const char *old, const char *new, int loops)
+{
+	struct libmnt_table *tb_old, *tb_new;
+	struct libmnt_tabdiff *df;
+	struct bench_stat st;
+	size_t ops = 0;
+	int i;
+
+	tb_old = mnt_new_table_from_file(old);
+	tb_new = mnt_new_table_from_file(new);
+	df = mnt_new_tabdiff();
+	if (!tb_old || !tb_new || !df)
+		goto done;
+
+	bench_start(&st, "diff");
+	for (i = 0; i < loops; i++) {
+		if (mnt_diff_tables(df, tb_old, tb_new) < 0)
+			break;
+		ops += mnt_table_get_nents(tb_new);
+	}
+	bench_end(&st, ops);
+done:
+	mnt_free_tabdiff(df);
+	mnt_unref_table(tb_old);
+	mnt_unref_table(tb_new);
+}
+
+static void bench_optstr(struct libmnt_table *tb, int loops)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	struct bench_stat st;
+	size_t ops = 0;
+	int i;
+
+	bench_start(&st, "optstr");
+	for (i = 0; i < loops; i++) {
+		mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+		while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+			char *o = strdup(mnt_fs_get_options(fs));
+			char *u = NULL, *v = NULL, *f = NULL, *val;
+			size_t valsz;
+
+			if (!o)
+				break;
+			mnt_optstr_get_option(o, "size", &val, &valsz);
+			mnt_optstr_set_option(&o, "size", "1024k");
+			mnt_optstr_append_option(&o, "x-bench", "1");
+			mnt_optstr_remove_option(&o, "relatime");
+			mnt_split_optstr(o, &u, &v, &f, 0, 0);
+
+			free(o);
+			free(u);
+			free(v);
+			free(f);
+			ops++;
+		}
+	}
+	bench_end(&st, ops);
+}
+
+static int bench_run(const char *dir, int loops)
+{
+	struct bench_files bf;
+	struct libmnt_table *tb, *fstab;
+
+	bench_files_init(&bf, dir);
+
+	if (!bench_parse("parse-mountinfo", bf.mountinfo, MNT_FMT_MOUNTINFO, loops))
+		return -EINVAL;
+	bench_parse("parse-fstab", bf.fstab, MNT_FMT_FSTAB, loops);
+	bench_parse("parse-utab", bf.utab, MNT_FMT_UTAB, loops);
+
+	tb = mnt_new_table_from_file(bf.mountinfo);
+	fstab = mnt_new_table_from_file(bf.fstab);
+	if (!tb || !fstab) {
+		mnt_unref_table(tb);
+		mnt_unref_table(fstab);
+		return -EINVAL;
+	}
+
+	bench_find(tb, fstab, loops);
+	bench_is_mounted(tb, fstab, loops);
+	bench_tree(tb, loops);
+	bench_diff(bf.mountinfo, bf.mountinfo2, loops);
+	bench_optstr(tb, loops);
+
+	mnt_unref_table(tb);
+	mnt_unref_table(fstab);
+	return 0;
+}
+
+static int bench_get_args(int argc, char *argv[], size_t *nents, int *loops)
+{
+	if (nents) {
+		unsigned long n = strtoul(argv[1], NULL, 10);
+
+		if (n < ARRAY_SIZE(bench_base))
+			n = ARRAY_SIZE(bench_base);
+		*nents = n;
+	}
+	*loops = argc > 2 ? atoi(argv[2]) : 1;
+	if (*loops < 1)
+		*loops = 1;
+	return 0;
+}
+
+static int test_generate(struct libmnt_test *ts, int argc, char *argv[])
+{
+	size_t nents;
+
+	if (argc < 3)
+		return -EINVAL;
+	nents = strtoul(argv[2], NULL, 10);
+	if (nents < ARRAY_SIZE(bench_base))
+		nents = ARRAY_SIZE(bench_base);
+	return bench_generate(argv[1], nents);
+}
+
+static int test_bench(struct libmnt_test *ts, int argc, char *argv[])
+{
+	int loops;
+
+	if (argc < 2)
+		return -EINVAL;
+	bench_get_args(argc, argv, NULL, &loops);
+	return bench_run(argv[1], loops);
+}
+
+static int test_all(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct bench_files bf;
+	char dir[] = "/tmp/libmount-bench-XXXXXX";
+	size_t nents;
+	int loops, rc;
+
+	if (argc < 2)
+		return -EINVAL;
+	bench_get_args(argc, argv, &nents, &loops);
+
+	if (!mkdtemp(dir))
+		return -errno;
+
+	printf("entries: %zu, loops: %d\n", nents, loops);
+
+	rc = bench_generate(dir, nents);
+	if (!rc)
+		rc = bench_run(dir, loops);
+
+	bench_files_init(&bf, dir);
+	unlink(bf.mountinfo);
+	unlink(bf.mountinfo2);
+	unlink(bf.fstab);
+	unlink(bf.utab);
+	rmdir(dir);
+	return rc;
+}
+
+int main(int argc, char *argv[])
+{
+	struct libmnt_test tss[] = {
+	{ "--generate", test_generate, "<dir> <nents>   generate mountinfo, fstab and utab" },
+	{ "--bench",    test_bench,    "<dir> [<loops>] run benchmarks on generated files" },
+	{ "--all",      test_all,      "<nents> [<loops>] generate to temporary directory and run benchmarks" },
+	{ NULL }
+	};
+
+	return mnt_run_test(tss, argc, argv);
+}
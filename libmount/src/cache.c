@@ -31,6 +31,7 @@
 #include <blkid.h>
 
 #include "canonicalize.h"
+#include "fnv.h"
 #include "mountP.h"
 #include "loopdev.h"
 #include "strutils.h"
@@ -44,6 +45,8 @@
 #define MNT_CACHE_ISPATH	(1 << 2) /* entry is path */
 #define MNT_CACHE_TAGREAD	(1 << 3) /* tag read by mnt_cache_read_tags() */
 
+#define MNT_CACHE_HASHSZ	256	/* initial hash size, must be power of 2 */
+
 /* path cache entry */
 struct mnt_cache_entry {
 	char			*key;	/* search key (e.g. uncanonicalized path) */
@@ -51,12 +54,26 @@ struct mnt_cache_entry {
 	int			flag;
 };
 
+/*
+ * Open-addressing hash index to the cache entries. The slot contains
+ * (entry index + 1), zero means an unused slot.
+ */
+struct mnt_cache_hash {
+	size_t			*slots;
+	size_t			nslots;
+	size_t			nused;
+};
+
 struct libmnt_cache {
 	struct mnt_cache_entry	*ents;
 	size_t			nents;
 	size_t			nallocs;
 	int			refcount;
 
+	struct mnt_cache_hash	paths;	/* ISPATH entries by key */
+	struct mnt_cache_hash	tags;	/* ISTAG entries by "NAME\0VALUE" */
+	struct mnt_cache_hash	devs;	/* ISTAG entries by devname (value) */
+
 	/* blkid_evaluate_tag() works in two ways:
 	 *
 	 * 1/ all tags are evaluated by udev /dev/disk/by-* symlinks,
@@ -109,6 +126,9 @@ void mnt_free_cache(struct libmnt_cache *cache)
 		free(e->key);
 	}
 	free(cache->ents);
+	free(cache->paths.slots);
+	free(cache->tags.slots);
+	free(cache->devs.slots);
 	if (cache->bc)
 		blkid_put_cache(cache->bc);
 	free(cache);
@@ -171,18 +191,130 @@ int mnt_cache_set_targets(struct libmnt_cache *cache,
 }
 
 
+/*
+ * The paths are compared by streq_paths(), so the hash has to ignore
+ * duplicate and trailing slashes.
+ */
+unsigned int mnt_hash_path(const char *path)
+{
+	uint64_t h = UL_FNV64_INIT;
+	const char *p;
+
+	for (p = path; p && *p; p++) {
+		if (*p == '/') {
+			while (*(p + 1) == '/')
+				p++;
+			if (!*(p + 1))
+				break;		/* trailing slash */
+		}
+		h = ul_fnv1a64_add(h, (unsigned char) *p);
+	}
+	return ul_hash_mix64(h);
+}
+
+static inline unsigned int hash_tag(const char *token, const char *value)
+{
+	uint64_t h = ul_fnv1a64_str(UL_FNV64_INIT, token);
+
+	h = ul_fnv1a64_add(h, 0);	/* token and value separator */
+	return ul_hash_mix64(ul_fnv1a64_str(h, value));
+}
+
+static inline unsigned int hash_devname(const char *devname)
+{
+	return ul_hash_mix64(ul_fnv1a64_str(UL_FNV64_INIT, devname));
+}
+
+static unsigned int cache_entry_hash(struct libmnt_cache *cache,
+				     struct mnt_cache_hash *hs,
+				     struct mnt_cache_entry *e)
+{
+	if (hs == &cache->paths)
+		return mnt_hash_path(e->key);
+	if (hs == &cache->tags)
+		return hash_tag(e->key, e->key + strlen(e->key) + 1);
+	return hash_devname(e->value);
+}
+
+static void cache_hash_insert(struct mnt_cache_hash *hs, unsigned int h, size_t idx)
+{
+	size_t i = h & (hs->nslots - 1);
+
+	while (hs->slots[i])
+		i = (i + 1) & (hs->nslots - 1);
+	hs->slots[i] = idx + 1;
+	hs->nused++;
+}
+
+/*
+ * Makes sure there is space for one more entry in the hash. The hash is
+ * rebuilt from the first @nents entries if necessary.
+ */
+static int cache_hash_reserve(struct libmnt_cache *cache,
+			      struct mnt_cache_hash *hs, size_t nents)
+{
+	size_t i, sz;
+	size_t *slots;
+
+	/* keep load factor <= 0.5 */
+	if ((hs->nused + 1) * 2 <= hs->nslots)
+		return 0;
+
+	sz = hs->nslots ? hs->nslots * 2 : MNT_CACHE_HASHSZ;
+	slots = calloc(sz, sizeof(size_t));
+	if (!slots)
+		return -ENOMEM;
+
+	free(hs->slots);
+	hs->slots = slots;
+	hs->nslots = sz;
+	hs->nused = 0;
+
+	for (i = 0; i < nents; i++) {
+		struct mnt_cache_entry *e = &cache->ents[i];
+
+		if (hs == &cache->paths ? !(e->flag & MNT_CACHE_ISPATH)
+					: !(e->flag & MNT_CACHE_ISTAG))
+			continue;
+		cache_hash_insert(hs, cache_entry_hash(cache, hs, e), i);
+	}
+	return 0;
+}
+
+/*
+ * Iterates over entries with the same hash; @pos has to be initialized to
+ * the hash value and returns the next entry or NULL.
+ */
+static struct mnt_cache_entry *cache_hash_next(struct libmnt_cache *cache,
+			struct mnt_cache_hash *hs, size_t *pos)
+{
+	size_t idx;
+
+	if (!hs->nslots)
+		return NULL;
+
+	*pos &= (hs->nslots - 1);
+	idx = hs->slots[*pos];
+	if (!idx)
+		return NULL;
+
+	*pos = *pos + 1;
+	return &cache->ents[idx - 1];
+}
+
 /* note that the @key could be the same pointer as @value */
 static int cache_add_entry(struct libmnt_cache *cache, char *key,
 					char *value, int flag)
 {
 	struct mnt_cache_entry *e;
+	int rc;
 
 	assert(cache);
 	assert(value);
 	assert(key);
 
 	if (cache->nents == cache->nallocs) {
-		size_t sz = cache->nallocs + MNT_CACHE_CHUNKSZ;
+		size_t sz = cache->nallocs ? cache->nallocs * 2 : MNT_CACHE_CHUNKSZ;
 
 		e = realloc(cache->ents, sz * sizeof(struct mnt_cache_entry));
 		if (!e)
@@ -191,10 +323,33 @@ static int cache_add_entry(struct libmnt_cache *cache, char *key,
 		cache->nallocs = sz;
 	}
 
+	if (flag & MNT_CACHE_ISPATH)
+		rc = cache_hash_reserve(cache, &cache->paths, cache->nents);
+	else {
+		rc = cache_hash_reserve(cache, &cache->tags, cache->nents);
+		if (!rc)
+			rc = cache_hash_reserve(cache, &cache->devs, cache->nents);
+	}
+	if (rc)
+		return rc;
+
 	e = &cache->ents[cache->nents];
 	e->key = key;
 	e->value = value;
 	e->flag = flag;
+
+	if (flag & MNT_CACHE_ISPATH)
+		cache_hash_insert(&cache->paths,
+				cache_entry_hash(cache, &cache->paths, e),
+				cache->nents);
+	else {
+		cache_hash_insert(&cache->tags,
+				cache_entry_hash(cache, &cache->tags, e),
+				cache->nents);
+		cache_hash_insert(&cache->devs,
+				cache_entry_hash(cache, &cache->devs, e),
+				cache->nents);
+	}
 	cache->nents++;
 
 	DBG(CACHE, ul_debugobj(cache, "add entry [%2zd] (%s): %s: %s",
@@ -245,15 +400,14 @@ static int cache_add_tag(struct libmnt_cache *cache, const char *tagname,
  */
 static const char *cache_find_path(struct libmnt_cache *cache, const char *path)
 {
-	size_t i;
+	struct mnt_cache_entry *e;
+	size_t pos;
 
 	if (!cache || !path)
 		return NULL;
 
-	for (i = 0; i < cache->nents; i++) {
-		struct mnt_cache_entry *e = &cache->ents[i];
-		if (!(e->flag & MNT_CACHE_ISPATH))
-			continue;
+	pos = mnt_hash_path(path);
+	while ((e = cache_hash_next(cache, &cache->paths, &pos))) {
 		if (streq_paths(path, e->key))
 			return e->value;
 	}
@@ -266,18 +420,16 @@ static const char *cache_find_path(struct libmnt_cache *cache, const char *path)
 static const char *cache_find_tag(struct libmnt_cache *cache,
 			const char *token, const char *value)
 {
-	size_t i;
-	size_t tksz;
+	struct mnt_cache_entry *e;
+	size_t tksz, pos;
 
 	if (!cache || !token || !value)
 		return NULL;
 
 	tksz = strlen(token);
 
-	for (i = 0; i < cache->nents; i++) {
-		struct mnt_cache_entry *e = &cache->ents[i];
-		if (!(e->flag & MNT_CACHE_ISTAG))
-			continue;
+	pos = hash_tag(token, value);
+	while ((e = cache_hash_next(cache, &cache->tags, &pos))) {
 		if (strcmp(token, e->key) == 0 &&
 		    strcmp(value, e->key + tksz + 1) == 0)
 			return e->value;
@@ -288,16 +440,15 @@ static const char *cache_find_tag(struct libmnt_cache *cache,
 static char *cache_find_tag_value(struct libmnt_cache *cache,
 			const char *devname, const char *token)
 {
-	size_t i;
+	struct mnt_cache_entry *e;
+	size_t pos;
 
 	assert(cache);
 	assert(devname);
 	assert(token);
 
-	for (i = 0; i < cache->nents; i++) {
-		struct mnt_cache_entry *e = &cache->ents[i];
-		if (!(e->flag & MNT_CACHE_ISTAG))
-			continue;
+	pos = hash_devname(devname);
+	while ((e = cache_hash_next(cache, &cache->devs, &pos))) {
 		if (strcmp(e->value, devname) == 0 &&	/* dev name */
 		    strcmp(token, e->key) == 0)	/* tag name */
 			return e->key + strlen(token) + 1;	/* tag value */
@@ -319,7 +470,8 @@ static char *cache_find_tag_value(struct libmnt_cache *cache,
 int mnt_cache_read_tags(struct libmnt_cache *cache, const char *devname)
 {
 	blkid_probe pr;
-	size_t i, ntags = 0;
+	struct mnt_cache_entry *e;
+	size_t i, pos, ntags = 0;
 	int rc;
 	const char *tags[] = { "LABEL", "UUID", "TYPE", "PARTUUID", "PARTLABEL" };
 	const char *blktags[] = { "LABEL", "UUID", "TYPE", "PART_ENTRY_UUID", "PART_ENTRY_NAME" };
@@ -330,8 +482,8 @@ int mnt_cache_read_tags(struct libmnt_cache *cache, const char *devname)
 	DBG(CACHE, ul_debugobj(cache, "tags for %s requested", devname));
 
 	/* check if device is already cached */
-	for (i = 0; i < cache->nents; i++) {
-		struct mnt_cache_entry *e = &cache->ents[i];
+	pos = hash_devname(devname);
+	while ((e = cache_hash_next(cache, &cache->devs, &pos))) {
 		if (!(e->flag & MNT_CACHE_TAGREAD))
 			continue;
 		if (strcmp(e->value, devname) == 0)
@@ -826,12 +978,98 @@ static int test_read_tags(struct libmnt_test *ts, int argc, char *argv[])
 
 }
 
+/*
+ * Reads commands from stdin and uses the cache hash indexes directly, so it
+ * does not depend on devices and paths on the system:
+ *
+ *	path <key> <value>		add path entry
+ *	tag <name> <value> <devname>	add tag entry
+ *	fill <num>			add /fill/<n> -> /real/<n> path entries
+ *	find-path <path>
+ *	find-tag <name> <value>
+ *	find-value <devname> <name>
+ */
+static int test_index(struct libmnt_test *ts, int argc, char *argv[])
+{
+	char line[BUFSIZ];
+	struct libmnt_cache *cache;
+	int rc = 0;
+
+	cache = mnt_new_cache();
+	if (!cache)
+		return -ENOMEM;
+
+	while (rc == 0 && fgets(line, sizeof(line), stdin)) {
+		char *cmd, *a, *b, *c;
+		const char *res = NULL;
+
+		cmd = strtok(line, " \n");
+		a = strtok(NULL, " \n");
+		b = strtok(NULL, " \n");
+		c = strtok(NULL, " \n");
+		if (!cmd || !a)
+			continue;
+
+		if (strcmp(cmd, "path") == 0 && b) {
+			char *key = strdup(a), *val = strdup(b);
+
+			rc = key && val ? cache_add_entry(cache, key, val,
+						MNT_CACHE_ISPATH) : -ENOMEM;
+			if (rc) {
+				free(key);
+				free(val);
+			}
+			continue;
+		} else if (strcmp(cmd, "tag") == 0 && c) {
+			char *dev = strdup(c);
+
+			rc = dev ? cache_add_tag(cache, a, b, dev, 0) : -ENOMEM;
+			if (rc)
+				free(dev);
+			continue;
+		} else if (strcmp(cmd, "fill") == 0) {
+			int i, n = atoi(a);
+
+			for (i = 0; rc == 0 && i < n; i++) {
+				char *key = NULL, *val = NULL;
+
+				if (asprintf(&key, "/fill/%d", i) < 0 ||
+				    asprintf(&val, "/real/%d", i) < 0)
+					rc = -ENOMEM;
+				else
+					rc = cache_add_entry(cache, key, val,
+							MNT_CACHE_ISPATH);
+				if (rc) {
+					free(key);
+					free(val);
+				}
+			}
+			continue;
+		} else if (strcmp(cmd, "find-path") == 0)
+			res = cache_find_path(cache, a);
+		else if (strcmp(cmd, "find-tag") == 0 && b)
+			res = cache_find_tag(cache, a, b);
+		else if (strcmp(cmd, "find-value") == 0 && b)
+			res = cache_find_tag_value(cache, a, b);
+		else {
+			fprintf(stderr, "unknown command '%s'\n", cmd);
+			rc = -EINVAL;
+			break;
+		}
+		printf("%s %s%s%s : %s\n", cmd, a, b ? " " : "", b ? b : "",
+				res ? res : "(null)");
+	}
+	mnt_unref_cache(cache);
+	return rc;
+}
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test ts[] = {
 		{ "--resolve-path", test_resolve_path, "  resolve paths from stdin" },
 		{ "--resolve-spec", test_resolve_spec, "  evaluate specs from stdin" },
 		{ "--read-tags", test_read_tags,       "  read devname or TAG from stdin (\"quit\" to exit)" },
+		{ "--index", test_index,               "  add and find entries by commands from stdin" },
 		{ NULL }
 	};
 
@@ -92,6 +92,7 @@ void mnt_free_context(struct libmnt_context *cxt)
 		return;
 
 	mnt_reset_context(cxt);
+	mnt_context_finalize_batch(cxt);
 
 	free(cxt->fstype_pattern);
 	free(cxt->optstr_pattern);
@@ -1640,7 +1641,8 @@ int mnt_context_set_mflags(struct libmnt_context *cxt, unsigned long flags)
 		/*
 		 * the final mount options are already generated, refresh...
 		 */
-		return mnt_optstr_apply_flags(
+		return mnt_fs_unshare_str(cxt->fs, vfs_optstr) ? -ENOMEM :
+		       mnt_optstr_apply_flags(
 				&cxt->fs->vfs_optstr,
 				cxt->mountflags,
 				mnt_get_builtin_optmap(MNT_LINUX_MAP));
@@ -2311,6 +2313,13 @@ int mnt_context_update_tabs(struct libmnt_context *cxt)
 		mnt_update_force_rdonly(cxt->update,
 				cxt->mountflags & MS_RDONLY);
 
+	if (cxt->batch_utab) {
+		/* batch mount; see mnt_context_next_batch_mount() */
+		rc = mnt_update_queue_entry(cxt->update, cxt->batch_utab);
+		if (rc <= 0)
+			goto end;
+	}
+
 	rc = mnt_update_table(cxt->update, cxt->lock);
 
 end:
@@ -2535,7 +2544,8 @@ int mnt_context_apply_fstab(struct libmnt_context *cxt)
 	} else if (isremount && !iscmdbind) {
 
 		/* remove "bind" from fstab (or no-op if not present) */
-		mnt_optstr_remove_option(&cxt->fs->optstr, "bind");
+		if (mnt_fs_unshare_str(cxt->fs, optstr) == 0)
+			mnt_optstr_remove_option(&cxt->fs->optstr, "bind");
 	}
 	return rc;
 }
@@ -2877,6 +2887,9 @@ int mnt_context_is_fs_mounted(struct libmnt_context *cxt,
 	if (rc)
 		return rc;
 
+	/* "mount -a" checks all fstab entries against the same mtab */
+	mnt_table_enable_index(mtab, 1);
+
 	*mounted = __mnt_table_is_fs_mounted(mtab, fs,
 				mnt_context_get_target_prefix(cxt));
 
@@ -3432,12 +3445,65 @@ static int test_mountall(struct libmnt_test *ts, int argc, char *argv[])
 	return 0;
 }
 
+static int test_mountbatch(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_context *cxt;
+	struct libmnt_table *tb;
+	struct libmnt_iter *itr;
+	struct libmnt_fs *fs;
+	int mntrc, rc, idx = 1;
+
+	cxt = mnt_new_context();
+	tb = mnt_new_table();
+	itr = mnt_new_iter(MNT_ITER_FORWARD);
+
+	if (!cxt || !tb || !itr)
+		return -ENOMEM;
+
+	if (argc > 2 && !strcmp(argv[idx], "-o")) {
+		mnt_context_set_options(cxt, argv[idx + 1]);
+		idx += 2;
+	}
+	for (; idx + 1 < argc; idx += 2) {
+		fs = mnt_new_fs();
+		if (!fs)
+			return -ENOMEM;
+		mnt_fs_set_source(fs, argv[idx]);
+		mnt_fs_set_target(fs, argv[idx + 1]);
+		mnt_table_add_fs(tb, fs);
+		mnt_unref_fs(fs);
+	}
+
+	while ((rc = mnt_context_next_batch_mount(cxt, tb, itr, &fs, &mntrc)) == 0) {
+
+		const char *tgt = mnt_fs_get_target(fs);
+
+		if (!mnt_context_get_status(cxt)) {
+			if (mntrc > 0) {
+				errno = mntrc;
+				warn("%s: mount failed", tgt);
+			} else
+				warnx("%s: mount failed", tgt);
+		} else
+			printf("%s: successfully mounted\n", tgt);
+	}
+
+	if (rc < 0)
+		warnx("mtab/utab update failed");
+
+	mnt_free_iter(itr);
+	mnt_unref_table(tb);
+	mnt_free_context(cxt);
+	return rc < 0 ? rc : 0;
+}
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
 	{ "--mount",  test_mount,  "[-o <opts>] [-t <type>] <spec>|<src> <target>" },
 	{ "--umount", test_umount, "[-t <type>] [-f][-l][-r] <src>|<target>" },
 	{ "--mount-all", test_mountall,  "[-O <pattern>] [-t <pattern] mount all filesystems from fstab" },
+	{ "--mount-batch", test_mountbatch, "[-o <opts>] <src> <target> [<src> <target> ...]" },
 	{ "--flags", test_flags,   "[-o <opts>] <spec>" },
 	{ "--search-helper", test_search_helper, "<fstype>" },
 	{ NULL }};
@@ -70,7 +70,8 @@ int mnt_context_is_loopdev(struct libmnt_context *cxt)
 		    st.st_size > 1024) {
 			DBG(LOOP, ul_debugobj(cxt, "automatically enabling loop= option"));
 			cxt->user_mountflags |= MNT_MS_LOOP;
-			mnt_optstr_append_option(&cxt->fs->user_optstr, "loop", NULL);
+			if (mnt_fs_unshare_str(cxt->fs, user_optstr) == 0)
+				mnt_optstr_append_option(&cxt->fs->user_optstr, "loop", NULL);
 			return 1;
 		}
 	}
@@ -364,7 +365,8 @@ success:
 			 */
 			DBG(LOOP, ul_debugobj(cxt, "removing unnecessary loop= from mtab"));
 			cxt->user_mountflags &= ~MNT_MS_LOOP;
-			mnt_optstr_remove_option(&cxt->fs->user_optstr, "loop");
+			if (mnt_fs_unshare_str(cxt->fs, user_optstr) == 0)
+				mnt_optstr_remove_option(&cxt->fs->user_optstr, "loop");
 		}
 
 		if (!(cxt->mountflags & MS_RDONLY) &&
@@ -27,6 +27,8 @@
 #include "linux_version.h"
 #include "mountP.h"
 #include "strutils.h"
+#include "pathnames.h"
+#include "mount-api-utils.h"
 
 /*
  * Kernel supports only one MS_PROPAGATION flag change by one mount(2) syscall,
@@ -231,6 +233,16 @@ static int fix_optstr(struct libmnt_context *cxt)
 		"vfs: '%s' fs: '%s' user: '%s', optstr: '%s'",
 		fs->vfs_optstr, fs->fs_optstr, fs->user_optstr, fs->optstr));
 
+	/* the options are modified in place, they may be shared with the
+	 * fstab entry (see mnt_copy_fs()) */
+	rc = mnt_fs_unshare_str(fs, vfs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, fs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, user_optstr);
+	if (rc)
+		goto done;
+
 	/*
 	 * The "user" options is our business (so we can modify the option),
 	 * the exception is command line for /sbin/mount.<type> helpers. Let's
@@ -264,14 +276,10 @@ static int fix_optstr(struct libmnt_context *cxt)
 	if (rc)
 		goto done;
 
-	if (fs->vfs_optstr && *fs->vfs_optstr == '\0') {
-		free(fs->vfs_optstr);
-		fs->vfs_optstr = NULL;
-	}
-	if (fs->user_optstr && *fs->user_optstr == '\0') {
-		free(fs->user_optstr);
-		fs->user_optstr = NULL;
-	}
+	if (fs->vfs_optstr && *fs->vfs_optstr == '\0')
+		mnt_fs_free_str(fs, vfs_optstr);
+	if (fs->user_optstr && *fs->user_optstr == '\0')
+		mnt_fs_free_str(fs, user_optstr);
 	if (cxt->mountflags & MS_PROPAGATION) {
 		rc = init_propagation(cxt);
 		if (rc)
@@ -366,8 +374,7 @@ static int fix_optstr(struct libmnt_context *cxt)
 	}
 
 	/* refresh merged optstr */
-	free(fs->optstr);
-	fs->optstr = NULL;
+	mnt_fs_free_str(fs, optstr);
 	fs->optstr = mnt_fs_strdup_options(fs);
 done:
 	cxt->flags |= MNT_FL_MOUNTOPTS_FIXED;
@@ -387,9 +394,9 @@ done:
  */
 static int generate_helper_optstr(struct libmnt_context *cxt, char **optstr)
 {
-	struct libmnt_optmap const *maps[2];
-	char *next, *name, *val;
-	size_t namesz, valsz;
+	struct libmnt_optlist *ls;
+	struct libmnt_opt *opt;
+	char *o;
 	int rc = 0;
 
 	assert(cxt);
@@ -398,10 +405,27 @@ static int generate_helper_optstr(struct libmnt_context *cxt, char **optstr)
 
 	DBG(CXT, ul_debugobj(cxt, "mount: generate helper mount options"));
 
-	*optstr = mnt_fs_strdup_options(cxt->fs);
-	if (!*optstr)
+	*optstr = NULL;
+
+	o = mnt_fs_strdup_options(cxt->fs);
+	if (!o)
 		return -ENOMEM;
 
+	/* parse the options only once, the string is generated at the end */
+	ls = mnt_new_optlist();
+	if (!ls) {
+		free(o);
+		return -ENOMEM;
+	}
+	rc = mnt_optlist_register_map(ls, mnt_get_builtin_optmap(MNT_USERSPACE_MAP));
+	if (!rc)
+		rc = mnt_optlist_register_map(ls, mnt_get_builtin_optmap(MNT_LINUX_MAP));
+	if (!rc)
+		rc = mnt_optlist_append_optstr(ls, o);
+	free(o);
+	if (rc)
+		goto done;
+
 	if ((cxt->user_mountflags & MNT_MS_USER) ||
 	    (cxt->user_mountflags & MNT_MS_USERS)) {
 		/*
@@ -420,40 +444,42 @@ static int generate_helper_optstr(struct libmnt_context *cxt, char **optstr)
 		 * mnt_optstr_get_flags() and mnt_context_merge_mflags()).
 		 */
 		if (!(cxt->mountflags & MS_NOEXEC))
-			mnt_optstr_append_option(optstr, "exec", NULL);
+			mnt_optlist_append_option(ls, "exec", NULL);
 		if (!(cxt->mountflags & MS_NOSUID))
-			mnt_optstr_append_option(optstr, "suid", NULL);
+			mnt_optlist_append_option(ls, "suid", NULL);
 		if (!(cxt->mountflags & MS_NODEV))
-			mnt_optstr_append_option(optstr, "dev", NULL);
+			mnt_optlist_append_option(ls, "dev", NULL);
 	}
 
-	if (cxt->flags & MNT_FL_SAVED_USER)
-		rc = mnt_optstr_set_option(optstr, "user", cxt->orig_user);
+	if (cxt->flags & MNT_FL_SAVED_USER) {
+		opt = mnt_optlist_get_opt(ls, "user");
+		if (opt)
+			rc = mnt_opt_set_value(opt, cxt->orig_user);
+		else
+			rc = mnt_optlist_append_option(ls, "user", cxt->orig_user);
+	}
 	if (rc)
-		goto err;
+		goto done;
 
 	/* remove userspace options with MNT_NOHLPS flag */
-	maps[0] = mnt_get_builtin_optmap(MNT_USERSPACE_MAP);
-	maps[1] = mnt_get_builtin_optmap(MNT_LINUX_MAP);
-	next = *optstr;
-
-	while (!mnt_optstr_next_option(&next, &name, &namesz, &val, &valsz)) {
-		const struct libmnt_optmap *ent;
-
-		mnt_optmap_get_entry(maps, 2, name, namesz, &ent);
-		if (ent && ent->id && (ent->mask & MNT_NOHLPS)) {
-			next = name;
-			rc = mnt_optstr_remove_option_at(optstr, name,
-					val ? val + valsz : name + namesz);
-			if (rc)
-				goto err;
-		}
+	opt = mnt_optlist_first_opt(ls);
+	while (opt) {
+		struct libmnt_opt *next = mnt_optlist_next_opt(ls, opt);
+		const struct libmnt_optmap *ent = mnt_opt_get_mapent(opt, NULL);
+
+		if (ent && ent->id && (ent->mask & MNT_NOHLPS))
+			mnt_optlist_remove_opt(ls, opt);
+		opt = next;
 	}
 
-	return rc;
-err:
-	free(*optstr);
-	*optstr = NULL;
+	rc = mnt_optlist_to_string(ls, optstr);
+	if (!rc && !*optstr) {
+		*optstr = strdup("");
+		if (!*optstr)
+			rc = -ENOMEM;
+	}
+done:
+	mnt_free_optlist(ls);
 	return rc;
 }
 
@@ -718,6 +744,184 @@ static int exec_helper(struct libmnt_context *cxt)
 	return rc;
 }
 
+#ifdef UL_HAVE_MOUNT_API
+static int mount_api_enosys;	/* kernel without open_tree() and mount_setattr() */
+
+/* converts MS_* per-mount flags to "remount,bind" like mount_setattr() request */
+static void mflags_to_mount_attr(unsigned long flags, struct mount_attr *attr)
+{
+	attr->attr_clr = MOUNT_ATTR_RDONLY | MOUNT_ATTR_NOSUID |
+			 MOUNT_ATTR_NODEV | MOUNT_ATTR_NOEXEC;
+	if (flags & MS_RDONLY)
+		attr->attr_set |= MOUNT_ATTR_RDONLY;
+	if (flags & MS_NOSUID)
+		attr->attr_set |= MOUNT_ATTR_NOSUID;
+	if (flags & MS_NODEV)
+		attr->attr_set |= MOUNT_ATTR_NODEV;
+	if (flags & MS_NOEXEC)
+		attr->attr_set |= MOUNT_ATTR_NOEXEC;
+
+	/* atime setting is kept if not specified (like mount(2) does) */
+	if (flags & (MS_NOATIME | MS_RELATIME | MS_STRICTATIME | MS_NODIRATIME)) {
+		attr->attr_clr |= MOUNT_ATTR__ATIME | MOUNT_ATTR_NODIRATIME;
+		if (flags & MS_NOATIME)
+			attr->attr_set |= MOUNT_ATTR_NOATIME;
+		else if (flags & MS_STRICTATIME)
+			attr->attr_set |= MOUNT_ATTR_STRICTATIME;
+		if (flags & MS_NODIRATIME)
+			attr->attr_set |= MOUNT_ATTR_NODIRATIME;
+	}
+}
+
+/*
+ * Creates a detached copy of @src (the whole tree for MS_REC), applies
+ * idmapping, VFS flags and propagation (cxt->addmounts) to the copy and then
+ * attaches it to @target. The new mount is visible with the final flags only.
+ *
+ * Returns: 0 on success, -ENOSYS if the new mount API is not supported,
+ *          or negative errno.
+ */
+static int do_bind_mount_api(struct libmnt_context *cxt,
+			     const char *src, const char *target,
+			     unsigned long flags, int userns_fd)
+{
+	struct list_head *p;
+	int fd, rc = 0;
+
+	DBG(CXT, ul_debugobj(cxt, "open_tree(%s)%s", src,
+				flags & MS_REC ? " (recursive)" : ""));
+
+	fd = open_tree(AT_FDCWD, src, OPEN_TREE_CLONE | OPEN_TREE_CLOEXEC
+					| (flags & MS_REC ? AT_RECURSIVE : 0));
+	if (fd < 0)
+		return -errno;
+
+	if (userns_fd >= 0) {
+		struct mount_attr attr = {
+			.attr_set = MOUNT_ATTR_IDMAP,
+			.userns_fd = userns_fd
+		};
+
+		DBG(CXT, ul_debugobj(cxt, "mount_setattr() idmap"));
+		if (mount_setattr(fd, "", AT_EMPTY_PATH
+				| (flags & MS_REC ? AT_RECURSIVE : 0),
+				&attr, sizeof(attr))) {
+			rc = -errno;
+			goto done;
+		}
+	}
+
+	list_for_each(p, &cxt->addmounts) {
+		struct libmnt_addmount *ad =
+				list_entry(p, struct libmnt_addmount, mounts);
+		struct mount_attr attr = { 0 };
+
+		if (ad->mountflags & MS_REMOUNT)
+			mflags_to_mount_attr(ad->mountflags, &attr);
+		else
+			attr.propagation = ad->mountflags & MS_PROPAGATION;
+
+		DBG(CXT, ul_debugobj(cxt, "mount_setattr() changing flag: 0x%08lx %s",
+				ad->mountflags,
+				ad->mountflags & MS_REC ? " (recursive)" : ""));
+
+		if (mount_setattr(fd, "", AT_EMPTY_PATH
+				| (ad->mountflags & MS_REC ? AT_RECURSIVE : 0),
+				&attr, sizeof(attr))) {
+			rc = -errno;
+			goto done;
+		}
+	}
+
+	DBG(CXT, ul_debugobj(cxt, "move_mount(%s)", target));
+	if (move_mount(fd, "", AT_FDCWD, target, MOVE_MOUNT_F_EMPTY_PATH))
+		rc = -errno;
+done:
+	close(fd);
+	if (rc)
+		DBG(CXT, ul_debugobj(cxt, "new mount API failed [rc=%d]", rc));
+	return rc;
+}
+#endif /* UL_HAVE_MOUNT_API */
+
+/* remount,bind for all submounts of @parent */
+static int remount_submounts(struct libmnt_context *cxt,
+			     struct libmnt_table *tb,
+			     struct libmnt_fs *parent,
+			     unsigned long flags)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	int rc;
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+
+	while (mnt_table_next_child_fs(tb, &itr, parent, &fs) == 0) {
+		const char *tgt = mnt_fs_get_target(fs);
+
+		DBG(CXT, ul_debugobj(cxt, "mount(2) remount submount %s", tgt));
+		if (mount("none", tgt, NULL, flags, NULL))
+			return -errno;
+		rc = remount_submounts(cxt, tb, fs, flags);
+		if (rc)
+			return rc;
+	}
+	return 0;
+}
+
+/*
+ * "remount,rbind,<flags>" -- set VFS flags for @target and all submounts.
+ * It's one atomic mount_setattr(AT_RECURSIVE) on new kernels, otherwise
+ * mount(2) is called for each mountpoint in the tree.
+ *
+ * Returns: 0 on success or negative errno.
+ */
+static int do_remount_recursive(struct libmnt_context *cxt,
+				const char *target, unsigned long flags)
+{
+	struct libmnt_table *tb;
+	struct libmnt_fs *fs;
+	int rc;
+
+#ifdef UL_HAVE_MOUNT_API
+	if (!mount_api_enosys) {
+		struct mount_attr attr = { 0 };
+
+		mflags_to_mount_attr(flags, &attr);
+
+		DBG(CXT, ul_debugobj(cxt, "mount_setattr(%s) recursive", target));
+		if (mount_setattr(AT_FDCWD, target, AT_RECURSIVE,
+				  &attr, sizeof(attr)) == 0)
+			return 0;
+		if (errno == ENOSYS)
+			mount_api_enosys = 1;
+		else if (errno != EPERM)
+			return -errno;
+
+		/* EPERM is usually seccomp filter in a container; mount(2)
+		 * returns the real error if the operation is not permitted */
+		DBG(CXT, ul_debugobj(cxt, "mount_setattr() failed [errno=%d], "
+					  "fallback to mount(2)", errno));
+	}
+#endif
+	flags &= ~MS_REC;
+
+	DBG(CXT, ul_debugobj(cxt, "mount(2) remount %s and submounts", target));
+	if (mount("none", target, NULL, flags, NULL))
+		return -errno;
+
+	/* don't use cxt->mtab, the tree may be mounted by the current operation */
+	tb = mnt_new_table_from_file(_PATH_PROC_MOUNTINFO);
+	if (!tb)
+		return 0;	/* mountinfo not available, top-level only */
+
+	fs = mnt_table_find_target(tb, target, MNT_ITER_BACKWARD);
+	rc = fs ? remount_submounts(cxt, tb, fs, flags) : 0;
+
+	mnt_unref_table(tb);
+	return rc;
+}
+
 static int do_mount_additional(struct libmnt_context *cxt,
 			       const char *target,
 			       unsigned long flags,
@@ -740,14 +944,18 @@ static int do_mount_additional(struct libmnt_context *cxt,
 				ad->mountflags,
 				ad->mountflags & MS_REC ? " (recursive)" : ""));
 
-		rc = mount("none", target, NULL,
-				ad->mountflags | (flags & MS_SILENT), NULL);
+		if ((ad->mountflags & (MS_REMOUNT | MS_BIND | MS_REC))
+				== (MS_REMOUNT | MS_BIND | MS_REC))
+			rc = do_remount_recursive(cxt, target,
+				ad->mountflags | (flags & MS_SILENT));
+		else
+			rc = mount("none", target, NULL,
+				ad->mountflags | (flags & MS_SILENT), NULL) ? -errno : 0;
 		if (rc) {
 			if (syserr)
-				*syserr = -errno;
+				*syserr = rc;
 			DBG(CXT, ul_debugobj(cxt,
-					"mount(2) failed [errno=%d %m]",
-					errno));
+					"mount(2) failed [errno=%d]", -rc));
 			return rc;
 		}
 	}
@@ -755,6 +963,77 @@ static int do_mount_additional(struct libmnt_context *cxt,
 	return 0;
 }
 
+/* opens user namespace file specified by X-mount.idmap=<path> */
+static int open_idmap_userns(struct libmnt_context *cxt, unsigned long flags)
+{
+	char *val = NULL, *path;
+	size_t valsz = 0;
+	int fd;
+
+	if (!cxt->fs->user_optstr
+	    || mnt_optstr_get_option(cxt->fs->user_optstr, "X-mount.idmap",
+				     &val, &valsz) != 0)
+		return -1;	/* not specified */
+
+	/* idmapping is supported for new bind mounts only */
+	if (!val || !valsz || !(flags & MS_BIND) || (flags & MS_REMOUNT))
+		return -MNT_ERR_MOUNTOPT;
+
+	path = strndup(val, valsz);
+	if (!path)
+		return -ENOMEM;
+
+	DBG(CXT, ul_debugobj(cxt, "idmap user namespace: %s", path));
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	free(path);
+	return fd < 0 ? -errno : fd;
+}
+
+/*
+ * Calls mount(2) or the new mount API for the primary mount operation. The
+ * @userns_fd is X-mount.idmap user namespace or -1. The @addmounts_done is
+ * set if the cxt->addmounts have been applied too.
+ *
+ * Returns: 0 on success or negative errno.
+ */
+static int do_mount_syscall(struct libmnt_context *cxt,
+			    const char *src, const char *target,
+			    const char *type, unsigned long flags,
+			    int userns_fd, int *addmounts_done)
+{
+	int rc = -ENOSYS;
+
+	*addmounts_done = 0;
+
+#ifdef UL_HAVE_MOUNT_API
+	if ((flags & MS_BIND) && !(flags & MS_REMOUNT) && !mount_api_enosys
+	    && (!list_empty(&cxt->addmounts) || userns_fd >= 0)) {
+		rc = do_bind_mount_api(cxt, src, target, flags, userns_fd);
+		if (rc == -ENOSYS)
+			mount_api_enosys = 1;
+
+		/* The detached tree is never attached on error, so it's safe
+		 * to fallback to mount(2). EPERM is usually seccomp filter in
+		 * a container; mount(2) returns the real error if the
+		 * operation is not permitted.
+		 */
+		if ((rc != -ENOSYS && rc != -EPERM) || userns_fd >= 0) {
+			*addmounts_done = 1;
+			return rc;
+		}
+	}
+#endif
+	if (userns_fd >= 0)
+		return rc;	/* idmapping is possible by mount_setattr() only */
+
+	if ((flags & (MS_REMOUNT | MS_BIND | MS_REC))
+				== (MS_REMOUNT | MS_BIND | MS_REC))
+		rc = do_remount_recursive(cxt, target, flags);
+	else
+		rc = mount(src, target, type, flags, cxt->mountdata) ? -errno : 0;
+	return rc;
+}
+
 /*
  * The default is to use fstype from cxt->fs, this could be overwritten by
  * @try_type argument. If @try_type is specified then mount with MS_SILENT.
@@ -831,19 +1110,30 @@ static int do_mount(struct libmnt_context *cxt, const char *try_type)
 		/*
 		 * regular mount
 		 */
-		if (mount(src, target, type, flags, cxt->mountdata)) {
-			cxt->syscall_status = -errno;
-			DBG(CXT, ul_debugobj(cxt, "mount(2) failed [errno=%d %m]",
+		int addmounts_done, userns_fd;
+
+		/* not a syscall error, the option is invalid or the namespace
+		 * file cannot be opened */
+		userns_fd = open_idmap_userns(cxt, flags);
+		if (userns_fd < -1)
+			return userns_fd;
+
+		cxt->syscall_status = do_mount_syscall(cxt, src, target, type,
+						flags, userns_fd, &addmounts_done);
+		if (userns_fd >= 0)
+			close(userns_fd);
+		if (cxt->syscall_status) {
+			DBG(CXT, ul_debugobj(cxt, "mount(2) failed [errno=%d]",
 							-cxt->syscall_status));
 			return -cxt->syscall_status;
 		}
 		DBG(CXT, ul_debugobj(cxt, "  success"));
-		cxt->syscall_status = 0;
 
 		/*
 		 * additional mounts for extra propagation flags
 		 */
-		if (!list_empty(&cxt->addmounts)
+		if (!addmounts_done
+		    && !list_empty(&cxt->addmounts)
 		    && do_mount_additional(cxt, target, flags, NULL)) {
 
 			/* TODO: call umount? */
@@ -1577,6 +1867,172 @@ int mnt_context_next_remount(struct libmnt_context *cxt,
 	return rc;
 }
 
+/**
+ * mnt_context_next_batch_mount:
+ * @cxt: context
+ * @tb: mount requests (source, target, fstype and options for each mount)
+ * @itr: iterator
+ * @fs: returns the current filesystem
+ * @mntrc: returns the return code from mnt_context_mount()
+ *
+ * This function mounts the next entry from @tb. It's designed for
+ * applications which need to mount many filesystems at once (e.g.
+ * container runtimes) and the entries in @tb are usually created by
+ * mnt_new_fs() and mnt_table_add_fs().
+ *
+ * All mounts share the same context, so mtab is parsed only once for the
+ * whole batch, and paths are canonicalized by the same cache. The mtab/utab
+ * file is not updated after each mount, but all entries are written by one
+ * locked update at the end of the batch (see mnt_context_finalize_batch()).
+ * It means that mount requests in @tb should not depend on the filesystems
+ * mounted by the same batch (e.g. bind mount of a target mounted by the
+ * previous entry is fine, but "mount by target" is not).
+ *
+ * IMPORTANT -- the mount operation is performed in the current context.
+ * The context is reset before the next mount (see mnt_reset_context()).
+ * The context setting related to the filesystem (e.g. mount options,
+ * etc.) are protected. The context does not fork in this mode.
+ *
+ * If mount(2) syscall or mount.type helper failed, then the function returns
+ * zero, but the @mntrc is non-zero. Use also mnt_context_get_status() to
+ * check if the filesystem was successfully mounted.
+ *
+ * Note that @mntrc and the context status describe the mount operation only,
+ * the mtab/utab entry is not written yet. The deferred update is evaluated at
+ * the end of the list; if it fails, the function returns a negative number
+ * rather than 1. The filesystems are mounted in this case, but their
+ * userspace mount options are not recorded.
+ *
+ * Returns: 0 on success,
+ *         <0 in case of error (!= mount(2) errors) or if the deferred
+ *            mtab/utab update failed,
+ *          1 at the end of the list (after mnt_context_finalize_batch()).
+ *
+ * Since: 2.37
+ */
+int mnt_context_next_batch_mount(struct libmnt_context *cxt,
+			   struct libmnt_table *tb,
+			   struct libmnt_iter *itr,
+			   struct libmnt_fs **fs,
+			   int *mntrc)
+{
+	struct libmnt_table *mtab;
+	char *pattern;
+	int rc;
+
+	if (mntrc)
+		*mntrc = 0;
+
+	if (!cxt || !tb || !fs || !itr)
+		return -EINVAL;
+
+	rc = mnt_table_next_fs(tb, itr, fs);
+	if (rc == 1) {
+		rc = mnt_context_finalize_batch(cxt);
+		return rc ? rc : 1;
+	}
+	if (rc)
+		return rc;	/* error */
+
+	DBG(CXT, ul_debugobj(cxt, "next-batch-mount: trying %s",
+				mnt_fs_get_target(*fs)));
+
+	/* Save mount options, etc. -- this is effective for the first
+	 * call only. Make sure that cxt has not set source, target or fstype.
+	 */
+	if (!mnt_context_has_template(cxt)) {
+		mnt_context_set_source(cxt, NULL);
+		mnt_context_set_target(cxt, NULL);
+		mnt_context_set_fstype(cxt, NULL);
+		mnt_context_save_template(cxt);
+	}
+	if (!cxt->batch_utab) {
+		cxt->batch_utab = mnt_new_table();
+		if (!cxt->batch_utab)
+			return -ENOMEM;
+	}
+
+	/* reset context, but protect mtab */
+	mtab = cxt->mtab;
+	cxt->mtab = NULL;
+	mnt_reset_context(cxt);
+	cxt->mtab = mtab;
+
+	rc = mnt_context_apply_fs(cxt, *fs);
+	if (rc)
+		return rc;
+
+	/* -t is "-t <type>" for the mount operation, not a pattern */
+	pattern = cxt->fstype_pattern;
+	cxt->fstype_pattern = NULL;
+
+	rc = mnt_context_mount(cxt);
+
+	cxt->fstype_pattern = pattern;
+
+	if (mntrc)
+		*mntrc = rc;
+	return 0;
+}
+
+/**
+ * mnt_context_finalize_batch:
+ * @cxt: context
+ *
+ * Writes mtab/utab entries for all filesystems mounted by
+ * mnt_context_next_batch_mount(). The file is locked and updated only once.
+ * The function is called automatically at the end of the batch and by
+ * mnt_free_context(), so it's necessary to call it only if the application
+ * stops the batch before the end of the list. Call it explicitly also if you
+ * need to know the result of the update, mnt_free_context() cannot return it.
+ *
+ * The queued entries are dropped also on error.
+ *
+ * Returns: 0 on success, negative number on error (the entries have not
+ * been written).
+ *
+ * Since: 2.37
+ */
+int mnt_context_finalize_batch(struct libmnt_context *cxt)
+{
+	struct libmnt_ns *ns_old;
+	int rc = 0;
+
+	if (!cxt)
+		return -EINVAL;
+	if (!cxt->batch_utab)
+		return 0;
+
+	DBG(CXT, ul_debugobj(cxt, "finalize batch [%d entries]",
+				mnt_table_get_nents(cxt->batch_utab)));
+
+	if (mnt_table_is_empty(cxt->batch_utab))
+		goto done;
+
+	/* the entries are queued by the update, so it has to exist */
+	if (!cxt->update) {
+		rc = -EINVAL;
+		goto done;
+	}
+
+	ns_old = mnt_context_switch_target_ns(cxt);
+	if (!ns_old) {
+		rc = -MNT_ERR_NAMESPACE;
+		goto done;
+	}
+
+	rc = mnt_update_add_entries(cxt->update, cxt->batch_utab, cxt->lock);
+
+	if (!mnt_context_switch_ns(cxt, ns_old))
+		rc = -MNT_ERR_NAMESPACE;
+done:
+	if (rc)
+		DBG(CXT, ul_debugobj(cxt, "finalize batch failed [rc=%d]", rc));
+	mnt_unref_table(cxt->batch_utab);
+	cxt->batch_utab = NULL;
+	return rc;
+}
+
 /*
  * Returns 1 if @dir parent is shared
  */
@@ -78,20 +78,21 @@ void mnt_reset_fs(struct libmnt_fs *fs)
 
 	ref = fs->refcount;
 
+	mnt_table_unlink_fs(fs);
 	list_del(&fs->ents);
-	free(fs->source);
-	free(fs->bindsrc);
-	free(fs->tagname);
-	free(fs->tagval);
-	free(fs->root);
-	free(fs->swaptype);
-	free(fs->target);
-	free(fs->fstype);
-	free(fs->optstr);
-	free(fs->vfs_optstr);
-	free(fs->fs_optstr);
-	free(fs->user_optstr);
-	free(fs->attrs);
+	mnt_fs_free_str(fs, source);
+	mnt_fs_free_str(fs, bindsrc);
+	mnt_fs_free_str(fs, tagname);
+	mnt_fs_free_str(fs, tagval);
+	mnt_fs_free_str(fs, root);
+	mnt_fs_free_str(fs, swaptype);
+	mnt_fs_free_str(fs, target);
+	mnt_fs_free_str(fs, fstype);
+	mnt_fs_free_str(fs, optstr);
+	mnt_fs_free_str(fs, vfs_optstr);
+	mnt_fs_free_str(fs, fs_optstr);
+	mnt_fs_free_str(fs, user_optstr);
+	mnt_fs_free_str(fs, attrs);
 	free(fs->opt_fields);
 	free(fs->comment);
 
@@ -153,17 +154,123 @@ static inline int update_str(char **dest, const char *src)
 	return 0;
 }
 
+/*
+ * Shared strings
+ *
+ * The strings set by the mnt_fs_set_*() functions are allocated with a
+ * reference counter, and mnt_copy_fs() does not duplicate them; the copy
+ * shares the strings with the original filesystem and the string is
+ * duplicated on the first in-place modification (copy-on-write). The other
+ * strings (for example from the parser) are private, the copy gets a new
+ * shared string. The original filesystem is never modified by the copy, so
+ * the pointers returned by mnt_fs_get_*() stay valid. fs->shared is a mask
+ * of the members which point to the shared strings.
+ *
+ * The reference counter is atomic, because the same string may be shared
+ * by filesystems used in different threads.
+ *
+ * Code which frees or replaces the string members has to use
+ * mnt_fs_free_str(), code which modifies the members in place (for example
+ * mnt_optstr_*() on &fs->vfs_optstr) has to call mnt_fs_unshare_str() before.
+ */
+struct libmnt_shstr {
+	int	refcount;
+	char	str[];
+};
+
+#define shstr_from_str(_s)	((struct libmnt_shstr *) ((_s) - offsetof(struct libmnt_shstr, str)))
+#define fs_str_bit(_offset)	(UINT64_C(1) << ((_offset) / sizeof(char *)))
+#define fs_str_at(_fs, _offset)	((char **) ((char *) (_fs) + (_offset)))
+
+static char *new_shstr(const char *str)
+{
+	size_t sz = strlen(str) + 1;
+	struct libmnt_shstr *x;
+
+	x = malloc(sizeof(*x) + sz);
+	if (!x)
+		return NULL;
+	x->refcount = 1;
+	memcpy(x->str, str, sz);
+	return x->str;
+}
+
+void __mnt_fs_free_str(struct libmnt_fs *fs, size_t offset)
+{
+	char **s = fs_str_at(fs, offset);
+
+	if (*s && (fs->shared & fs_str_bit(offset))) {
+		struct libmnt_shstr *x = shstr_from_str(*s);
+
+		if (__atomic_sub_fetch(&x->refcount, 1, __ATOMIC_ACQ_REL) == 0)
+			free(x);
+	} else
+		free(*s);
+
+	*s = NULL;
+	fs->shared &= ~fs_str_bit(offset);
+}
+
+int __mnt_fs_unshare_str(struct libmnt_fs *fs, size_t offset)
+{
+	char **s = fs_str_at(fs, offset);
+	char *p;
+
+	if (!*s || !(fs->shared & fs_str_bit(offset)))
+		return 0;
+
+	p = strdup(*s);
+	if (!p)
+		return -ENOMEM;
+	__mnt_fs_free_str(fs, offset);
+	*s = p;
+	return 0;
+}
+
+/* Replaces the member at @offset with (shared) copy of @str */
+static int set_str_at_offset(struct libmnt_fs *fs, size_t offset, const char *str)
+{
+	char *p = NULL;
+
+	if (!fs)
+		return -EINVAL;
+	if (str) {
+		p = new_shstr(str);
+		if (!p)
+			return -ENOMEM;
+	}
+	__mnt_fs_free_str(fs, offset);
+	*fs_str_at(fs, offset) = p;
+	if (p)
+		fs->shared |= fs_str_bit(offset);
+	return 0;
+}
+
+#define set_str_member(_fs, _m, _str) \
+		set_str_at_offset(_fs, offsetof(struct libmnt_fs, _m), _str)
+
 /* This function does NOT overwrite (replace) the string in @new, the string in
- * @new has to be NULL otherwise this is no-op. */
-static inline int cpy_str_at_offset(void *new, const void *old, size_t offset)
+ * @new has to be NULL otherwise this is no-op. The string is shared if it's
+ * already shared in @old, otherwise @new gets a new shared copy. */
+static int share_str_at_offset(struct libmnt_fs *new, const struct libmnt_fs *old,
+			       size_t offset)
 {
-	char **o = (char **) ((char *) old + offset);
-	char **n = (char **) ((char *) new + offset);
+	char *o = *fs_str_at(old, offset);
+	char **n = fs_str_at(new, offset);
 
-	if (*n)
+	if (*n || !o)
 		return 0;	/* already set, don't overwrite */
 
-	return update_str(n, *o);
+	if (old->shared & fs_str_bit(offset)) {
+		__atomic_add_fetch(&shstr_from_str(o)->refcount, 1, __ATOMIC_RELAXED);
+		*n = o;
+	} else {
+		*n = new_shstr(o);
+		if (!*n)
+			return -ENOMEM;
+	}
+	new->shared |= fs_str_bit(offset);
+	return 0;
 }
 
 /**
@@ -177,6 +284,10 @@ static inline int cpy_str_at_offset(void *new, const void *old, size_t offset)
  * This function does not copy userdata (se mnt_fs_set_userdata()). A new copy is
  * not linked with any existing mnt_tab.
  *
+ * The strings are not duplicated if possible, @dest shares them with @src
+ * until one of the filesystems modifies it (copy-on-write). @src is not
+ * modified.
+ *
  * Returns: @dest or NULL in case of error
  */
 struct libmnt_fs *mnt_copy_fs(struct libmnt_fs *dest,
@@ -199,31 +310,31 @@ struct libmnt_fs *mnt_copy_fs(struct libmnt_fs *dest,
 	dest->devno      = src->devno;
 	dest->tid        = src->tid;
 
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, source)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, source)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, tagname)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, tagname)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, tagval)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, tagval)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, root)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, root)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, swaptype)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, swaptype)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, target)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, target)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, fstype)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, fstype)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, optstr)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, optstr)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, vfs_optstr)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, vfs_optstr)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, fs_optstr)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, fs_optstr)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, user_optstr)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, user_optstr)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, attrs)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, attrs)))
 		goto err;
-	if (cpy_str_at_offset(dest, src, offsetof(struct libmnt_fs, bindsrc)))
+	if (share_str_at_offset(dest, src, offsetof(struct libmnt_fs, bindsrc)))
 		goto err;
 
 	dest->freq       = src->freq;
@@ -380,14 +491,18 @@ int __mnt_fs_set_source_ptr(struct libmnt_fs *fs, char *source)
 	}
 
 	if (fs->source != source)
-		free(fs->source);
+		mnt_fs_free_str(fs, source);
 
-	free(fs->tagname);
-	free(fs->tagval);
+	mnt_fs_free_str(fs, tagname);
+	mnt_fs_free_str(fs, tagval);
 
 	fs->source = source;
 	fs->tagname = t;
 	fs->tagval = v;
+
+	/* the source is indexed, see mnt_table_enable_index() */
+	if (fs->tab)
+		mnt_table_reset_index(fs->tab);
 	return 0;
 }
 
@@ -549,7 +664,7 @@ const char *mnt_fs_get_target(struct libmnt_fs *fs)
  */
 int mnt_fs_set_target(struct libmnt_fs *fs, const char *tgt)
 {
-	return strdup_to_struct_member(fs, target, tgt);
+	return set_str_member(fs, target, tgt);
 }
 
 static int mnt_fs_get_flags(struct libmnt_fs *fs)
@@ -653,7 +768,7 @@ int __mnt_fs_set_fstype_ptr(struct libmnt_fs *fs, char *fstype)
 	assert(fs);
 
 	if (fstype != fs->fstype)
-		free(fs->fstype);
+		mnt_fs_free_str(fs, fstype);
 
 	fs->fstype = fstype;
 	fs->flags &= ~MNT_FS_PSEUDO;
@@ -832,10 +947,10 @@ int mnt_fs_set_options(struct libmnt_fs *fs, const char *optstr)
 		}
 	}
 
-	free(fs->fs_optstr);
-	free(fs->vfs_optstr);
-	free(fs->user_optstr);
-	free(fs->optstr);
+	mnt_fs_free_str(fs, fs_optstr);
+	mnt_fs_free_str(fs, vfs_optstr);
+	mnt_fs_free_str(fs, user_optstr);
+	mnt_fs_free_str(fs, optstr);
 
 	fs->fs_optstr = f;
 	fs->vfs_optstr = v;
@@ -868,8 +983,14 @@ int mnt_fs_append_options(struct libmnt_fs *fs, const char *optstr)
 		return 0;
 
 	rc = mnt_split_optstr(optstr, &u, &v, &f, 0, 0);
-	if (rc)
-		return rc;
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, vfs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, fs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, user_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, optstr);
 
 	if (!rc && v)
 		rc = mnt_optstr_append_option(&fs->vfs_optstr, v, NULL);
@@ -910,8 +1031,14 @@ int mnt_fs_prepend_options(struct libmnt_fs *fs, const char *optstr)
 		return 0;
 
 	rc = mnt_split_optstr(optstr, &u, &v, &f, 0, 0);
-	if (rc)
-		return rc;
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, vfs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, fs_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, user_optstr);
+	if (!rc)
+		rc = mnt_fs_unshare_str(fs, optstr);
 
 	if (!rc && v)
 		rc = mnt_optstr_prepend_option(&fs->vfs_optstr, v, NULL);
@@ -1022,7 +1149,7 @@ const char *mnt_fs_get_attributes(struct libmnt_fs *fs)
  */
 int mnt_fs_set_attributes(struct libmnt_fs *fs, const char *optstr)
 {
-	return strdup_to_struct_member(fs, attrs, optstr);
+	return set_str_member(fs, attrs, optstr);
 }
 
 /**
@@ -1040,6 +1167,8 @@ int mnt_fs_append_attributes(struct libmnt_fs *fs, const char *optstr)
 		return -EINVAL;
 	if (!optstr)
 		return 0;
+	if (mnt_fs_unshare_str(fs, attrs))
+		return -ENOMEM;
 	return mnt_optstr_append_option(&fs->attrs, optstr, NULL);
 }
 
@@ -1058,6 +1187,8 @@ int mnt_fs_prepend_attributes(struct libmnt_fs *fs, const char *optstr)
 		return -EINVAL;
 	if (!optstr)
 		return 0;
+	if (mnt_fs_unshare_str(fs, attrs))
+		return -ENOMEM;
 	return mnt_optstr_prepend_option(&fs->attrs, optstr, NULL);
 }
 
@@ -1134,7 +1265,7 @@ const char *mnt_fs_get_root(struct libmnt_fs *fs)
  */
 int mnt_fs_set_root(struct libmnt_fs *fs, const char *path)
 {
-	return strdup_to_struct_member(fs, root, path);
+	return set_str_member(fs, root, path);
 }
 
 /**
@@ -1218,7 +1349,7 @@ const char *mnt_fs_get_bindsrc(struct libmnt_fs *fs)
  */
 int mnt_fs_set_bindsrc(struct libmnt_fs *fs, const char *src)
 {
-	return strdup_to_struct_member(fs, bindsrc, src);
+	return set_str_member(fs, bindsrc, src);
 }
 
 /**
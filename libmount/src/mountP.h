@@ -143,6 +143,9 @@ extern int __mnt_table_is_fs_mounted(	struct libmnt_table *tb,
 					struct libmnt_fs *fstab_fs,
 					const char *tgt_prefix);
 
+extern void mnt_table_reset_index(struct libmnt_table *tb);
+extern void mnt_table_unlink_fs(struct libmnt_fs *fs);
+
 /*
  * Generic iterator
  */
@@ -215,6 +218,8 @@ struct libmnt_fs {
 
 	char		*comment;	/* fstab comment */
 
+	uint64_t	shared;		/* mask of shared strings, see fs.c */
+
 	void		*userdata;	/* library independent data */
 };
 
@@ -253,6 +258,40 @@ struct libmnt_table {
 
 	struct list_head	ents;	/* list of entries (libmnt_fs) */
 	void		*userdata;
+
+	/* lazily generated mountinfo tree index, see tab.c */
+	struct libmnt_fs	**idx_by_parent;	/* sorted by parent ID and ID */
+	struct libmnt_fs	**idx_by_id;		/* sorted by ID */
+	size_t			idx_nents;
+
+	/* lazily generated source index, see mnt_table_enable_index() */
+	struct libmnt_idxent	*idx_by_src;	/* sorted by source path hash */
+	struct libmnt_idxent	*idx_by_devno;	/* sorted by devno */
+	struct libmnt_fs	**idx_loops;	/* entries with /dev/loopN source */
+	size_t			idx_src_nents;
+	size_t			idx_devno_nents;
+	size_t			idx_nloops;
+	int			idx_ntags;	/* number of entries with tag */
+
+	unsigned int		idx_enabled : 1,	/* use source index */
+				idx_src_ready : 1;
+
+	/* cached btrfs default subvolume IDs, see tab.c */
+	struct libmnt_btrfsid	*btrfs_ids;
+	size_t			nbtrfs_ids;
+};
+
+/* btrfs default subvolume ID for the source device */
+struct libmnt_btrfsid {
+	char			*source;
+	uint64_t		id;
+};
+
+/* source index entry */
+struct libmnt_idxent {
+	uint64_t		key;	/* path hash or devno */
+	size_t			pos;	/* position in the table */
+	struct libmnt_fs	*fs;
 };
 
 extern struct libmnt_table *__mnt_new_table_from_file(const char *filename, int fmt, int empty_for_enoent);
@@ -269,6 +308,12 @@ enum {
 	MNT_FMT_SWAPS			/* /proc/swaps */
 };
 
+/*
+ * The first line of utab written by libmount with the utab journal (see
+ * tab_update.c); it's a comment for the other utab parsers
+ */
+#define MNT_UTAB_JOURNAL_HEADER	"#JOURNAL "	/* size of compacted file */
+
 /*
  * Additional mounts
  */
@@ -300,6 +345,7 @@ struct libmnt_context
 	struct libmnt_table *fstab;	/* fstab (or mtab for some remounts) entries */
 	struct libmnt_table *mtab;	/* mtab entries */
 	struct libmnt_table *utab;	/* rarely used by umount only */
+	struct libmnt_table *batch_utab; /* deferred mtab/utab entries (batch mount) */
 
 	int	(*table_errcb)(struct libmnt_table *tb,	/* callback for libmnt_table structs */
 			 const char *filename, int line);
@@ -387,6 +433,9 @@ struct libmnt_context
 /* Flags usable with MS_BIND|MS_REMOUNT */
 #define MNT_BIND_SETTABLE	(MS_NOSUID|MS_NODEV|MS_NOEXEC|MS_NOATIME|MS_NODIRATIME|MS_RELATIME|MS_RDONLY)
 
+/* cache.c */
+extern unsigned int mnt_hash_path(const char *path);
+
 /* lock.c */
 extern int mnt_lock_use_simplelock(struct libmnt_lock *ml, int enable);
 
@@ -405,6 +454,32 @@ extern int mnt_optstr_fix_uid(char **optstr, char *value, size_t valsz, char **n
 extern int mnt_optstr_fix_secontext(char **optstr, char *value, size_t valsz, char **next);
 extern int mnt_optstr_fix_user(char **optstr);
 
+struct libmnt_opt;
+struct libmnt_optlist;
+
+extern struct libmnt_optlist *mnt_new_optlist(void);
+extern void mnt_free_optlist(struct libmnt_optlist *ls);
+extern int mnt_optlist_register_map(struct libmnt_optlist *ls,
+			     const struct libmnt_optmap *map);
+extern int mnt_optlist_append_optstr(struct libmnt_optlist *ls, const char *optstr);
+extern int mnt_optlist_append_option(struct libmnt_optlist *ls,
+			     const char *name, const char *value);
+extern int mnt_optlist_prepend_option(struct libmnt_optlist *ls,
+			     const char *name, const char *value);
+extern void mnt_optlist_remove_opt(struct libmnt_optlist *ls, struct libmnt_opt *opt);
+extern struct libmnt_opt *mnt_optlist_get_opt(struct libmnt_optlist *ls,
+			     const char *name);
+extern struct libmnt_opt *mnt_optlist_first_opt(struct libmnt_optlist *ls);
+extern struct libmnt_opt *mnt_optlist_next_opt(struct libmnt_optlist *ls,
+			     struct libmnt_opt *opt);
+extern int mnt_optlist_to_string(struct libmnt_optlist *ls, char **optstr);
+
+extern int mnt_opt_set_value(struct libmnt_opt *opt, const char *value);
+extern const char *mnt_opt_get_name(struct libmnt_opt *opt);
+extern const char *mnt_opt_get_value(struct libmnt_opt *opt);
+extern const struct libmnt_optmap *mnt_opt_get_mapent(struct libmnt_opt *opt,
+			     const struct libmnt_optmap **map);
+
 /* fs.c */
 extern struct libmnt_fs *mnt_copy_mtab_fs(const struct libmnt_fs *fs)
 			__attribute__((nonnull));
@@ -412,6 +487,15 @@ extern int __mnt_fs_set_source_ptr(struct libmnt_fs *fs, char *source)
 			__attribute__((nonnull(1)));
 extern int __mnt_fs_set_fstype_ptr(struct libmnt_fs *fs, char *fstype)
 			__attribute__((nonnull(1)));
+extern void __mnt_fs_free_str(struct libmnt_fs *fs, size_t offset);
+extern int __mnt_fs_unshare_str(struct libmnt_fs *fs, size_t offset);
+
+/* Free (or unref) string member @_m of @_fs */
+#define mnt_fs_free_str(_fs, _m) \
+		__mnt_fs_free_str(_fs, offsetof(struct libmnt_fs, _m))
+/* Make private copy of the member @_m of @_fs before in-place modification */
+#define mnt_fs_unshare_str(_fs, _m) \
+		__mnt_fs_unshare_str(_fs, offsetof(struct libmnt_fs, _m))
 
 /* context.c */
 extern struct libmnt_context *mnt_copy_context(struct libmnt_context *o);
@@ -474,6 +558,11 @@ extern int mnt_update_set_filename(struct libmnt_update *upd,
 				   const char *filename, int userspace_only);
 extern int mnt_update_already_done(struct libmnt_update *upd,
 				   struct libmnt_lock *lc);
+extern int mnt_update_queue_entry(struct libmnt_update *upd,
+				  struct libmnt_table *queue);
+extern int mnt_update_add_entries(struct libmnt_update *upd,
+				  struct libmnt_table *entries,
+				  struct libmnt_lock *lc);
 
 #if __linux__
 /* btrfs.c */
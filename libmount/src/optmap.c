@@ -62,6 +62,11 @@
  * For more details about option map struct see "struct mnt_optmap" in
  * mount/mount.h.
  */
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+
+#include "fnv.h"
 #include "mountP.h"
 #include "strutils.h"
 
@@ -195,6 +200,133 @@ static const struct libmnt_optmap userspace_opts_map[] =
    { NULL, 0, 0 }
 };
 
+/*
+ * Hash index for the built-in maps
+ *
+ * The built-in maps are static and never modified, so it's enough to index
+ * them only once. The index is an open-addressing table where the slot
+ * contains (entry index + 1) and zero means an unused slot. The table size
+ * is more than twice the number of the entries in the maps, so the lookup
+ * usually needs only one string comparison.
+ *
+ * The MNT_PREFIX entries (e.g. "x-") are not hashed, they are checked
+ * separately if the name is not found in the table.
+ */
+#define MNT_OPTMAP_HASHSZ	256	/* must be power of 2 */
+#define MNT_OPTMAP_MAXPREFIX	4
+
+struct optmap_index {
+	const struct libmnt_optmap	*map;
+
+	unsigned char			slots[MNT_OPTMAP_HASHSZ];
+	unsigned char			prefixes[MNT_OPTMAP_MAXPREFIX];
+	size_t				nprefixes;
+};
+
+static struct optmap_index linux_flags_idx = { .map = linux_flags_map };
+static struct optmap_index userspace_opts_idx = { .map = userspace_opts_map };
+
+static inline unsigned int optmap_hash(const char *name, size_t namesz)
+{
+	uint64_t h = ul_fnv1a64_buf(UL_FNV64_INIT, name, namesz);
+
+	return ul_hash_mix64(h) & (MNT_OPTMAP_HASHSZ - 1);
+}
+
+/* returns size of the option name without "=" or "[=]" suffix */
+static inline size_t optmap_entry_namesz(const struct libmnt_optmap *ent)
+{
+	return strcspn(ent->name, "=[");
+}
+
+static void optmap_index_build(struct optmap_index *idx)
+{
+	const struct libmnt_optmap *ent;
+	unsigned char slots[MNT_OPTMAP_HASHSZ] = { 0 };
+	unsigned char prefixes[MNT_OPTMAP_MAXPREFIX] = { 0 };
+	size_t i, nprefixes = 0;
+
+	for (ent = idx->map, i = 0; ent->name; ent++, i++) {
+		unsigned int h;
+
+		assert(i < UCHAR_MAX);
+
+		if (ent->mask & MNT_PREFIX) {
+			assert(nprefixes < MNT_OPTMAP_MAXPREFIX);
+			prefixes[nprefixes++] = i + 1;
+			continue;
+		}
+		h = optmap_hash(ent->name, optmap_entry_namesz(ent));
+		while (slots[h])
+			h = (h + 1) & (MNT_OPTMAP_HASHSZ - 1);
+		slots[h] = i + 1;
+	}
+
+	memcpy(idx->slots, slots, sizeof(slots));
+	memcpy(idx->prefixes, prefixes, sizeof(prefixes));
+	idx->nprefixes = nprefixes;
+}
+
+static void optmap_build_indexes(void)
+{
+	optmap_index_build(&linux_flags_idx);
+	optmap_index_build(&userspace_opts_idx);
+}
+
+#ifdef HAVE_PTHREAD
+static pthread_once_t optmap_index_once = PTHREAD_ONCE_INIT;
+#else
+static int optmap_index_ready;
+#endif
+
+static struct optmap_index *optmap_get_index(const struct libmnt_optmap *map)
+{
+	struct optmap_index *idx;
+
+	if (map == linux_flags_map)
+		idx = &linux_flags_idx;
+	else if (map == userspace_opts_map)
+		idx = &userspace_opts_idx;
+	else
+		return NULL;
+
+	/* the indexes are shared by all threads, build them only once */
+#ifdef HAVE_PTHREAD
+	pthread_once(&optmap_index_once, optmap_build_indexes);
+#else
+	if (!optmap_index_ready) {
+		optmap_build_indexes();
+		optmap_index_ready = 1;
+	}
+#endif
+	return idx;
+}
+
+static const struct libmnt_optmap *optmap_index_lookup(
+				struct optmap_index *idx,
+				const char *name, size_t namesz)
+{
+	unsigned int h = optmap_hash(name, namesz);
+	size_t i;
+
+	while (idx->slots[h]) {
+		const struct libmnt_optmap *ent = &idx->map[idx->slots[h] - 1];
+
+		if (optmap_entry_namesz(ent) == namesz
+		    && strncmp(ent->name, name, namesz) == 0)
+			return ent;
+		h = (h + 1) & (MNT_OPTMAP_HASHSZ - 1);
+	}
+
+	for (i = 0; i < idx->nprefixes; i++) {
+		const struct libmnt_optmap *ent = &idx->map[idx->prefixes[i] - 1];
+
+		if (startswith(name, ent->name))
+			return ent;
+	}
+	return NULL;
+}
+
 /**
  * mnt_get_builtin_map:
  * @id: map id -- MNT_LINUX_MAP or MNT_USERSPACE_MAP
@@ -242,8 +374,20 @@ const struct libmnt_optmap *mnt_optmap_get_entry(
 	for (i = 0; i < nmaps; i++) {
 		const struct libmnt_optmap *map = maps[i];
 		const struct libmnt_optmap *ent;
+		struct optmap_index *idx;
 		const char *p;
 
+		idx = optmap_get_index(map);
+		if (idx) {
+			ent = optmap_index_lookup(idx, name, namelen);
+			if (ent) {
+				if (mapent)
+					*mapent = ent;
+				return map;
+			}
+			continue;
+		}
+
 		for (ent = map; ent && ent->name; ent++) {
 			if (ent->mask & MNT_PREFIX) {
 				if (startswith(name, ent->name)) {
@@ -195,6 +195,320 @@ static int __buffer_append_option(struct ul_buffer *buf,
 	return rc;
 }
 
+/*
+ * Parsed options list
+ *
+ * The list is private libmount stuff to modify options without re-parsing
+ * and re-allocating the options string for each operation. The string is
+ * parsed only once, the options are stored as separate items and the
+ * result is serialized to the string by mnt_optlist_to_string().
+ *
+ * The map entry for the option is resolved when the option is added to the
+ * list, so it's not necessary to search in maps again.
+ */
+struct libmnt_opt {
+	char	*name;
+	char	*value;		/* NULL or value (maybe empty string) */
+
+	const struct libmnt_optmap *map;	/* map where the option is defined */
+	const struct libmnt_optmap *ent;	/* map entry or NULL */
+
+	struct list_head opts;	/* libmnt_optlist->opts member */
+};
+
+#define MNT_OPTLIST_MAXMAPS	4
+
+struct libmnt_optlist {
+	struct libmnt_optmap const *maps[MNT_OPTLIST_MAXMAPS];
+	int			nmaps;
+
+	size_t			strsz;	/* estimated size of the options string */
+	struct list_head	opts;
+};
+
+struct libmnt_optlist *mnt_new_optlist(void)
+{
+	struct libmnt_optlist *ls = calloc(1, sizeof(*ls));
+
+	if (!ls)
+		return NULL;
+	INIT_LIST_HEAD(&ls->opts);
+	return ls;
+}
+
+void mnt_free_optlist(struct libmnt_optlist *ls)
+{
+	if (!ls)
+		return;
+
+	while (!list_empty(&ls->opts)) {
+		struct libmnt_opt *opt = list_entry(ls->opts.next,
+					struct libmnt_opt, opts);
+		mnt_optlist_remove_opt(ls, opt);
+	}
+	free(ls);
+}
+
+/*
+ * Registers map for options lookup. The map has to be registered before the
+ * options are added to the list.
+ */
+int mnt_optlist_register_map(struct libmnt_optlist *ls,
+			     const struct libmnt_optmap *map)
+{
+	int i;
+
+	if (!ls || !map)
+		return -EINVAL;
+
+	for (i = 0; i < ls->nmaps; i++) {
+		if (ls->maps[i] == map)
+			return 0;		/* already registered */
+	}
+	if (ls->nmaps == MNT_OPTLIST_MAXMAPS)
+		return -ERANGE;
+
+	ls->maps[ls->nmaps++] = map;
+	return 0;
+}
+
+static struct libmnt_opt *optlist_new_opt(struct libmnt_optlist *ls,
+			const char *name, size_t namesz,
+			const char *value, size_t valsz)
+{
+	struct libmnt_opt *opt = calloc(1, sizeof(*opt));
+
+	if (!opt)
+		return NULL;
+
+	INIT_LIST_HEAD(&opt->opts);
+
+	opt->name = strndup(name, namesz);
+	if (!opt->name)
+		goto fail;
+	if (value) {
+		opt->value = strndup(value, valsz);
+		if (!opt->value)
+			goto fail;
+	}
+
+	if (ls->nmaps) {
+		opt->map = mnt_optmap_get_entry(ls->maps, ls->nmaps,
+					name, namesz, &opt->ent);
+
+		/* ignore name=<value> if options map expects <name> only */
+		if (valsz && mnt_optmap_entry_novalue(opt->ent))
+			opt->map = opt->ent = NULL;
+	}
+
+	ls->strsz += namesz + valsz + 2;
+	return opt;
+fail:
+	free(opt->name);
+	free(opt);
+	return NULL;
+}
+
+/*
+ * Adds a new option to the end of the list. The @value may be NULL.
+ */
+int mnt_optlist_append_option(struct libmnt_optlist *ls,
+			const char *name, const char *value)
+{
+	struct libmnt_opt *opt;
+
+	if (!ls || !name || !*name)
+		return -EINVAL;
+
+	opt = optlist_new_opt(ls, name, strlen(name),
+				value, value ? strlen(value) : 0);
+	if (!opt)
+		return -ENOMEM;
+
+	list_add_tail(&opt->opts, &ls->opts);
+	return 0;
+}
+
+/*
+ * Adds a new option to the beginning of the list. The @value may be NULL.
+ */
+int mnt_optlist_prepend_option(struct libmnt_optlist *ls,
+			const char *name, const char *value)
+{
+	struct libmnt_opt *opt;
+
+	if (!ls || !name || !*name)
+		return -EINVAL;
+
+	opt = optlist_new_opt(ls, name, strlen(name),
+				value, value ? strlen(value) : 0);
+	if (!opt)
+		return -ENOMEM;
+
+	list_add(&opt->opts, &ls->opts);
+	return 0;
+}
+
+/*
+ * Parses @optstr and appends all the options to the list.
+ *
+ * Returns: 0 on success, <0 on error.
+ */
+int mnt_optlist_append_optstr(struct libmnt_optlist *ls, const char *optstr)
+{
+	char *name, *val, *str = (char *) optstr;
+	size_t namesz, valsz;
+	int rc;
+
+	if (!ls)
+		return -EINVAL;
+	if (!optstr)
+		return 0;
+
+	while ((rc = mnt_optstr_next_option(&str, &name, &namesz,
+						&val, &valsz)) == 0) {
+		struct libmnt_opt *opt = optlist_new_opt(ls, name, namesz,
+							val, valsz);
+		if (!opt)
+			return -ENOMEM;
+		list_add_tail(&opt->opts, &ls->opts);
+	}
+
+	return rc < 0 ? rc : 0;
+}
+
+/*
+ * Removes @opt from the list and deallocates it.
+ */
+void mnt_optlist_remove_opt(struct libmnt_optlist *ls, struct libmnt_opt *opt)
+{
+	if (!ls || !opt)
+		return;
+
+	list_del(&opt->opts);
+	free(opt->name);
+	free(opt->value);
+	free(opt);
+}
+
+/*
+ * Returns the first option with the @name or NULL.
+ */
+struct libmnt_opt *mnt_optlist_get_opt(struct libmnt_optlist *ls,
+			const char *name)
+{
+	struct list_head *p;
+
+	if (!ls || !name)
+		return NULL;
+
+	list_for_each(p, &ls->opts) {
+		struct libmnt_opt *opt = list_entry(p, struct libmnt_opt, opts);
+
+		if (strcmp(opt->name, name) == 0)
+			return opt;
+	}
+	return NULL;
+}
+
+/*
+ * Returns the first option in the list or NULL.
+ */
+struct libmnt_opt *mnt_optlist_first_opt(struct libmnt_optlist *ls)
+{
+	return ls ? list_first_entry(&ls->opts, struct libmnt_opt, opts) : NULL;
+}
+
+/*
+ * Returns the option behind @opt or NULL.
+ */
+struct libmnt_opt *mnt_optlist_next_opt(struct libmnt_optlist *ls,
+			struct libmnt_opt *opt)
+{
+	if (!ls || !opt || list_entry_is_last(&opt->opts, &ls->opts))
+		return NULL;
+	return list_entry(opt->opts.next, struct libmnt_opt, opts);
+}
+
+/*
+ * Sets the option value, the @value may be NULL to remove the value.
+ */
+int mnt_opt_set_value(struct libmnt_opt *opt, const char *value)
+{
+	char *p = NULL;
+
+	if (!opt)
+		return -EINVAL;
+	if (value) {
+		p = strdup(value);
+		if (!p)
+			return -ENOMEM;
+	}
+	free(opt->value);
+	opt->value = p;
+	return 0;
+}
+
+const char *mnt_opt_get_name(struct libmnt_opt *opt)
+{
+	return opt ? opt->name : NULL;
+}
+
+const char *mnt_opt_get_value(struct libmnt_opt *opt)
+{
+	return opt ? opt->value : NULL;
+}
+
+/*
+ * Returns the map entry for the option or NULL if the option is not defined
+ * in any registered map. The map is returned by @map.
+ */
+const struct libmnt_optmap *mnt_opt_get_mapent(struct libmnt_opt *opt,
+			const struct libmnt_optmap **map)
+{
+	if (map)
+		*map = opt ? opt->map : NULL;
+	return opt ? opt->ent : NULL;
+}
+
+/*
+ * Generates a new options string from the list. The string is allocated
+ * only once, the @optstr is set to NULL if the list is empty.
+ *
+ * Returns: 0 on success, <0 on error.
+ */
+int mnt_optlist_to_string(struct libmnt_optlist *ls, char **optstr)
+{
+	struct ul_buffer buf = UL_INIT_BUFFER;
+	struct list_head *p;
+	int rc = 0;
+
+	if (!ls || !optstr)
+		return -EINVAL;
+
+	*optstr = NULL;
+	if (list_empty(&ls->opts))
+		return 0;
+
+	ul_buffer_set_chunksize(&buf, ls->strsz + 1);
+
+	list_for_each(p, &ls->opts) {
+		struct libmnt_opt *opt = list_entry(p, struct libmnt_opt, opts);
+
+		rc = __buffer_append_option(&buf,
+				opt->name, strlen(opt->name),
+				opt->value, opt->value ? strlen(opt->value) : 0);
+		if (rc)
+			break;
+	}
+
+	if (rc)
+		ul_buffer_free_data(&buf);
+	else
+		*optstr = ul_buffer_get_data(&buf);
+	return rc;
+}
+
 /**
  * mnt_optstr_append_option:
  * @optstr: option string or NULL, returns a reallocated string
@@ -722,10 +1036,10 @@ int mnt_optstr_get_flags(const char *optstr, unsigned long *flags,
 int mnt_optstr_apply_flags(char **optstr, unsigned long flags,
 				const struct libmnt_optmap *map)
 {
-	struct libmnt_optmap const *maps[1];
-	char *name, *next, *val;
-	size_t namesz = 0, valsz = 0;
+	struct libmnt_optlist *ls;
+	struct libmnt_opt *opt;
 	unsigned long fl;
+	char *res = NULL;
 	int rc = 0;
 
 	if (!optstr || !map)
@@ -733,9 +1047,23 @@ int mnt_optstr_apply_flags(char **optstr, unsigned long flags,
 
 	DBG(CXT, ul_debug("applying 0x%08lx flags to '%s'", flags, *optstr));
 
-	maps[0] = map;
-	next = *optstr;
+	/*
+	 * The options string is parsed only once, all the changes are
+	 * applied to the list and the list is converted back to the string
+	 * at the end.
+	 */
+	ls = mnt_new_optlist();
+	if (!ls)
+		return -ENOMEM;
+
+	rc = mnt_optlist_register_map(ls, map);
+	if (!rc)
+		rc = mnt_optlist_append_optstr(ls, *optstr);
+	if (rc)
+		goto err;
+
 	fl = flags;
+	opt = mnt_optlist_first_opt(ls);
 
 	/*
 	 * There is a convention that 'rw/ro' flags are always at the beginning of
@@ -744,75 +1072,57 @@ int mnt_optstr_apply_flags(char **optstr, unsigned long flags,
 	if (map == mnt_get_builtin_optmap(MNT_LINUX_MAP)) {
 		const char *o = (fl & MS_RDONLY) ? "ro" : "rw";
 
-		if (next &&
-		    (!strncmp(next, "rw", 2) || !strncmp(next, "ro", 2)) &&
-		    (*(next + 2) == '\0' || *(next + 2) == ',')) {
+		if (opt && !opt->value &&
+		    (!strcmp(opt->name, "rw") || !strcmp(opt->name, "ro"))) {
 
 			/* already set, be paranoid and fix it */
-			memcpy(next, o, 2);
+			memcpy(opt->name, o, 2);
 		} else {
-			rc = mnt_optstr_prepend_option(optstr, o, NULL);
+			rc = mnt_optlist_prepend_option(ls, o, NULL);
 			if (rc)
 				goto err;
-			next = *optstr;		/* because realloc() */
+			opt = mnt_optlist_first_opt(ls);
 		}
 		fl &= ~MS_RDONLY;
-		next += 2;
-		if (*next == ',')
-			next++;
+		opt = mnt_optlist_next_opt(ls, opt);
 	}
 
-	if (next && *next) {
-		/*
-		 * scan @optstr and remove options that are missing in
-		 * @flags
-		 */
-		while(!mnt_optstr_next_option(&next, &name, &namesz,
-							&val, &valsz)) {
-			const struct libmnt_optmap *ent;
-
-			if (mnt_optmap_get_entry(maps, 1, name, namesz, &ent)) {
-				/*
-				 * remove unwanted option (rw/ro is already set)
-				 */
-				if (!ent || !ent->id)
-					continue;
-				/* ignore name=<value> if options map expects <name> only */
-				if (valsz && mnt_optmap_entry_novalue(ent))
-					continue;
-
-				if (ent->id == MS_RDONLY ||
-				    (ent->mask & MNT_INVERT) ||
-				    (fl & ent->id) != (unsigned long) ent->id) {
-
-					char *end = val ? val + valsz :
-							  name + namesz;
-					next = name;
-					rc = mnt_optstr_remove_option_at(
-							optstr, name, end);
-					if (rc)
-						goto err;
-				}
-				if (!(ent->mask & MNT_INVERT)) {
-					fl &= ~ent->id;
-					if (ent->id & MS_REC)
-						fl |= MS_REC;
-				}
+	/*
+	 * scan the options and remove options that are missing in @flags
+	 */
+	while (opt) {
+		struct libmnt_opt *next = mnt_optlist_next_opt(ls, opt);
+		const struct libmnt_optmap *ent = opt->ent;
+
+		/* ignore undefined options and name=<value> if options map
+		 * expects <name> only (see optlist_new_opt()) */
+		if (ent && ent->id) {
+			/*
+			 * remove unwanted option (rw/ro is already set)
+			 */
+			if (ent->id == MS_RDONLY ||
+			    (ent->mask & MNT_INVERT) ||
+			    (fl & ent->id) != (unsigned long) ent->id)
+				mnt_optlist_remove_opt(ls, opt);
+
+			if (!(ent->mask & MNT_INVERT)) {
+				fl &= ~ent->id;
+				if (ent->id & MS_REC)
+					fl |= MS_REC;
 			}
 		}
+		opt = next;
 	}
 
 	/* add missing options (but ignore fl if contains MS_REC only) */
 	if (fl && fl != MS_REC) {
-
 		const struct libmnt_optmap *ent;
-		struct ul_buffer buf = UL_INIT_BUFFER;
-		size_t sz;
 		char *p;
 
-		ul_buffer_refer_string(&buf, *optstr);
-
 		for (ent = map; ent && ent->name; ent++) {
+			struct libmnt_opt *o;
+			size_t sz;
+
 			if ((ent->mask & MNT_INVERT)
 			    || ent->id == 0
 			    || (fl & ent->id) != (unsigned long) ent->id)
@@ -829,17 +1139,38 @@ int mnt_optstr_apply_flags(char **optstr, unsigned long flags,
 			} else
 				sz = strlen(ent->name);
 
-			rc = __buffer_append_option(&buf, ent->name, sz, NULL, 0);
-			if (rc)
+			/* the name is not terminated in the map entry */
+			o = optlist_new_opt(ls, ent->name, sz, NULL, 0);
+			if (!o) {
+				rc = -ENOMEM;
 				goto err;
+			}
+			list_add_tail(&o->opts, &ls->opts);
 		}
+	}
 
-		*optstr = ul_buffer_get_data(&buf);
+	rc = mnt_optlist_to_string(ls, &res);
+	if (rc)
+		goto err;
+
+	/* keep empty string rather than NULL if the original string has
+	 * been defined */
+	if (!res && *optstr) {
+		res = strdup("");
+		if (!res) {
+			rc = -ENOMEM;
+			goto err;
+		}
 	}
 
+	free(*optstr);
+	*optstr = res;
+	mnt_free_optlist(ls);
+
 	DBG(CXT, ul_debug("new optstr '%s'", *optstr));
-	return rc;
+	return 0;
 err:
+	mnt_free_optlist(ls);
 	DBG(CXT, ul_debug("failed to apply flags [rc=%d]", rc));
 	return rc;
 }
@@ -1372,6 +1703,71 @@ static int test_dedup(struct libmnt_test *ts, int argc, char *argv[])
 	return rc;
 }
 
+static int test_optlist(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_optlist *ls;
+	char *optstr = NULL;
+	int i, rc;
+
+	if (argc < 2)
+		return -EINVAL;
+
+	ls = mnt_new_optlist();
+	if (!ls)
+		return -ENOMEM;
+
+	mnt_optlist_register_map(ls, mnt_get_builtin_optmap(MNT_LINUX_MAP));
+	mnt_optlist_register_map(ls, mnt_get_builtin_optmap(MNT_USERSPACE_MAP));
+
+	rc = mnt_optlist_append_optstr(ls, argv[1]);
+
+	/* +name[=value] appends, -name removes, name[=value] sets */
+	for (i = 2; rc == 0 && i < argc; i++) {
+		char *name = argv[i], *val = strchr(name, '=');
+		struct libmnt_opt *opt;
+		int op = *name;
+
+		if (val)
+			*val++ = '\0';
+		if (op == '+' || op == '-')
+			name++;
+
+		opt = mnt_optlist_get_opt(ls, name);
+		if (op == '+')
+			rc = mnt_optlist_append_option(ls, name, val);
+		else if (op == '-')
+			mnt_optlist_remove_opt(ls, opt);
+		else if (opt)
+			rc = mnt_opt_set_value(opt, val);
+		else
+			rc = mnt_optlist_append_option(ls, name, val);
+	}
+
+	if (!rc) {
+		struct libmnt_opt *opt = mnt_optlist_first_opt(ls);
+
+		for ( ; opt; opt = mnt_optlist_next_opt(ls, opt)) {
+			const struct libmnt_optmap *map = NULL;
+			const struct libmnt_optmap *ent = mnt_opt_get_mapent(opt, &map);
+
+			printf("%-12s %-10s %s\n", mnt_opt_get_name(opt),
+				mnt_opt_get_value(opt) ? : "",
+				!ent ? "fs" :
+				map == mnt_get_builtin_optmap(MNT_LINUX_MAP) ? "linux" :
+				"userspace");
+		}
+	}
+
+	if (!rc)
+		rc = mnt_optlist_to_string(ls, &optstr);
+	if (!rc)
+		printf("result: >%s<\n", optstr);
+
+	free(optstr);
+	mnt_free_optlist(ls);
+	return rc;
+}
+
 static int test_fix(struct libmnt_test *ts, int argc, char *argv[])
 {
 	char *optstr;
@@ -1420,6 +1816,7 @@ int main(int argc, char *argv[])
 		{ "--flags",  test_flags,  "<optstr>                   convert options to MS_* flags" },
 		{ "--apply",  test_apply,  "--{linux,user} <optstr> <mask>    apply mask to optstr" },
 		{ "--fix",    test_fix,    "<optstr>                   fix uid=, gid=, user, and context=" },
+		{ "--list",   test_optlist,"<optstr> [[+-]<name>[=<value>] ...]  modify parsed options list" },
 
 		{ NULL }
 	};
@@ -93,6 +93,17 @@ struct libmnt_table *mnt_new_table(void)
 	return tb;
 }
 
+static void table_reset_btrfs_ids(struct libmnt_table *tb)
+{
+	size_t i;
+
+	for (i = 0; i < tb->nbtrfs_ids; i++)
+		free(tb->btrfs_ids[i].source);
+	free(tb->btrfs_ids);
+	tb->btrfs_ids = NULL;
+	tb->nbtrfs_ids = 0;
+}
+
 /**
  * mnt_reset_table:
  * @tb: tab pointer
@@ -116,6 +127,8 @@ int mnt_reset_table(struct libmnt_table *tb)
 	}
 
 	tb->nents = 0;
+	mnt_table_reset_index(tb);
+	table_reset_btrfs_ids(tb);
 	return 0;
 }
 
@@ -259,6 +272,32 @@ void mnt_table_enable_comments(struct libmnt_table *tb, int enable)
 		tb->comms = enable;
 }
 
+/**
+ * mnt_table_enable_index:
+ * @tb: pointer to tab
+ * @enable: TRUE or FALSE
+ *
+ * Enables index for source lookups in mnt_table_is_fs_mounted(),
+ * mnt_table_find_srcpath() and mnt_table_find_source(). The index is
+ * generated on the first lookup and it's dropped on any table change.
+ *
+ * It's recommended if many filesystems are checked against the same table,
+ * for example "mount -a" or "fsck -A".
+ *
+ * Returns: 0 on success, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_table_enable_index(struct libmnt_table *tb, int enable)
+{
+	if (!tb)
+		return -EINVAL;
+	if (!enable)
+		mnt_table_reset_index(tb);
+	tb->idx_enabled = enable ? 1 : 0;
+	return 0;
+}
+
 /**
  * mnt_table_with_comments:
  * @tb: pointer to table
@@ -452,6 +491,7 @@ int mnt_table_add_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 	list_add_tail(&fs->ents, &tb->ents);
 	fs->tab = tb;
 	tb->nents++;
+	mnt_table_reset_index(tb);
 
 	DBG(TAB, ul_debugobj(tb, "add entry: %s %s",
 			mnt_fs_get_source(fs), mnt_fs_get_target(fs)));
@@ -471,6 +511,7 @@ static int __table_insert_fs(
 
 	fs->tab = tb;
 	tb->nents++;
+	mnt_table_reset_index(tb);
 
 	DBG(TAB, ul_debugobj(tb, "insert entry: %s %s",
 			mnt_fs_get_source(fs), mnt_fs_get_target(fs)));
@@ -542,6 +583,7 @@ int mnt_table_move_fs(struct libmnt_table *src, struct libmnt_table *dst,
 	/* remove from source */
 	list_del_init(&fs->ents);
 	src->nents--;
+	mnt_table_reset_index(src);
 
 	/* insert to the destination */
 	return __table_insert_fs(dst, before, pos, fs);
@@ -569,15 +611,257 @@ int mnt_table_remove_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 
 	mnt_unref_fs(fs);
 	tb->nents--;
+	mnt_table_reset_index(tb);
+	return 0;
+}
+
+/*
+ * Unlinks @fs from its table without reference counting. It's used by
+ * mnt_reset_fs() to not keep the @fs in the list or in the table indexes.
+ */
+void mnt_table_unlink_fs(struct libmnt_fs *fs)
+{
+	struct libmnt_table *tb = fs->tab;
+
+	if (!tb)
+		return;
+
+	fs->tab = NULL;
+	list_del_init(&fs->ents);
+	tb->nents--;
+	mnt_table_reset_index(tb);
+}
+
+/*
+ * Mountinfo tree index
+ *
+ * The parent->child relation is defined by IDs only, so it would be
+ * necessary to scan the whole table to get children of the filesystem. The
+ * index keeps the filesystems in two arrays sorted by (parent ID, ID) and by
+ * ID; the children of the filesystem are continuous range in the first array.
+ *
+ * The index is generated on demand and it's dropped on any table change.
+ */
+void mnt_table_reset_index(struct libmnt_table *tb)
+{
+	free(tb->idx_by_parent);
+	free(tb->idx_by_id);
+	tb->idx_by_parent = NULL;
+	tb->idx_by_id = NULL;
+	tb->idx_nents = 0;
+
+	free(tb->idx_by_src);
+	free(tb->idx_by_devno);
+	free(tb->idx_loops);
+	tb->idx_by_src = NULL;
+	tb->idx_by_devno = NULL;
+	tb->idx_loops = NULL;
+	tb->idx_src_nents = tb->idx_devno_nents = tb->idx_nloops = 0;
+	tb->idx_ntags = 0;
+	tb->idx_src_ready = 0;
+}
+
+static int cmp_fs_by_parent(const void *a, const void *b)
+{
+	const struct libmnt_fs *x = *(const struct libmnt_fs **) a;
+	const struct libmnt_fs *y = *(const struct libmnt_fs **) b;
+
+	if (x->parent != y->parent)
+		return x->parent < y->parent ? -1 : 1;
+	if (x->id != y->id)
+		return x->id < y->id ? -1 : 1;
 	return 0;
 }
 
+static int cmp_fs_by_id(const void *a, const void *b)
+{
+	const struct libmnt_fs *x = *(const struct libmnt_fs **) a;
+	const struct libmnt_fs *y = *(const struct libmnt_fs **) b;
+
+	if (x->id != y->id)
+		return x->id < y->id ? -1 : 1;
+	return 0;
+}
+
+static int table_init_index(struct libmnt_table *tb)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	size_t n = 0;
+
+	if (tb->idx_nents)
+		return 0;
+	if (!tb->nents)
+		return 1;
+
+	DBG(TAB, ul_debugobj(tb, "generate tree index"));
+
+	tb->idx_by_parent = malloc(tb->nents * sizeof(struct libmnt_fs *));
+	tb->idx_by_id = malloc(tb->nents * sizeof(struct libmnt_fs *));
+	if (!tb->idx_by_parent || !tb->idx_by_id) {
+		mnt_table_reset_index(tb);
+		return -ENOMEM;
+	}
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0 && n < (size_t) tb->nents)
+		tb->idx_by_parent[n++] = fs;
+
+	memcpy(tb->idx_by_id, tb->idx_by_parent, n * sizeof(struct libmnt_fs *));
+	qsort(tb->idx_by_parent, n, sizeof(struct libmnt_fs *), cmp_fs_by_parent);
+	qsort(tb->idx_by_id, n, sizeof(struct libmnt_fs *), cmp_fs_by_id);
+
+	tb->idx_nents = n;
+	return 0;
+}
+
+/* returns the first position in idx_by_parent[] where (parent, id) >= (@parent_id, @id) */
+static size_t index_lower_bound(struct libmnt_table *tb, int parent_id, int id)
+{
+	size_t lo = 0, hi = tb->idx_nents;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		struct libmnt_fs *x = tb->idx_by_parent[mid];
+
+		if (x->parent < parent_id ||
+		    (x->parent == parent_id && x->id < id))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static struct libmnt_fs *index_find_id(struct libmnt_table *tb, int id)
+{
+	size_t lo = 0, hi = tb->idx_nents;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		struct libmnt_fs *x = tb->idx_by_id[mid];
+
+		if (x->id == id)
+			return x;
+		if (x->id < id)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
+/*
+ * Source index
+ *
+ * mnt_table_is_fs_mounted() and mnt_table_find_srcpath() compare the source
+ * with all entries in the table, so "mount -a" or "fsck -A" is
+ * O(fstab x mountinfo). The index keeps the entries sorted by source path
+ * hash and by devno, and a list of entries with loop device source (the
+ * backing file has to be compared by loopdev_is_used()). The lookups compare
+ * only these candidates.
+ *
+ * The index has to be enabled by mnt_table_enable_index(), it's generated on
+ * demand and it's dropped on any table change.
+ */
+static int cmp_idxent(const void *a, const void *b)
+{
+	const struct libmnt_idxent *x = (const struct libmnt_idxent *) a;
+	const struct libmnt_idxent *y = (const struct libmnt_idxent *) b;
+
+	if (x->key != y->key)
+		return x->key < y->key ? -1 : 1;
+	if (x->pos != y->pos)
+		return x->pos < y->pos ? -1 : 1;
+	return 0;
+}
+
+static int table_init_srcindex(struct libmnt_table *tb)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	size_t pos = 0;
+
+	if (!tb->idx_enabled)
+		return 1;
+	if (tb->idx_src_ready)
+		return 0;
+	if (!tb->nents)
+		return 1;
+
+	DBG(TAB, ul_debugobj(tb, "generate source index"));
+
+	tb->idx_by_src = malloc(tb->nents * sizeof(struct libmnt_idxent));
+	tb->idx_by_devno = malloc(tb->nents * sizeof(struct libmnt_idxent));
+	tb->idx_loops = malloc(tb->nents * sizeof(struct libmnt_fs *));
+	if (!tb->idx_by_src || !tb->idx_by_devno || !tb->idx_loops) {
+		mnt_table_reset_index(tb);
+		return -ENOMEM;
+	}
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0 && pos < (size_t) tb->nents) {
+		const char *src = mnt_fs_get_srcpath(fs);
+		dev_t devno = mnt_fs_get_devno(fs);
+
+		if (src) {
+			struct libmnt_idxent *e = &tb->idx_by_src[tb->idx_src_nents++];
+
+			e->key = mnt_hash_path(src);
+			e->pos = pos;
+			e->fs = fs;
+			if (startswith(src, "/dev/loop"))
+				tb->idx_loops[tb->idx_nloops++] = fs;
+
+		} else if (mnt_fs_get_tag(fs, NULL, NULL) == 0)
+			tb->idx_ntags++;
+
+		if (devno) {
+			struct libmnt_idxent *e = &tb->idx_by_devno[tb->idx_devno_nents++];
+
+			e->key = devno;
+			e->pos = pos;
+			e->fs = fs;
+		}
+		pos++;
+	}
+
+	qsort(tb->idx_by_src, tb->idx_src_nents, sizeof(struct libmnt_idxent), cmp_idxent);
+	qsort(tb->idx_by_devno, tb->idx_devno_nents, sizeof(struct libmnt_idxent), cmp_idxent);
+
+	tb->idx_src_ready = 1;
+	return 0;
+}
+
+/* returns the first entry with @key in the sorted @ary, @n is number of the entries with the key */
+static struct libmnt_idxent *srcindex_lookup(struct libmnt_idxent *ary, size_t nents,
+					     uint64_t key, size_t *n)
+{
+	size_t lo = 0, hi = nents, end;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (ary[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (end = lo; end < nents && ary[end].key == key; end++);
+
+	*n = end - lo;
+	return *n ? &ary[lo] : NULL;
+}
+
 static inline struct libmnt_fs *get_parent_fs(struct libmnt_table *tb, struct libmnt_fs *fs)
 {
 	struct libmnt_iter itr;
 	struct libmnt_fs *x;
 	int parent_id = mnt_fs_get_parent_id(fs);
 
+	if (table_init_index(tb) == 0)
+		return index_find_id(tb, parent_id);
+
 	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
 	while (mnt_table_next_fs(tb, &itr, &x) == 0) {
 		if (mnt_fs_get_id(x) == parent_id)
@@ -676,6 +960,29 @@ int mnt_table_next_child_fs(struct libmnt_table *tb, struct libmnt_iter *itr,
 
 	*chld = NULL;
 
+	/* no more children possible */
+	if (lastchld_id == INT_MAX)
+		goto done;
+
+	if (table_init_index(tb) == 0) {
+		/* the first child with ID greater than the last child */
+		size_t i = index_lower_bound(tb, parent_id,
+				lastchld_id ? lastchld_id + 1 : INT_MIN);
+
+		for (; i < tb->idx_nents; i++) {
+			fs = tb->idx_by_parent[i];
+
+			if (fs->parent != parent_id)
+				break;
+			/* avoid an infinite loop, see below */
+			if (fs->id == parent_id)
+				continue;
+			*chld = fs;
+			break;
+		}
+		goto done;
+	}
+
 	mnt_reset_iter(itr, MNT_ITER_FORWARD);
 	while(mnt_table_next_fs(tb, itr, &fs) == 0) {
 		int id;
@@ -696,7 +1003,7 @@ int mnt_table_next_child_fs(struct libmnt_table *tb, struct libmnt_iter *itr,
 			chld_id = id;
 		}
 	}
-
+done:
 	if (!*chld)
 		return 1;	/* end of iterator */
 
@@ -827,6 +1134,7 @@ static int mnt_table_move_parent(struct libmnt_table *tb, int oldid, int newid)
 		return 0;
 
 	DBG(TAB, ul_debugobj(tb, "moving parent ID from %d -> %d", oldid, newid));
+	mnt_table_reset_index(tb);
 	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
 
 	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
@@ -1060,6 +1368,98 @@ struct libmnt_fs *mnt_table_find_target(struct libmnt_table *tb, const char *pat
 	return NULL;
 }
 
+#ifdef HAVE_BTRFS_SUPPORT
+/*
+ * Returns the default subvolume ID for mounted btrfs @fs.
+ *
+ * The default subvolume is per-filesystem setting, but it's necessary to open
+ * the mountpoint and call ioctl to get it. The result is cached in the table
+ * for the source device, so all subvolumes of the same filesystem share one
+ * ioctl. The cache is dropped by mnt_reset_table(), so re-read the table
+ * after a mount change (see libmnt_monitor) to get a fresh setting.
+ */
+static uint64_t table_get_btrfs_default_id(struct libmnt_table *tb, struct libmnt_fs *fs)
+{
+	const char *src = mnt_fs_get_srcpath(fs);
+	struct libmnt_btrfsid *ids;
+	uint64_t id;
+	size_t i;
+
+	for (i = 0; src && i < tb->nbtrfs_ids; i++) {
+		if (strcmp(tb->btrfs_ids[i].source, src) == 0) {
+			DBG(BTRFS, ul_debug("%s: cached default subvolid %llu", src,
+					(unsigned long long) tb->btrfs_ids[i].id));
+			return tb->btrfs_ids[i].id;
+		}
+	}
+
+	id = btrfs_get_default_subvol_id(mnt_fs_get_target(fs));
+	if (!src)
+		return id;
+
+	ids = realloc(tb->btrfs_ids, (tb->nbtrfs_ids + 1) * sizeof(struct libmnt_btrfsid));
+	if (!ids)
+		return id;
+	tb->btrfs_ids = ids;
+	ids[tb->nbtrfs_ids].source = strdup(src);
+	if (ids[tb->nbtrfs_ids].source)
+		ids[tb->nbtrfs_ids++].id = id;
+	return id;
+}
+#endif /* HAVE_BTRFS_SUPPORT */
+
+/*
+ * Returns 1 if @fs source is @path. For btrfs (if @btrfs is true) only the
+ * default subvolume matches.
+ */
+static int is_srcpath_match(struct libmnt_table *tb __attribute__((__unused__)),
+			    struct libmnt_fs *fs, const char *path,
+			    int btrfs __attribute__((__unused__)))
+{
+	if (!mnt_fs_streq_srcpath(fs, path))
+		return 0;
+#ifdef HAVE_BTRFS_SUPPORT
+	if (btrfs && fs->fstype && !strcmp(fs->fstype, "btrfs")) {
+		uint64_t default_id = table_get_btrfs_default_id(tb, fs);
+		char *val;
+		size_t len;
+
+		if (default_id == UINT64_MAX)
+			DBG(TAB, ul_debug("not found btrfs volume setting"));
+
+		else if (mnt_fs_get_option(fs, "subvolid", &val, &len) == 0) {
+			uint64_t subvol_id;
+
+			if (mnt_parse_offset(val, len, &subvol_id)) {
+				DBG(TAB, ul_debugobj(tb, "failed to parse subvolid="));
+				return 0;
+			}
+			if (subvol_id != default_id)
+				return 0;
+		}
+	}
+#endif /* HAVE_BTRFS_SUPPORT */
+	return 1;
+}
+
+/* like is_srcpath_match() for all entries, but compares index candidates only */
+static struct libmnt_fs *srcindex_find_srcpath(struct libmnt_table *tb,
+			const char *path, int direction, int btrfs)
+{
+	struct libmnt_idxent *ent;
+	size_t i, n = 0;
+
+	ent = srcindex_lookup(tb->idx_by_src, tb->idx_src_nents,
+				mnt_hash_path(path), &n);
+	for (i = 0; i < n; i++) {
+		struct libmnt_fs *fs = ent[direction == MNT_ITER_FORWARD ? i : n - 1 - i].fs;
+
+		if (is_srcpath_match(tb, fs, path, btrfs))
+			return fs;
+	}
+	return NULL;
+}
+
 /**
  * mnt_table_find_srcpath:
  * @tb: tab pointer
@@ -1084,7 +1484,7 @@ struct libmnt_fs *mnt_table_find_srcpath(struct libmnt_table *tb, const char *pa
 {
 	struct libmnt_iter itr;
 	struct libmnt_fs *fs = NULL;
-	int ntags = 0, nents;
+	int ntags = 0, nents, indexed;
 	char *cn;
 	const char *p;
 
@@ -1095,37 +1495,23 @@ struct libmnt_fs *mnt_table_find_srcpath(struct libmnt_table *tb, const char *pa
 
 	DBG(TAB, ul_debugobj(tb, "lookup SRCPATH: '%s'", path));
 
-	/* native paths */
-	mnt_reset_iter(&itr, direction);
-
-	while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-
-		if (mnt_fs_streq_srcpath(fs, path)) {
-#ifdef HAVE_BTRFS_SUPPORT
-			if (fs->fstype && !strcmp(fs->fstype, "btrfs")) {
-				uint64_t default_id = btrfs_get_default_subvol_id(mnt_fs_get_target(fs));
-				char *val;
-				size_t len;
-
-				if (default_id == UINT64_MAX)
-					DBG(TAB, ul_debug("not found btrfs volume setting"));
-
-				else if (mnt_fs_get_option(fs, "subvolid", &val, &len) == 0) {
-					uint64_t subvol_id;
+	indexed = table_init_srcindex(tb) == 0;
 
-					if (mnt_parse_offset(val, len, &subvol_id)) {
-						DBG(TAB, ul_debugobj(tb, "failed to parse subvolid="));
-						continue;
-					}
-					if (subvol_id != default_id)
-						continue;
-				}
-			}
-#endif /* HAVE_BTRFS_SUPPORT */
+	/* native paths */
+	if (indexed) {
+		fs = srcindex_find_srcpath(tb, path, direction, 1);
+		if (fs)
 			return fs;
+		ntags = tb->idx_ntags;
+	} else {
+		mnt_reset_iter(&itr, direction);
+
+		while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
+			if (is_srcpath_match(tb, fs, path, 1))
+				return fs;
+			if (mnt_fs_get_tag(fs, NULL, NULL) == 0)
+				ntags++;
 		}
-		if (mnt_fs_get_tag(fs, NULL, NULL) == 0)
-			ntags++;
 	}
 
 	if (!path || !tb->cache || !(cn = mnt_resolve_path(path, tb->cache)))
@@ -1137,10 +1523,16 @@ struct libmnt_fs *mnt_table_find_srcpath(struct libmnt_table *tb, const char *pa
 
 	/* canonicalized paths in struct libmnt_table */
 	if (ntags < nents) {
-		mnt_reset_iter(&itr, direction);
-		while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
-			if (mnt_fs_streq_srcpath(fs, cn))
+		if (indexed) {
+			fs = srcindex_find_srcpath(tb, cn, direction, 0);
+			if (fs)
 				return fs;
+		} else {
+			mnt_reset_iter(&itr, direction);
+			while(mnt_table_next_fs(tb, &itr, &fs) == 0) {
+				if (mnt_fs_streq_srcpath(fs, cn))
+					return fs;
+			}
 		}
 	}
 
@@ -1409,6 +1801,20 @@ static char *remove_mountpoint_from_path(const char *path, const char *mnt)
 }
 
 #ifdef HAVE_BTRFS_SUPPORT
+/* returns the top-most btrfs filesystem mounted on @target */
+static struct libmnt_fs *find_btrfs_target(struct libmnt_table *tb, const char *target)
+{
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs = NULL;
+
+	mnt_reset_iter(&itr, MNT_ITER_BACKWARD);
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+		if (mnt_fs_streq_target(fs, target))
+			return fs->fstype && strcmp(fs->fstype, "btrfs") == 0 ? fs : NULL;
+	}
+	return NULL;
+}
+
 static int get_btrfs_fs_root(struct libmnt_table *tb, struct libmnt_fs *fs, char **root)
 {
 	char *vol = NULL, *p;
@@ -1459,9 +1865,20 @@ static int get_btrfs_fs_root(struct libmnt_table *tb, struct libmnt_fs *fs, char
 
 		DBG(BTRFS, ul_debug(" subvolid/subvol not found, checking default"));
 
-		default_id = btrfs_get_default_subvol_id(mnt_fs_get_target(fs));
-		if (default_id == UINT64_MAX)
+		target = mnt_resolve_target(mnt_fs_get_target(fs), tb->cache);
+		if (!target)
+			goto err;
+
+		/* The default subvolume is evaluated on the filesystem
+		 * mounted on the target, it's cached for the source device.
+		 */
+		f = find_btrfs_target(tb, target);
+		default_id = f ? table_get_btrfs_default_id(tb, f) : UINT64_MAX;
+		if (default_id == UINT64_MAX) {
+			if (!tb->cache)
+				free(target);
 			goto not_found;
+		}
 
 		/* Volume has default subvolume. Check if it matches to
 		 * the one in mountinfo.
@@ -1470,10 +1887,6 @@ static int get_btrfs_fs_root(struct libmnt_table *tb, struct libmnt_fs *fs, char
 		 * kernels, there is no reasonable way to detect which
 		 * subvolume was mounted.
 		 */
-		target = mnt_resolve_target(mnt_fs_get_target(fs), tb->cache);
-		if (!target)
-			goto err;
-
 		snprintf(default_id_str, sizeof(default_id_str), "%llu",
 				(unsigned long long int) default_id);
 
@@ -1654,17 +2067,65 @@ err:
 }
 
 
+/*
+ * The index candidates for __mnt_table_is_fs_mounted(): entries with the
+ * same source path hash, entries with the same devno and entries with loop
+ * device source (only if the source may be a loop device backing file).
+ */
+struct srcindex_cands {
+	struct libmnt_idxent	*bysrc, *bydev;
+	size_t			nsrc, ndev, nloops;
+	size_t			pos;
+};
+
+/* returns 0 on success or 1 if the index is not available */
+static int srcindex_init_cands(struct libmnt_table *tb, struct srcindex_cands *ca,
+			       const char *src, dev_t devno, int loops)
+{
+	memset(ca, 0, sizeof(*ca));
+
+	if (table_init_srcindex(tb) != 0)
+		return 1;
+
+	ca->bysrc = srcindex_lookup(tb->idx_by_src, tb->idx_src_nents,
+				mnt_hash_path(src), &ca->nsrc);
+	if (devno)
+		ca->bydev = srcindex_lookup(tb->idx_by_devno, tb->idx_devno_nents,
+				devno, &ca->ndev);
+	if (loops)
+		ca->nloops = tb->idx_nloops;
+	return 0;
+}
+
+static struct libmnt_fs *srcindex_next_cand(struct libmnt_table *tb,
+					    struct srcindex_cands *ca)
+{
+	size_t i = ca->pos++;
+
+	if (i < ca->nsrc)
+		return ca->bysrc[i].fs;
+	i -= ca->nsrc;
+	if (i < ca->ndev)
+		return ca->bydev[i].fs;
+	i -= ca->ndev;
+	if (i < ca->nloops)
+		return tb->idx_loops[i];
+	return NULL;
+}
+
 int __mnt_table_is_fs_mounted(struct libmnt_table *tb, struct libmnt_fs *fstab_fs,
 			      const char *tgt_prefix)
 {
 	struct libmnt_iter itr;
 	struct libmnt_fs *fs;
+	struct srcindex_cands cands;
+	struct stat st;
 
 	char *root = NULL;
 	char *src2 = NULL;
 	const char *src = NULL, *tgt = NULL;
 	char *xtgt = NULL, *tgt_buf = NULL;
-	int rc = 0;
+	int rc = 0, loops, indexed;
 	dev_t devno = 0;
 
 	DBG(FS, ul_debugobj(fstab_fs, "mnt_table_is_fs_mounted: target=%s, source=%s",
@@ -1706,8 +2167,6 @@ int __mnt_table_is_fs_mounted(struct libmnt_table *tb, struct libmnt_fs *fstab_f
 		src = mnt_resolve_spec(src, tb->cache);
 
 	if (src && root) {
-		struct stat st;
-
 		devno = mnt_fs_get_devno(fstab_fs);
 		if (!devno && stat(src, &st) == 0 && S_ISBLK(st.st_mode))
 			devno = st.st_rdev;
@@ -1719,13 +2178,28 @@ int __mnt_table_is_fs_mounted(struct libmnt_table *tb, struct libmnt_fs *fstab_f
 		DBG(FS, ul_debugobj(fstab_fs, "- ignore (no source/target)"));
 		goto done;
 	}
+
+	/* Loop device backing file is a regular file or a block device. If
+	 * stat() fails, loopdev_is_used() still compares the backing file name.
+	 */
+	loops = stat(src, &st) != 0 || S_ISREG(st.st_mode) || S_ISBLK(st.st_mode);
+
 	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	indexed = srcindex_init_cands(tb, &cands, src, devno, loops) == 0;
 
 	DBG(FS, ul_debugobj(fstab_fs, "mnt_table_is_fs_mounted: src=%s, tgt=%s, root=%s", src, tgt, root));
 
-	while (mnt_table_next_fs(tb, &itr, &fs) == 0) {
+	while (1) {
+		int eq;
+
+		if (indexed)
+			fs = srcindex_next_cand(tb, &cands);
+		else if (mnt_table_next_fs(tb, &itr, &fs) != 0)
+			fs = NULL;
+		if (!fs)
+			break;
 
-		int eq = mnt_fs_streq_srcpath(fs, src);
+		eq = mnt_fs_streq_srcpath(fs, src);
 
 		if (!eq && devno && mnt_fs_get_devno(fs) == devno)
 			eq = 1;
@@ -1987,7 +2461,7 @@ done:
 	return rc;
 }
 
-static int test_find(struct libmnt_test *ts, int argc, char *argv[], int dr)
+static int test_find(struct libmnt_test *ts, int argc, char *argv[], int dr, int idx)
 {
 	struct libmnt_table *tb;
 	struct libmnt_fs *fs = NULL;
@@ -2012,6 +2486,7 @@ static int test_find(struct libmnt_test *ts, int argc, char *argv[], int dr)
 		goto done;
 	mnt_table_set_cache(tb, mpc);
 	mnt_unref_cache(mpc);
+	mnt_table_enable_index(tb, idx);
 
 	if (strcasecmp(find, "source") == 0)
 		fs = mnt_table_find_source(tb, what, dr);
@@ -2031,12 +2506,58 @@ done:
 
 static int test_find_bw(struct libmnt_test *ts, int argc, char *argv[])
 {
-	return test_find(ts, argc, argv, MNT_ITER_BACKWARD);
+	return test_find(ts, argc, argv, MNT_ITER_BACKWARD, 0);
 }
 
 static int test_find_fw(struct libmnt_test *ts, int argc, char *argv[])
 {
-	return test_find(ts, argc, argv, MNT_ITER_FORWARD);
+	return test_find(ts, argc, argv, MNT_ITER_FORWARD, 0);
+}
+
+static int test_find_indexed(struct libmnt_test *ts, int argc, char *argv[])
+{
+	return test_find(ts, argc, argv, MNT_ITER_BACKWARD, 1);
+}
+
+/* the source index has to be updated after the source change */
+static int test_find_indexed_changed(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_table *tb;
+	struct libmnt_fs *fs;
+	const char *old;
+	char *oldsrc = NULL;
+	int rc = -1;
+
+	if (argc != 4) {
+		fprintf(stderr, "try --help\n");
+		return -EINVAL;
+	}
+
+	tb = create_table(argv[1], FALSE);
+	if (!tb)
+		return -1;
+	mnt_table_enable_index(tb, 1);
+
+	fs = mnt_table_find_target(tb, argv[2], MNT_ITER_BACKWARD);
+	old = fs ? mnt_fs_get_srcpath(fs) : NULL;
+	if (!old || !(oldsrc = strdup(old)))
+		goto done;
+
+	/* generate the index */
+	if (mnt_table_find_srcpath(tb, oldsrc, MNT_ITER_BACKWARD) != fs)
+		goto done;
+	if (mnt_fs_set_source(fs, argv[3]) != 0)
+		goto done;
+
+	fs = mnt_table_find_srcpath(tb, argv[3], MNT_ITER_BACKWARD);
+	printf("%s: %s\n", argv[3], fs ? mnt_fs_get_target(fs) : "not found");
+	fs = mnt_table_find_srcpath(tb, oldsrc, MNT_ITER_BACKWARD);
+	printf("%s: %s\n", oldsrc, fs ? mnt_fs_get_target(fs) : "not found");
+	rc = 0;
+done:
+	free(oldsrc);
+	mnt_unref_table(tb);
+	return rc;
 }
 
 static int test_find_pair(struct libmnt_test *ts, int argc, char *argv[])
@@ -2093,6 +2614,64 @@ done:
 	return rc;
 }
 
+static void print_tree(struct libmnt_table *tb, struct libmnt_fs *parent, int level)
+{
+	struct libmnt_iter *itr;
+	struct libmnt_fs *chld;
+
+	printf("%*s%d %s\n", level * 2, "",
+			mnt_fs_get_id(parent), mnt_fs_get_target(parent));
+
+	itr = mnt_new_iter(MNT_ITER_FORWARD);
+	if (!itr)
+		return;
+	while (mnt_table_next_child_fs(tb, itr, parent, &chld) == 0)
+		print_tree(tb, chld, level + 1);
+	mnt_free_iter(itr);
+}
+
+static int test_tree(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_table *tb;
+	struct libmnt_fs *root, *fs;
+	int rc = -1;
+
+	if (argc != 2 && argc != 4) {
+		fprintf(stderr, "try --help\n");
+		return -EINVAL;
+	}
+
+	tb = create_table(argv[1], FALSE);
+	if (!tb)
+		return -1;
+
+	if (mnt_table_get_root_fs(tb, &root) != 0)
+		goto done;
+	print_tree(tb, root, 0);
+
+	if (argc == 4) {
+		fs = mnt_table_find_target(tb, argv[3], MNT_ITER_FORWARD);
+		if (!fs || fs == root)
+			goto done;
+
+		/* the index is already generated, the change has to drop it */
+		if (strcmp(argv[2], "remove") == 0)
+			mnt_table_remove_fs(tb, fs);
+		else if (strcmp(argv[2], "free") == 0)
+			mnt_free_fs(fs);
+		else
+			goto done;
+
+		printf("--- %s %s (%d entries)\n", argv[2], argv[3],
+				mnt_table_get_nents(tb));
+		print_tree(tb, root, 0);
+	}
+	rc = 0;
+done:
+	mnt_unref_table(tb);
+	return rc;
+}
+
 static int test_is_mounted(struct libmnt_test *ts, int argc, char *argv[])
 {
 	struct libmnt_table *tb = NULL, *fstab = NULL;
@@ -2185,18 +2764,69 @@ done:
 }
 
 
+#ifdef HAVE_BTRFS_SUPPORT
+/*
+ * The default subvolume ID is pre-set in the table cache, so the lookup
+ * has to use it rather than call ioctl on the (not existing) mountpoints.
+ */
+static int test_btrfs_ids(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_table *tb;
+	struct libmnt_fs *fs;
+	uint64_t id;
+	int rc = -1;
+
+	if (argc != 4) {
+		fprintf(stderr, "try --help\n");
+		return -EINVAL;
+	}
+
+	tb = create_table(argv[1], FALSE);
+	if (!tb)
+		return -1;
+
+	if (mnt_parse_offset(argv[3], strlen(argv[3]), &id) != 0)
+		goto done;
+
+	tb->btrfs_ids = calloc(1, sizeof(struct libmnt_btrfsid));
+	if (!tb->btrfs_ids)
+		goto done;
+	tb->btrfs_ids[0].source = strdup(argv[2]);
+	tb->btrfs_ids[0].id = id;
+	tb->nbtrfs_ids = 1;
+
+	fs = mnt_table_find_srcpath(tb, argv[2], MNT_ITER_BACKWARD);
+	printf("%s default subvolid %ju: %s\n", argv[2], (uintmax_t) id,
+			fs ? mnt_fs_get_target(fs) : "not found");
+	printf("cached IDs: %zu\n", tb->nbtrfs_ids);
+
+	mnt_reset_table(tb);
+	printf("cached IDs after reset: %zu\n", tb->nbtrfs_ids);
+	rc = 0;
+done:
+	mnt_unref_table(tb);
+	return rc;
+}
+#endif /* HAVE_BTRFS_SUPPORT */
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
 	{ "--parse",    test_parse,        "<file> [--comments] parse and print tab" },
 	{ "--find-forward",  test_find_fw, "<file> <source|target> <string>" },
 	{ "--find-backward", test_find_bw, "<file> <source|target> <string>" },
+	{ "--find-indexed",  test_find_indexed, "<file> <source|target> <string>  backward, use source index" },
+	{ "--find-indexed-changed", test_find_indexed_changed, "<file> <target> <source>  change source of indexed entry" },
 	{ "--uniq-target",   test_uniq,    "<file>" },
 	{ "--find-pair",     test_find_pair, "<file> <source> <target>" },
 	{ "--find-fs",       test_find_idx, "<file> <target>" },
 	{ "--find-mountpoint", test_find_mountpoint, "<path>" },
 	{ "--copy-fs",       test_copy_fs, "<file>  copy root FS from the file" },
 	{ "--is-mounted",    test_is_mounted, "<fstab> check what from fstab is already mounted" },
+	{ "--tree",          test_tree,    "<mountinfo> [remove|free <target>]  print tree, optionally after change" },
+#ifdef HAVE_BTRFS_SUPPORT
+	{ "--btrfs-ids",     test_btrfs_ids, "<mountinfo> <source> <id>  find source with cached default subvolume" },
+#endif
 	{ NULL }
 	};
 
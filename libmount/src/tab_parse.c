@@ -556,6 +556,11 @@ next_line:
 			DBG(TAB, ul_debugobj(tb, "%s:%zu: no final newline",
 						pa->filename, pa->line));
 
+			/* utab entry is being appended right now (or the
+			 * writer died), see tab_update.c */
+			if (tb->fmt == MNT_FMT_UTAB)
+				return 1;
+
 			/* Missing final newline?  Otherwise an extremely */
 			/* long line - assume file was corrupted */
 			if (feof(pa->f))
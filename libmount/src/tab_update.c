@@ -30,6 +30,7 @@
 #include "mountP.h"
 #include "mangle.h"
 #include "pathnames.h"
+#include "strutils.h"
 
 struct libmnt_update {
 	char		*target;
@@ -401,6 +402,7 @@ static int set_fs_root(struct libmnt_update *upd, struct libmnt_fs *fs,
 		mnt_fs_set_fstype(upd->fs, mnt_fs_get_fstype(src_fs));
 	}
 
+	mnt_fs_free_str(upd->fs, root);
 	upd->fs->root = fsroot;
 	return 0;
 err:
@@ -531,6 +533,10 @@ static int update_table(struct libmnt_update *upd, struct libmnt_table *tb)
 
 		mnt_reset_iter(&itr, MNT_ITER_FORWARD);
 
+		if (upd->userspace_only)
+			/* placeholder, see utab_need_compaction() */
+			fprintf(f, MNT_UTAB_JOURNAL_HEADER "%010d\n", 0);
+
 		if (tb->comms && mnt_table_get_intro_comment(tb))
 			fputs(mnt_table_get_intro_comment(tb), f);
 
@@ -548,6 +554,13 @@ static int update_table(struct libmnt_update *upd, struct libmnt_table *tb)
 		if (tb->comms && mnt_table_get_trailing_comment(tb))
 			fputs(mnt_table_get_trailing_comment(tb), f);
 
+		if (upd->userspace_only) {
+			long sz = ftell(f);
+
+			if (sz > 0 && sz <= 9999999999L && fseek(f, 0, SEEK_SET) == 0)
+				fprintf(f, MNT_UTAB_JOURNAL_HEADER "%010ld\n", sz);
+		}
+
 		if (fflush(f) != 0) {
 			rc = -errno;
 			DBG(UPDATE, ul_debugobj(upd, "%s: fflush failed: %m", uq));
@@ -673,6 +686,140 @@ leave:
 	return rc;
 }
 
+/*
+ * utab journal
+ *
+ * The utab file is not rewritten for each mount. The new entries are
+ * appended to the file as regular utab lines, so the update is O(1) under
+ * the lock and the file is still readable by any utab parser (including old
+ * libmount versions).
+ *
+ * The other changes (umount, move and remount) modify or remove existing
+ * lines. They are written by the classic way (parse and replace the file),
+ * which also compacts the appended entries. The file is compacted also when
+ * it's twice as big as after the last compaction. The size of the compacted
+ * file is stored in the first line of the file.
+ */
+#define UTAB_JOURNAL_MINSZ	4096
+
+static int utab_need_compaction(struct libmnt_update *upd)
+{
+	struct stat st;
+	unsigned long long base = 0;
+	char buf[32];
+	FILE *f;
+
+	if (stat(upd->filename, &st) != 0 || st.st_size < UTAB_JOURNAL_MINSZ)
+		return 0;
+
+	f = fopen(upd->filename, "r" UL_CLOEXECSTR);
+	if (f) {
+		const char *p;
+
+		if (fgets(buf, sizeof(buf), f)
+		    && (p = startswith(buf, MNT_UTAB_JOURNAL_HEADER)))
+			base = strtoull(p, NULL, 10);
+		fclose(f);
+	}
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: journal size %llu, compacted %llu",
+			upd->filename, (unsigned long long) st.st_size, base));
+
+	return (unsigned long long) st.st_size > 2 * base + UTAB_JOURNAL_MINSZ;
+}
+
+/*
+ * The last line without a newline is an entry from a writer which died in
+ * the middle of the append (the file is locked, so nobody is appending now).
+ * The line is ignored by the parser, but the next entry cannot be appended
+ * after it. Remove it.
+ */
+static int utab_drop_torn_line(struct libmnt_update *upd, int fd)
+{
+	char buf[BUFSIZ];
+	off_t end, off, pos = 0;
+
+	end = off = lseek(fd, 0, SEEK_END);
+	if (end < 0)
+		return -errno;
+
+	while (off > 0) {
+		size_t i, sz = min((off_t) sizeof(buf), off);
+
+		off -= sz;
+		if (pread(fd, buf, sz, off) != (ssize_t) sz)
+			return errno ? -errno : -EIO;
+		for (i = sz; i > 0; i--) {
+			if (buf[i - 1] == '\n') {
+				pos = off + i;
+				goto found;
+			}
+		}
+	}
+found:
+	if (pos == end)
+		return 0;
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: removing torn line at %jd",
+				upd->filename, (intmax_t) pos));
+	return ftruncate(fd, pos) == 0 ? 0 : -errno;
+}
+
+static FILE *open_utab_journal(struct libmnt_update *upd)
+{
+	FILE *f;
+	int fd, rc;
+
+	fd = open(upd->filename, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC,
+			S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if (fd < 0)
+		return NULL;
+
+	rc = utab_drop_torn_line(upd, fd);
+	if (rc) {
+		close(fd);
+		errno = -rc;
+		return NULL;
+	}
+
+	f = fdopen(fd, "a" UL_CLOEXECSTR);
+	if (!f)
+		close(fd);
+	return f;
+}
+
+static int close_utab_journal(FILE *f, int rc)
+{
+	if (fflush(f) != 0 && !rc)
+		rc = -errno;
+	if (fclose(f) != 0 && !rc)
+		rc = -errno;
+	return rc;
+}
+
+/* appends the new entry to utab */
+static int update_utab_journal(struct libmnt_update *upd, struct libmnt_lock *lc)
+{
+	FILE *f;
+	int rc;
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: append entry", upd->filename));
+
+	if (lc && mnt_lock_file(lc) != 0)
+		return -MNT_ERR_LOCK;
+
+	f = open_utab_journal(upd);
+	if (f) {
+		rc = fprintf_utab_fs(f, upd->fs);
+		rc = close_utab_journal(f, rc);
+	} else
+		rc = -errno;
+
+	if (lc)
+		mnt_unlock_file(lc);
+	return rc;
+}
+
 static int add_file_entry(struct libmnt_table *tb, struct libmnt_update *upd)
 {
 	struct libmnt_fs *fs;
@@ -715,6 +862,121 @@ static int update_add_entry(struct libmnt_update *upd, struct libmnt_lock *lc)
 	return rc;
 }
 
+/*
+ * Moves prepared "add entry" update to @queue rather than write it to the
+ * file now. The queued entries are written by mnt_update_add_entries().
+ *
+ * Returns: 0 on success, 1 if the update cannot be queued (umount, move,
+ * remount or nothing prepared), <0 on error.
+ */
+int mnt_update_queue_entry(struct libmnt_update *upd, struct libmnt_table *queue)
+{
+	struct libmnt_fs *fs;
+
+	if (!upd || !queue)
+		return -EINVAL;
+	if (!upd->ready || !upd->fs || upd->target
+	    || (upd->mountflags & (MS_MOVE | MS_REMOUNT)))
+		return 1;
+
+	fs = mnt_copy_fs(NULL, upd->fs);
+	if (!fs)
+		return -ENOMEM;
+
+	mnt_table_add_fs(queue, fs);
+	mnt_unref_fs(fs);
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: entry queued", upd->filename));
+	upd->ready = FALSE;
+	return 0;
+}
+
+/*
+ * Adds all @entries to the file (as specified by the last
+ * mnt_update_set_fs() call). The file is locked, parsed and written only once
+ * for all the entries.
+ *
+ * Returns: 0 on success, negative number on error.
+ */
+int mnt_update_add_entries(struct libmnt_update *upd,
+			   struct libmnt_table *entries,
+			   struct libmnt_lock *lc)
+{
+	struct libmnt_lock *lc0 = lc;
+	struct libmnt_table *tb = NULL;
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+	int rc = 0;
+
+	if (!upd || !upd->filename || !entries)
+		return -EINVAL;
+	if (mnt_table_is_empty(entries))
+		return 0;
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: add %d entries", upd->filename,
+				mnt_table_get_nents(entries)));
+	if (!lc) {
+		lc = mnt_new_lock(upd->filename, 0);
+		if (lc)
+			mnt_lock_block_signals(lc, TRUE);
+	}
+	if (lc && upd->userspace_only)
+		mnt_lock_use_simplelock(lc, TRUE);	/* use flock */
+	if (lc) {
+		rc = mnt_lock_file(lc);
+		if (rc) {
+			rc = -MNT_ERR_LOCK;
+			goto done;
+		}
+	}
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+
+	if (upd->userspace_only && !utab_need_compaction(upd)) {
+		FILE *f = open_utab_journal(upd);
+
+		if (!f) {
+			rc = -errno;
+			goto unlock;
+		}
+		while (rc == 0 && mnt_table_next_fs(entries, &itr, &fs) == 0)
+			rc = fprintf_utab_fs(f, fs);
+		rc = close_utab_journal(f, rc);
+		goto unlock;
+	}
+
+	tb = __mnt_new_table_from_file(upd->filename,
+			upd->userspace_only ? MNT_FMT_UTAB : MNT_FMT_MTAB, 1);
+	if (!tb) {
+		rc = -ENOMEM;
+		goto unlock;
+	}
+
+	while (mnt_table_next_fs(entries, &itr, &fs) == 0) {
+		struct libmnt_fs *x = mnt_copy_fs(NULL, fs);
+
+		if (!x) {
+			rc = -ENOMEM;
+			goto unlock;
+		}
+		mnt_table_add_fs(tb, x);
+		mnt_unref_fs(x);
+	}
+
+	rc = update_table(upd, tb);
+unlock:
+	if (lc)
+		mnt_unlock_file(lc);
+done:
+	mnt_unref_table(tb);
+	if (lc != lc0)
+		mnt_free_lock(lc);
+
+	DBG(UPDATE, ul_debugobj(upd, "%s: add entries: done [rc=%d]",
+				upd->filename, rc));
+	return rc;
+}
+
 static int update_remove_entry(struct libmnt_update *upd, struct libmnt_lock *lc)
 {
 	struct libmnt_table *tb;
@@ -862,6 +1124,8 @@ int mnt_update_table(struct libmnt_update *upd, struct libmnt_lock *lc)
 		rc = update_modify_target(upd, lc);	/* move */
 	else if (upd->mountflags & MS_REMOUNT)
 		rc = update_modify_options(upd, lc);	/* remount */
+	else if (upd->fs && upd->userspace_only && !utab_need_compaction(upd))
+		rc = update_utab_journal(upd, lc);	/* mount, append to utab */
 	else if (upd->fs)
 		rc = update_add_entry(upd, lc);	/* mount */
 
@@ -986,6 +1250,46 @@ static int test_add(struct libmnt_test *ts, int argc, char *argv[])
 	return rc;
 }
 
+static int test_add_batch(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_table *entries;
+	struct libmnt_update *upd;
+	int i, rc;
+
+	if (argc < 5 || (argc - 1) % 4)
+		return -1;
+
+	entries = mnt_new_table();
+	upd = mnt_new_update();
+	if (!entries || !upd)
+		return -ENOMEM;
+
+	for (i = 1; i + 3 < argc; i += 4) {
+		struct libmnt_fs *fs = mnt_new_fs();
+
+		if (!fs)
+			return -ENOMEM;
+		mnt_fs_set_source(fs, argv[i]);
+		mnt_fs_set_target(fs, argv[i + 1]);
+		mnt_fs_set_fstype(fs, argv[i + 2]);
+		mnt_fs_set_options(fs, argv[i + 3]);
+
+		/* the update is prepared for each entry as in the batch mount */
+		rc = mnt_update_set_fs(upd, 0, NULL, fs);
+		if (rc == 0)
+			rc = mnt_update_queue_entry(upd, entries);
+		mnt_unref_fs(fs);
+		if (rc < 0)
+			goto done;
+	}
+
+	rc = mnt_update_add_entries(upd, entries, NULL);
+done:
+	mnt_free_update(upd);
+	mnt_unref_table(entries);
+	return rc;
+}
+
 static int test_remove(struct libmnt_test *ts, int argc, char *argv[])
 {
 	if (argc < 2)
@@ -1048,14 +1352,34 @@ static int test_replace(struct libmnt_test *ts, int argc, char *argv[])
 	return rc;
 }
 
+static int test_utab(struct libmnt_test *ts, int argc, char *argv[])
+{
+	struct libmnt_table *tb;
+	struct libmnt_iter itr;
+	struct libmnt_fs *fs;
+
+	tb = __mnt_new_table_from_file(mnt_get_utab_path(), MNT_FMT_UTAB, 1);
+	if (!tb)
+		return -1;
+
+	mnt_reset_iter(&itr, MNT_ITER_FORWARD);
+	while (mnt_table_next_fs(tb, &itr, &fs) == 0)
+		fprintf_utab_fs(stdout, fs);
+
+	mnt_unref_table(tb);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	struct libmnt_test tss[] = {
 	{ "--add",    test_add,     "<src> <target> <type> <options>  add a line to mtab" },
+	{ "--add-batch", test_add_batch, "<src> <target> <type> <options> [...]  add lines by one update" },
 	{ "--remove", test_remove,  "<target>                      MS_REMOUNT mtab change" },
 	{ "--move",   test_move,    "<old_target>  <target>        MS_MOVE mtab change" },
 	{ "--remount",test_remount, "<target>  <options>           MS_REMOUNT mtab change" },
 	{ "--replace",test_replace, "<src> <target>                Add a line to LIBMOUNT_FSTAB and replace the original file" },
+	{ "--utab",   test_utab,    "                              print parsed utab entries" },
 	{ NULL }
 	};
 
@@ -32,6 +32,10 @@
 #include "statfs_magic.h"
 #include "sysfs.h"
 
+#if defined(HAVE_STATX) && !defined(STATX_ATTR_MOUNT_ROOT)
+# define STATX_ATTR_MOUNT_ROOT	0x00002000	/* Linux 5.8 */
+#endif
+
 int append_string(char **a, const char *b)
 {
 	size_t al, bl;
@@ -992,6 +996,81 @@ err:
 	return NULL;
 }
 
+/**
+ * mnt_is_mountpoint:
+ * @path: pathname
+ *
+ * Checks if @path is a mountpoint, it means the root of a mounted filesystem
+ * or a bind mount. On Linux >= 5.8 the function asks kernel by statx(2)
+ * STATX_ATTR_MOUNT_ROOT and the mount table is not read at all. On old
+ * kernels the @path is searched in /proc/self/mountinfo and if /proc is not
+ * available then st_dev of the @path and its parent are compared (bind
+ * mounts are not detected in this case).
+ *
+ * Symbolic links are followed, automounts are not triggered.
+ *
+ * Returns: 1 if @path is a mountpoint, 0 if not, negative number in case of error.
+ *
+ * Since: 2.37
+ */
+int mnt_is_mountpoint(const char *path)
+{
+	struct libmnt_table *tb;
+	struct stat st;
+	int rc;
+
+	if (!path || !*path)
+		return -EINVAL;
+
+#ifdef HAVE_STATX
+	{
+		struct statx stx;
+
+		if (statx(AT_FDCWD, path, AT_NO_AUTOMOUNT, STATX_TYPE, &stx) == 0) {
+			if (stx.stx_attributes_mask & STATX_ATTR_MOUNT_ROOT) {
+				rc = stx.stx_attributes & STATX_ATTR_MOUNT_ROOT ? 1 : 0;
+				DBG(UTILS, ul_debug("%s: statx mount root: %d", path, rc));
+				return rc;
+			}
+		} else if (errno != ENOSYS)
+			return -errno;
+	}
+#endif
+	if (mnt_stat_mountpoint(path, &st) != 0)
+		return -errno;
+
+	tb = mnt_new_table_from_file(_PATH_PROC_MOUNTINFO);
+	if (tb) {
+		struct libmnt_cache *cache = mnt_new_cache();
+
+		/* to canonicalize all necessary paths */
+		mnt_table_set_cache(tb, cache);
+		mnt_unref_cache(cache);
+
+		rc = mnt_table_find_target(tb, path, MNT_ITER_BACKWARD) ? 1 : 0;
+		mnt_unref_table(tb);
+	} else {
+		/* traditional way, independent on /proc */
+		struct stat pst;
+		char buf[PATH_MAX], *cn;
+		int len;
+
+		cn = mnt_resolve_path(path, NULL);
+		len = snprintf(buf, sizeof(buf), "%s/..", cn ? cn : path);
+		free(cn);
+
+		if (len < 0 || (size_t) len >= sizeof(buf))
+			return -EINVAL;
+		if (mnt_stat_mountpoint(buf, &pst) != 0)
+			return -errno;
+
+		rc = st.st_dev != pst.st_dev || st.st_ino == pst.st_ino;
+	}
+
+	DBG(UTILS, ul_debug("%s: mountpoint: %d", path, rc));
+	return rc;
+}
+
 /*
  * Search for @name kernel command parameter.
  *
@@ -1228,6 +1307,16 @@ static int test_mountpoint(struct libmnt_test *ts, int argc, char *argv[])
 	return 0;
 }
 
+static int test_is_mountpoint(struct libmnt_test *ts, int argc, char *argv[])
+{
+	int rc = mnt_is_mountpoint(argv[1]);
+
+	if (rc < 0)
+		return rc;
+	printf("%s: %s\n", argv[1], rc ? "yes" : "no");
+	return 0;
+}
+
 static int test_filesystems(struct libmnt_test *ts, int argc, char *argv[])
 {
 	char **filesystems = NULL;
@@ -1345,6 +1434,7 @@ int main(int argc, char *argv[])
 	{ "--ends-with",     test_endswith,        "<string> <prefix>" },
 	{ "--append-string", test_appendstr,       "<string> <appendix>" },
 	{ "--mountpoint",    test_mountpoint,      "<path>" },
+	{ "--is-mountpoint", test_is_mountpoint,   "<path>" },
 	{ "--cd-parent",     test_chdir,           "<path>" },
 	{ "--kernel-cmdline",test_kernel_cmdline,  "<option> | <option>=" },
 	{ "--guess-root",    test_guess_root,      "[<maj:min>]" },
@@ -129,7 +129,7 @@ fail:
 	return NULL;
 }
 
-static int parse_column_data(FILE *f, struct libscols_table *tb, int col)
+static int parse_column_data(FILE *f, struct libscols_table *tb, int col, int refer)
 {
 	size_t len = 0, nlines = 0;
 	int i;
@@ -151,7 +151,12 @@ static int parse_column_data(FILE *f, struct libscols_table *tb, int col)
 		if (!ln)
 			break;
 
-		if (*str && scols_line_set_data(ln, col, str) != 0)
+		if (!*str)
+			continue;
+		if (refer) {
+			if (scols_line_refer_data(ln, col, xstrdup(str)) != 0)
+				err(EXIT_FAILURE, "failed to add output data");
+		} else if (scols_line_set_data(ln, col, str) != 0)
 			err(EXIT_FAILURE, "failed to add output data");
 	}
 
@@ -198,6 +203,99 @@ static void compose_tree(struct libscols_table *tb, int parent_col, int id_col)
 }
 
 
+static void set_filter(struct libscols_table *tb, const char *expr)
+{
+	struct libscols_filter *fltr = scols_new_filter(expr);
+
+	if (!fltr)
+		err(EXIT_FAILURE, "failed to allocate filter");
+	if (scols_filter_get_errmsg(fltr)
+	    || scols_table_set_filter(tb, fltr) != 0) {
+		const char *msg = scols_filter_get_errmsg(fltr);
+
+		errx(EXIT_FAILURE, "failed to set filter: %s",
+				msg ? msg : "invalid expression");
+	}
+	scols_unref_filter(fltr);
+}
+
+/* sort by comma-separated list of column numbers */
+static void sort_table(struct libscols_table *tb, const char *list)
+{
+	struct libscols_column *cls[16];
+	char *str = xstrdup(list), *tok, *save = NULL;
+	size_t n = 0;
+
+	for (tok = strtok_r(str, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		if (n >= ARRAY_SIZE(cls))
+			errx(EXIT_FAILURE, "too many sort columns");
+		cls[n] = scols_table_get_column(tb,
+				strtou32_or_err(tok, "failed to parse sort column"));
+		if (!cls[n])
+			errx(EXIT_FAILURE, "%s: no such column", tok);
+		scols_column_set_cmpfunc(cls[n], scols_cmpstr_cells, NULL);
+		n++;
+	}
+	if (scols_sort_table_by_columns(tb, cls, n))
+		errx(EXIT_FAILURE, "failed to sort table");
+	free(str);
+}
+
+/* remove lines by comma-separated list of line numbers */
+static void remove_lines(struct libscols_table *tb, const char *list)
+{
+	size_t i, n = 0, nlines = scols_table_get_nlines(tb);
+	struct libscols_line **lines = xcalloc(nlines, sizeof(struct libscols_line *));
+	char *str = xstrdup(list), *tok, *save = NULL;
+
+	/* the numbers refer to the original table, collect the lines first */
+	for (tok = strtok_r(str, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		struct libscols_line *ln = scols_table_get_line(tb,
+				strtou32_or_err(tok, "failed to parse line number"));
+		if (!ln)
+			errx(EXIT_FAILURE, "%s: no such line", tok);
+		if (n < nlines)
+			lines[n++] = ln;
+	}
+	for (i = 0; i < n; i++) {
+		struct libscols_line *parent = scols_line_get_parent(lines[i]);
+
+		if (parent)
+			scols_line_remove_child(parent, lines[i]);
+		if (scols_table_remove_line(tb, lines[i]))
+			errx(EXIT_FAILURE, "failed to remove line");
+	}
+	free(lines);
+	free(str);
+}
+
+/* re-add all lines to the table in streaming mode */
+static void stream_lines(struct libscols_table *tb, size_t sample)
+{
+	size_t i = 0, nlines = scols_table_get_nlines(tb);
+	struct libscols_line *ln, **lines = xcalloc(nlines, sizeof(struct libscols_line *));
+	struct libscols_iter *itr = scols_new_iter(SCOLS_ITER_FORWARD);
+
+	while (scols_table_next_line(tb, itr, &ln) == 0) {
+		scols_ref_line(ln);
+		lines[i++] = ln;
+	}
+	scols_free_iter(itr);
+
+	for (i = 0; i < nlines; i++)
+		scols_table_remove_line(tb, lines[i]);
+
+	scols_table_enable_streaming(tb, 1);
+	scols_table_set_streaming_sample(tb, sample);
+
+	for (i = 0; i < nlines; i++) {
+		if (scols_table_add_line(tb, lines[i]))
+			err(EXIT_FAILURE, "failed to add a line in streaming mode");
+		scols_unref_line(lines[i]);
+	}
+	free(lines);
+}
+
 static void __attribute__((__noreturn__)) usage(void)
 {
 	FILE *out = stdout;
@@ -215,6 +313,13 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(" -w, --width <num>              hardcode terminal width\n", out);
 	fputs(" -p, --tree-parent-column <n>   parent column\n", out);
 	fputs(" -i, --tree-id-column <n>       id column\n", out);
+	fputs(" -s, --stream <num>             streaming mode, calculate width from <num> lines\n", out);
+	fputs(" -S, --sort <n>[,<n> ...]       sort by columns\n", out);
+	fputs(" -Q, --filter <expr>            print only lines matching the expression\n", out);
+	fputs(" -t, --threads <num>            number of threads to print (0 = number of CPUs)\n", out);
+	fputs(" -A, --arena                    allocate lines in the table memory pool\n", out);
+	fputs(" -R, --refer                    use scols_line_refer_data() to set data\n", out);
+	fputs(" -D, --remove <n>[,<n> ...]     remove lines before print\n", out);
 	fputs(" -h, --help                     this help\n", out);
 	fputs("\n", out);
 
@@ -225,7 +330,8 @@ int main(int argc, char *argv[])
 {
 	struct libscols_table *tb;
 	int c, n, nlines = 0;
-	int parent_col = -1, id_col = -1;
+	int parent_col = -1, id_col = -1, stream = -1, refer = 0;
+	const char *sort = NULL, *filter = NULL, *remove = NULL;
 
 	static const struct option longopts[] = {
 		{ "maxout", 0, NULL, 'm' },
@@ -239,6 +345,13 @@ int main(int argc, char *argv[])
 		{ "raw",    0, NULL, 'r' },
 		{ "export", 0, NULL, 'E' },
 		{ "colsep",  1, NULL, 'C' },
+		{ "stream", 1, NULL, 's' },
+		{ "sort",   1, NULL, 'S' },
+		{ "filter", 1, NULL, 'Q' },
+		{ "threads", 1, NULL, 't' },
+		{ "arena",  0, NULL, 'A' },
+		{ "refer",  0, NULL, 'R' },
+		{ "remove", 1, NULL, 'D' },
 		{ "help",   0, NULL, 'h' },
 		{ NULL, 0, NULL, 0 },
 	};
@@ -257,7 +370,7 @@ int main(int argc, char *argv[])
 	if (!tb)
 		err(EXIT_FAILURE, "failed to create output table");
 
-	while((c = getopt_long(argc, argv, "hCc:Ei:JMmn:p:rw:", longopts, NULL)) != -1) {
+	while((c = getopt_long(argc, argv, "AhCc:D:Ei:JMmn:p:Q:RrS:s:t:w:", longopts, NULL)) != -1) {
 
 		err_exclusive_options(c, longopts, excl, excl_st);
 
@@ -301,6 +414,29 @@ int main(int argc, char *argv[])
 		case 'C':
 			scols_table_set_column_separator(tb, optarg);
 			break;
+		case 's':
+			stream = strtou32_or_err(optarg, "failed to parse stream sample");
+			break;
+		case 'S':
+			sort = optarg;
+			break;
+		case 'Q':
+			filter = optarg;
+			break;
+		case 't':
+			scols_table_set_print_threads(tb,
+				strtou32_or_err(optarg, "failed to parse number of threads"));
+			break;
+		case 'A':
+			if (scols_table_enable_arena(tb, 1))
+				err(EXIT_FAILURE, "failed to enable memory pool");
+			break;
+		case 'R':
+			refer = 1;
+			break;
+		case 'D':
+			remove = optarg;
+			break;
 		case 'n':
 			nlines = strtou32_or_err(optarg, "failed to parse number of lines");
 			break;
@@ -319,8 +455,15 @@ int main(int argc, char *argv[])
 		errx(EXIT_FAILURE, "--nlines not set");
 
 	for (n = 0; n < nlines; n++) {
-		struct libscols_line *ln = scols_new_line();
+		struct libscols_line *ln;
 
+		if (scols_table_is_arena(tb)) {
+			ln = scols_table_new_line(tb, NULL);
+			if (!ln)
+				err(EXIT_FAILURE, "failed to add a new line");
+			continue;
+		}
+		ln = scols_new_line();
 		if (!ln || scols_table_add_line(tb, ln))
 			err(EXIT_FAILURE, "failed to add a new line");
 
@@ -335,7 +478,7 @@ int main(int argc, char *argv[])
 		if (!f)
 			err(EXIT_FAILURE, "%s: open failed", argv[optind]);
 
-		parse_column_data(f, tb, n);
+		parse_column_data(f, tb, n, refer);
 		optind++;
 		n++;
 	}
@@ -343,8 +486,19 @@ int main(int argc, char *argv[])
 	if (scols_table_is_tree(tb) && parent_col >= 0 && id_col >= 0)
 		compose_tree(tb, parent_col, id_col);
 
+	/* after data, the lines are filled column by column */
+	if (remove)
+		remove_lines(tb, remove);
+	if (filter)
+		set_filter(tb, filter);
+	if (sort)
+		sort_table(tb, sort);
+
 	scols_table_enable_colors(tb, isatty(STDOUT_FILENO));
 
+	if (stream >= 0)
+		stream_lines(tb, stream);
+
 	scols_print_table(tb);
 	scols_unref_table(tb);
 	return EXIT_SUCCESS;
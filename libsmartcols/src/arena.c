@@ -0,0 +1,131 @@
+/*
+ * arena.c - table-scoped memory for lines and cells
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ *
+ * The arena is a simple bump allocator. The memory is never deallocated
+ * per object, all the arena is deallocated at once when the table is
+ * deallocated. See scols_table_enable_arena().
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "smartcolsP.h"
+
+#define ARENA_CHUNK_MINSZ	(64 * 1024)
+#define ARENA_CHUNK_MAXSZ	(4 * 1024 * 1024)
+#define ARENA_ALIGN		(sizeof(void *) > sizeof(size_t) ? sizeof(void *) : sizeof(size_t))
+
+struct arena_chunk {
+	struct arena_chunk	*next;
+	size_t			size;	/* usable size */
+	size_t			used;
+	/* data follows */
+};
+
+struct libscols_arena {
+	struct arena_chunk	*chunks;	/* current chunk is the first */
+	size_t			nextsz;		/* size of the next chunk */
+};
+
+#define chunk_data(c)	((char *) (c) + align_size(sizeof(struct arena_chunk)))
+
+static inline size_t align_size(size_t sz)
+{
+	return (sz + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+}
+
+struct libscols_arena *scols_new_arena(void)
+{
+	struct libscols_arena *ar = calloc(1, sizeof(*ar));
+
+	if (!ar)
+		return NULL;
+	ar->nextsz = ARENA_CHUNK_MINSZ;
+
+	DBG(TAB, ul_debugobj(ar, "alloc arena"));
+	return ar;
+}
+
+void scols_free_arena(struct libscols_arena *ar)
+{
+	if (!ar)
+		return;
+
+	DBG(TAB, ul_debugobj(ar, "dealloc arena"));
+	while (ar->chunks) {
+		struct arena_chunk *c = ar->chunks;
+
+		ar->chunks = c->next;
+		free(c);
+	}
+	free(ar);
+}
+
+static struct arena_chunk *arena_new_chunk(struct libscols_arena *ar, size_t sz)
+{
+	struct arena_chunk *c;
+	size_t size = ar->nextsz;
+
+	if (size < sz)
+		size = sz;	/* large object, dedicated chunk */
+	else if (ar->nextsz < ARENA_CHUNK_MAXSZ)
+		ar->nextsz *= 2;
+
+	c = malloc(align_size(sizeof(struct arena_chunk)) + size);
+	if (!c)
+		return NULL;
+
+	c->size = size;
+	c->used = 0;
+
+	/* keep not-full chunk as the current if the new one is dedicated */
+	if (size == sz && ar->chunks && ar->chunks->used < ar->chunks->size) {
+		c->next = ar->chunks->next;
+		ar->chunks->next = c;
+	} else {
+		c->next = ar->chunks;
+		ar->chunks = c;
+	}
+
+	DBG(TAB, ul_debugobj(ar, "new arena chunk (size=%zu)", size));
+	return c;
+}
+
+void *scols_arena_alloc(struct libscols_arena *ar, size_t sz)
+{
+	struct arena_chunk *c = ar->chunks;
+	void *p;
+
+	sz = align_size(sz ? sz : 1);
+
+	if (!c || c->size - c->used < sz) {
+		c = arena_new_chunk(ar, sz);
+		if (!c)
+			return NULL;
+	}
+
+	p = chunk_data(c) + c->used;
+	c->used += sz;
+	return p;
+}
+
+void *scols_arena_calloc(struct libscols_arena *ar, size_t sz)
+{
+	void *p = scols_arena_alloc(ar, sz);
+
+	if (p)
+		memset(p, 0, sz);
+	return p;
+}
+
+char *scols_arena_strdup(struct libscols_arena *ar, const char *str)
+{
+	size_t sz = strlen(str) + 1;
+	char *p = scols_arena_alloc(ar, sz);
+
+	if (p)
+		memcpy(p, str, sz);
+	return p;
+}
@@ -32,6 +32,27 @@ static void dbg_columns(struct libscols_table *tb)
 		dbg_column(tb, cl);
 }
 
+static size_t data_width(struct libscols_table *tb, const char *data)
+{
+	if (!data)
+		return 0;
+	return scols_table_is_noencoding(tb) ? mbs_width(data) : mbs_safe_width(data);
+}
+
+/*
+ * The width of the cell in a regular column depends on the cell data only,
+ * and the column may be counted more than once (see SCOLS_FL_NOEXTREMES), so
+ * the result is cached in the cell.
+ */
+static size_t cell_width(struct libscols_table *tb, struct libscols_cell *ce)
+{
+	if (ce->width_gen != tb->width_gen) {
+		ce->width = data_width(tb, scols_cell_get_data(ce));
+		ce->width_gen = tb->width_gen;
+	}
+	return ce->width;
+}
+
 static int count_cell_width(struct libscols_table *tb,
 		struct libscols_line *ln,
 		struct libscols_column *cl,
@@ -41,19 +62,21 @@ static int count_cell_width(struct libscols_table *tb,
 	char *data;
 	int rc;
 
-	rc = __cell_to_buffer(tb, ln, cl, buf);
-	if (rc)
-		return rc;
+	if (!scols_column_is_tree(cl) && !scols_column_is_customwrap(cl)) {
+		struct libscols_cell *ce = scols_line_get_cell(ln, cl->seqnum);
 
-	data = buffer_get_data(buf);
-	if (!data)
-		len = 0;
-	else if (scols_column_is_customwrap(cl))
-		len = cl->wrap_chunksize(cl, data, cl->wrapfunc_data);
-	else if (scols_table_is_noencoding(tb))
-		len = mbs_width(data);
-	else
-		len = mbs_safe_width(data);
+		len = ce ? cell_width(tb, ce) : 0;
+	} else {
+		rc = __cell_to_buffer(tb, ln, cl, buf);
+		if (rc)
+			return rc;
+
+		data = buffer_get_data(buf);
+		if (data && scols_column_is_customwrap(cl))
+			len = cl->wrap_chunksize(cl, data, cl->wrapfunc_data);
+		else
+			len = data_width(tb, data);
+	}
 
 	if (len == (size_t) -1)		/* ignore broken multibyte strings */
 		len = 0;
@@ -45,7 +45,8 @@ int scols_reset_cell(struct libscols_cell *ce)
 		return -EINVAL;
 
 	/*DBG(CELL, ul_debugobj(ce, "reset"));*/
-	free(ce->data);
+	if (!ce->is_arena_data)
+		free(ce->data);
 	free(ce->color);
 	memset(ce, 0, sizeof(*ce));
 	return 0;
@@ -81,11 +82,23 @@ int scols_cell_refer_data(struct libscols_cell *ce, char *data)
 {
 	if (!ce)
 		return -EINVAL;
-	free(ce->data);
+	if (!ce->is_arena_data)
+		free(ce->data);
 	ce->data = data;
+	ce->is_arena_data = 0;
 	return 0;
 }
 
+/* the same as scols_cell_refer_data(), but @data are owned by arena */
+int scols_cell_refer_arena_data(struct libscols_cell *ce, char *data)
+{
+	int rc = scols_cell_refer_data(ce, data);
+
+	if (!rc)
+		ce->is_arena_data = 1;
+	return rc;
+}
+
 /**
  * scols_cell_get_data:
  * @ce: a pointer to a struct libscols_cell instance
@@ -155,6 +168,42 @@ int scols_cmpstr_cells(struct libscols_cell *a,
 	return strcmp(adata, bdata);
 }
 
+/**
+ * scols_cmpu64_cells:
+ * @a: pointer to cell
+ * @b: pointer to cell
+ * @data: unused pointer to private data (defined by API)
+ *
+ * Compares cells userdata as pointers to uint64_t numbers, the cells without
+ * userdata are ordered first. The function is designed for
+ * scols_column_set_cmpfunc() and scols_sort_table(), the sort keys are
+ * precomputed by the library for this function.
+ *
+ * Returns: -1, 0 or 1 like strcmp().
+ *
+ * Since: 2.37
+ */
+int scols_cmpu64_cells(struct libscols_cell *a,
+		       struct libscols_cell *b,
+		       __attribute__((__unused__)) void *data)
+{
+	const uint64_t *adata, *bdata;
+
+	if (a == b)
+		return 0;
+
+	adata = a ? scols_cell_get_userdata(a) : NULL;
+	bdata = b ? scols_cell_get_userdata(b) : NULL;
+
+	if (adata == NULL && bdata == NULL)
+		return 0;
+	if (adata == NULL)
+		return -1;
+	if (bdata == NULL)
+		return 1;
+	return *adata == *bdata ? 0 : *adata > *bdata ? 1 : -1;
+}
+
 /**
  * scols_cell_set_color:
  * @ce: a pointer to a struct libscols_cell instance
@@ -0,0 +1,900 @@
+/*
+ * filter.c - functions for lines filtering
+ *
+ * This file may be redistributed under the terms of the
+ * GNU Lesser General Public License.
+ */
+
+/**
+ * SECTION: filter
+ * @title: Filter
+ * @short_description: lines filter
+ *
+ * The filter is an expression evaluated for every table line, lines which
+ * do not match the expression are removed from the table before they are
+ * used for columns width calculation and printing. The expression is parsed
+ * and compiled only once (see scols_new_filter()).
+ *
+ * The expression syntax:
+ *
+ * <informalexample>
+ *   <programlisting>
+ *   expr    := expr "||" expr | expr "&&" expr | "!" expr | "(" expr ")"
+ *            | param | param operator param
+ *   param   := column-name | "string" | 'string' | number | true | false
+ *   operator:= "==" | "!=" | "<" | "<=" | ">" | ">=" | "=~" | "!~"
+ *   </programlisting>
+ * </informalexample>
+ *
+ * The words "and", "or", "not", "eq", "ne", "lt", "le", "gt" and "ge" (case
+ * insensitive) are aliases to the operators. The column name is the column
+ * header (case insensitive). The column alone evaluates as a boolean (see
+ * SCOLS_JSON_BOOLEAN) in the same way as JSON output. If one of the
+ * compared params is a number, then the cell data are converted to
+ * number, cells which cannot be converted do not match. The "=~" and "!~"
+ * operators use POSIX extended regular expressions.
+ *
+ * Within a string, the backslash escapes only the quote and the backslash
+ * itself, other backslashes are kept as they are, so "\." is a regular
+ * expression for a dot.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <regex.h>
+
+#include "smartcolsP.h"
+
+enum {
+	F_NODE_AND,
+	F_NODE_OR,
+	F_NODE_NOT,
+	F_NODE_CMP,		/* param operator param */
+	F_NODE_PARAM		/* param evaluated as boolean */
+};
+
+enum {
+	F_OP_EQ,
+	F_OP_NE,
+	F_OP_LT,
+	F_OP_LE,
+	F_OP_GT,
+	F_OP_GE,
+	F_OP_REG,
+	F_OP_NREG
+};
+
+enum {
+	F_PARAM_NAME,		/* column name */
+	F_PARAM_STRING,
+	F_PARAM_NUMBER,
+	F_PARAM_BOOLEAN
+};
+
+struct filter_param {
+	int			type;		/* F_PARAM_* */
+	char			*str;		/* string or column name */
+	long double		num;
+	int			boolean;
+
+	struct libscols_column	*cl;		/* column (bound by scols_table_set_filter()) */
+};
+
+struct filter_node {
+	int			type;		/* F_NODE_* */
+	int			op;		/* F_OP_* */
+
+	struct filter_node	*left;		/* AND, OR, NOT */
+	struct filter_node	*right;		/* AND, OR */
+
+	struct filter_param	a;		/* CMP, PARAM */
+	struct filter_param	b;		/* CMP */
+
+	regex_t			*re;		/* F_OP_{N,}REG compiled @b */
+};
+
+struct libscols_filter {
+	int			refcount;
+	struct filter_node	*root;
+	char			*errmsg;
+};
+
+/* tokens */
+enum {
+	F_TOK_END,
+	F_TOK_LPAREN,
+	F_TOK_RPAREN,
+	F_TOK_AND,
+	F_TOK_OR,
+	F_TOK_NOT,
+	F_TOK_OPERATOR,
+	F_TOK_NAME,
+	F_TOK_STRING,
+	F_TOK_NUMBER,
+	F_TOK_BOOLEAN
+};
+
+struct filter_parser {
+	struct libscols_filter	*fltr;
+	const char		*str;		/* whole expression */
+	const char		*p;		/* current position */
+
+	int			tok;		/* current token, F_TOK_* */
+	const char		*tokpos;	/* begin of the token */
+	int			op;		/* F_TOK_OPERATOR */
+	char			*tokstr;	/* F_TOK_{NAME,STRING} */
+	long double		toknum;		/* F_TOK_NUMBER */
+	int			tokbool;	/* F_TOK_BOOLEAN */
+};
+
+static void free_node(struct filter_node *n)
+{
+	if (!n)
+		return;
+	free_node(n->left);
+	free_node(n->right);
+	free(n->a.str);
+	free(n->b.str);
+	if (n->re) {
+		regfree(n->re);
+		free(n->re);
+	}
+	free(n);
+}
+
+static void reset_filter(struct libscols_filter *fltr)
+{
+	free_node(fltr->root);
+	fltr->root = NULL;
+	free(fltr->errmsg);
+	fltr->errmsg = NULL;
+}
+
+static int __attribute__((__format__ (__printf__, 2, 3)))
+	parser_error(struct filter_parser *pr, const char *fmt, ...)
+{
+	va_list ap;
+	char *msg = NULL;
+	int rc;
+
+	va_start(ap, fmt);
+	rc = vasprintf(&msg, fmt, ap);
+	va_end(ap);
+
+	if (rc < 0)
+		return -ENOMEM;
+
+	free(pr->fltr->errmsg);
+	pr->fltr->errmsg = msg;
+
+	DBG(FLTR, ul_debugobj(pr->fltr, "error: %s", msg));
+	return -EINVAL;
+}
+
+static int is_name_char(int c)
+{
+	return isalnum(c) || c == '_' || c == '-' || c == ':' || c == '%' || c == '.';
+}
+
+static const struct {
+	const char	*name;
+	int		tok;
+	int		op;
+} filter_words[] = {
+	{ "and",   F_TOK_AND },
+	{ "or",    F_TOK_OR },
+	{ "not",   F_TOK_NOT },
+	{ "eq",    F_TOK_OPERATOR, F_OP_EQ },
+	{ "ne",    F_TOK_OPERATOR, F_OP_NE },
+	{ "lt",    F_TOK_OPERATOR, F_OP_LT },
+	{ "le",    F_TOK_OPERATOR, F_OP_LE },
+	{ "gt",    F_TOK_OPERATOR, F_OP_GT },
+	{ "ge",    F_TOK_OPERATOR, F_OP_GE },
+	{ "true",  F_TOK_BOOLEAN, 1 },
+	{ "false", F_TOK_BOOLEAN, 0 }
+};
+
+static const struct {
+	const char	*str;
+	int		tok;
+	int		op;
+} filter_symbols[] = {
+	/* longer first */
+	{ "&&", F_TOK_AND },
+	{ "||", F_TOK_OR },
+	{ "==", F_TOK_OPERATOR, F_OP_EQ },
+	{ "!=", F_TOK_OPERATOR, F_OP_NE },
+	{ "<=", F_TOK_OPERATOR, F_OP_LE },
+	{ ">=", F_TOK_OPERATOR, F_OP_GE },
+	{ "=~", F_TOK_OPERATOR, F_OP_REG },
+	{ "!~", F_TOK_OPERATOR, F_OP_NREG },
+	{ "<",  F_TOK_OPERATOR, F_OP_LT },
+	{ ">",  F_TOK_OPERATOR, F_OP_GT },
+	{ "!",  F_TOK_NOT },
+	{ "(",  F_TOK_LPAREN },
+	{ ")",  F_TOK_RPAREN }
+};
+
+/* reads the next token */
+static int next_token(struct filter_parser *pr)
+{
+	const char *p = pr->p;
+	size_t i;
+
+	free(pr->tokstr);
+	pr->tokstr = NULL;
+
+	while (isspace((unsigned char) *p))
+		p++;
+	pr->tokpos = p;
+
+	if (!*p) {
+		pr->tok = F_TOK_END;
+		pr->p = p;
+		return 0;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(filter_symbols); i++) {
+		size_t sz = strlen(filter_symbols[i].str);
+
+		if (strncmp(p, filter_symbols[i].str, sz) == 0) {
+			pr->tok = filter_symbols[i].tok;
+			pr->op = filter_symbols[i].op;
+			pr->p = p + sz;
+			return 0;
+		}
+	}
+
+	/* "string" or 'string' */
+	if (*p == '"' || *p == '\'') {
+		const char quote = *p++;
+		char *str = malloc(strlen(p) + 1), *x = str;
+
+		if (!str)
+			return -ENOMEM;
+		while (*p && *p != quote) {
+			/* keep other backslashes for regular expressions */
+			if (*p == '\\' && (*(p + 1) == quote || *(p + 1) == '\\'))
+				p++;
+			*x++ = *p++;
+		}
+		*x = '\0';
+		if (*p != quote) {
+			free(str);
+			return parser_error(pr, "unterminated string at position %zu",
+					(size_t) (pr->tokpos - pr->str) + 1);
+		}
+		pr->tok = F_TOK_STRING;
+		pr->tokstr = str;
+		pr->p = p + 1;
+		return 0;
+	}
+
+	/* number */
+	if (isdigit((unsigned char) *p)
+	    || ((*p == '-' || *p == '.') && isdigit((unsigned char) *(p + 1)))) {
+		char *end = NULL;
+
+		errno = 0;
+		pr->toknum = strtold(p, &end);
+		if (errno || !end || end == p || is_name_char((unsigned char) *end))
+			return parser_error(pr, "invalid number at position %zu",
+					(size_t) (pr->tokpos - pr->str) + 1);
+		pr->tok = F_TOK_NUMBER;
+		pr->p = end;
+		return 0;
+	}
+
+	/* column name or keyword */
+	if (is_name_char((unsigned char) *p)) {
+		const char *begin = p;
+		size_t sz;
+
+		while (is_name_char((unsigned char) *p))
+			p++;
+		sz = p - begin;
+		pr->p = p;
+
+		for (i = 0; i < ARRAY_SIZE(filter_words); i++) {
+			if (strlen(filter_words[i].name) == sz
+			    && strncasecmp(begin, filter_words[i].name, sz) == 0) {
+				pr->tok = filter_words[i].tok;
+				pr->op = filter_words[i].op;
+				pr->tokbool = filter_words[i].op;
+				return 0;
+			}
+		}
+		pr->tok = F_TOK_NAME;
+		pr->tokstr = strndup(begin, sz);
+		return pr->tokstr ? 0 : -ENOMEM;
+	}
+
+	return parser_error(pr, "unexpected '%c' at position %zu", *p,
+			(size_t) (p - pr->str) + 1);
+}
+
+static int unexpected_token(struct filter_parser *pr)
+{
+	if (pr->tok == F_TOK_END)
+		return parser_error(pr, "unexpected end of expression");
+	return parser_error(pr, "unexpected token at position %zu",
+			(size_t) (pr->tokpos - pr->str) + 1);
+}
+
+static struct filter_node *new_node(int type)
+{
+	struct filter_node *n = calloc(1, sizeof(*n));
+
+	if (n)
+		n->type = type;
+	return n;
+}
+
+/* converts the current token to the param */
+static int parse_param(struct filter_parser *pr, struct filter_param *pa)
+{
+	switch (pr->tok) {
+	case F_TOK_NAME:
+		pa->type = F_PARAM_NAME;
+		break;
+	case F_TOK_STRING:
+		pa->type = F_PARAM_STRING;
+		break;
+	case F_TOK_NUMBER:
+		pa->type = F_PARAM_NUMBER;
+		pa->num = pr->toknum;
+		break;
+	case F_TOK_BOOLEAN:
+		pa->type = F_PARAM_BOOLEAN;
+		pa->boolean = pr->tokbool;
+		break;
+	default:
+		return unexpected_token(pr);
+	}
+
+	pa->str = pr->tokstr;	/* steal */
+	pr->tokstr = NULL;
+	return next_token(pr);
+}
+
+static int parse_or(struct filter_parser *pr, struct filter_node **res);
+
+/* "(" expr ")" | "!" primary | param [operator param] */
+static int parse_primary(struct filter_parser *pr, struct filter_node **res)
+{
+	struct filter_node *n;
+	int rc;
+
+	*res = NULL;
+
+	if (pr->tok == F_TOK_LPAREN) {
+		rc = next_token(pr);
+		if (!rc)
+			rc = parse_or(pr, res);
+		if (!rc && pr->tok != F_TOK_RPAREN)
+			rc = unexpected_token(pr);
+		if (!rc)
+			rc = next_token(pr);
+		return rc;
+	}
+
+	if (pr->tok == F_TOK_NOT) {
+		n = new_node(F_NODE_NOT);
+		if (!n)
+			return -ENOMEM;
+		*res = n;
+		rc = next_token(pr);
+		return rc ? rc : parse_primary(pr, &n->left);
+	}
+
+	n = new_node(F_NODE_PARAM);
+	if (!n)
+		return -ENOMEM;
+	*res = n;
+
+	rc = parse_param(pr, &n->a);
+	if (rc || pr->tok != F_TOK_OPERATOR)
+		return rc;
+
+	n->type = F_NODE_CMP;
+	n->op = pr->op;
+
+	rc = next_token(pr);
+	if (!rc)
+		rc = parse_param(pr, &n->b);
+	if (rc)
+		return rc;
+
+	if (n->op == F_OP_REG || n->op == F_OP_NREG) {
+		if (n->b.type != F_PARAM_STRING)
+			return parser_error(pr, "regular expression has to be a string");
+		n->re = malloc(sizeof(regex_t));
+		if (!n->re)
+			return -ENOMEM;
+		rc = regcomp(n->re, n->b.str, REG_EXTENDED | REG_NOSUB);
+		if (rc) {
+			char buf[BUFSIZ];
+
+			regerror(rc, n->re, buf, sizeof(buf));
+			free(n->re);
+			n->re = NULL;
+			return parser_error(pr, "'%s': %s", n->b.str, buf);
+		}
+	}
+	return 0;
+}
+
+/* primary ["&&" primary ...] */
+static int parse_and(struct filter_parser *pr, struct filter_node **res)
+{
+	int rc = parse_primary(pr, res);
+
+	while (rc == 0 && pr->tok == F_TOK_AND) {
+		struct filter_node *n = new_node(F_NODE_AND);
+
+		if (!n)
+			return -ENOMEM;
+		n->left = *res;
+		*res = n;
+		rc = next_token(pr);
+		if (!rc)
+			rc = parse_primary(pr, &n->right);
+	}
+	return rc;
+}
+
+/* and ["||" and ...] */
+static int parse_or(struct filter_parser *pr, struct filter_node **res)
+{
+	int rc = parse_and(pr, res);
+
+	while (rc == 0 && pr->tok == F_TOK_OR) {
+		struct filter_node *n = new_node(F_NODE_OR);
+
+		if (!n)
+			return -ENOMEM;
+		n->left = *res;
+		*res = n;
+		rc = next_token(pr);
+		if (!rc)
+			rc = parse_and(pr, &n->right);
+	}
+	return rc;
+}
+
+/**
+ * scols_filter_parse_string:
+ * @fltr: filter instance
+ * @str: expression
+ *
+ * Parses and compiles the expression, the previous expression is removed.
+ * Use scols_filter_get_errmsg() to get details about syntax errors.
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_filter_parse_string(struct libscols_filter *fltr, const char *str)
+{
+	struct filter_parser pr = { .fltr = fltr, .str = str, .p = str };
+	struct filter_node *root = NULL;
+	int rc;
+
+	if (!fltr || !str)
+		return -EINVAL;
+
+	DBG(FLTR, ul_debugobj(fltr, "parsing '%s'", str));
+	reset_filter(fltr);
+
+	rc = next_token(&pr);
+	if (!rc)
+		rc = parse_or(&pr, &root);
+	if (!rc && pr.tok != F_TOK_END)
+		rc = unexpected_token(&pr);
+
+	free(pr.tokstr);
+	if (rc) {
+		free_node(root);
+		return rc;
+	}
+	fltr->root = root;
+	return 0;
+}
+
+/**
+ * scols_new_filter:
+ * @str: filter expression or NULL
+ *
+ * Allocates a new filter and parses @str (see scols_filter_parse_string()).
+ * The function returns the filter also if the expression is invalid, use
+ * scols_filter_get_errmsg() to check it.
+ *
+ * Returns: a pointer to a new struct libscols_filter instance or NULL in case
+ * of an allocation error.
+ *
+ * Since: 2.37
+ */
+struct libscols_filter *scols_new_filter(const char *str)
+{
+	struct libscols_filter *fltr = calloc(1, sizeof(*fltr));
+
+	if (!fltr)
+		return NULL;
+
+	DBG(FLTR, ul_debugobj(fltr, "alloc"));
+	fltr->refcount = 1;
+
+	if (str && scols_filter_parse_string(fltr, str) == -ENOMEM) {
+		scols_unref_filter(fltr);
+		return NULL;
+	}
+	return fltr;
+}
+
+/**
+ * scols_ref_filter:
+ * @fltr: filter instance
+ *
+ * Increases the refcount of @fltr.
+ *
+ * Since: 2.37
+ */
+void scols_ref_filter(struct libscols_filter *fltr)
+{
+	if (fltr)
+		fltr->refcount++;
+}
+
+/**
+ * scols_unref_filter:
+ * @fltr: filter instance
+ *
+ * Decreases the refcount of @fltr. When the count falls to zero, the instance
+ * is automatically deallocated.
+ *
+ * Since: 2.37
+ */
+void scols_unref_filter(struct libscols_filter *fltr)
+{
+	if (fltr && --fltr->refcount <= 0) {
+		DBG(FLTR, ul_debugobj(fltr, "dealloc"));
+		reset_filter(fltr);
+		free(fltr);
+	}
+}
+
+/**
+ * scols_filter_get_errmsg:
+ * @fltr: filter instance
+ *
+ * Returns: error message from the last scols_filter_parse_string() or
+ * scols_table_set_filter(), or NULL.
+ *
+ * Since: 2.37
+ */
+const char *scols_filter_get_errmsg(struct libscols_filter *fltr)
+{
+	return fltr ? fltr->errmsg : NULL;
+}
+
+static int bind_param(struct libscols_filter *fltr,
+		      struct libscols_table *tb,
+		      struct filter_param *pa)
+{
+	struct libscols_column *cl;
+	struct libscols_iter itr;
+
+	if (pa->type != F_PARAM_NAME)
+		return 0;
+
+	pa->cl = NULL;
+	scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
+	while (scols_table_next_column(tb, &itr, &cl) == 0) {
+		const char *name = scols_cell_get_data(&cl->header);
+
+		if (name && strcasecmp(name, pa->str) == 0) {
+			pa->cl = cl;
+			return 0;
+		}
+	}
+
+	free(fltr->errmsg);
+	if (asprintf(&fltr->errmsg, "unknown column '%s'", pa->str) < 0)
+		fltr->errmsg = NULL;
+	return -EINVAL;
+}
+
+static int bind_node(struct libscols_filter *fltr,
+		     struct libscols_table *tb,
+		     struct filter_node *n)
+{
+	int rc = 0;
+
+	if (!n)
+		return 0;
+	if (n->left)
+		rc = bind_node(fltr, tb, n->left);
+	if (!rc && n->right)
+		rc = bind_node(fltr, tb, n->right);
+	if (!rc && (n->type == F_NODE_CMP || n->type == F_NODE_PARAM))
+		rc = bind_param(fltr, tb, &n->a);
+	if (!rc && n->type == F_NODE_CMP)
+		rc = bind_param(fltr, tb, &n->b);
+	return rc;
+}
+
+/* the same as SCOLS_JSON_BOOLEAN in print_json_data() */
+static int str_to_boolean(const char *str)
+{
+	return !str || !*str ? 0 :
+		*str == '0' ? 0 :
+		*str == 'N' || *str == 'n' ? 0 : 1;
+}
+
+static const char *param_get_string(struct filter_param *pa, struct libscols_line *ln)
+{
+	const char *str;
+
+	if (pa->type != F_PARAM_NAME)
+		return pa->str ? pa->str : "";
+
+	str = scols_cell_get_data(scols_line_get_cell(ln, pa->cl->seqnum));
+	return str ? str : "";
+}
+
+static int param_get_number(struct filter_param *pa, struct libscols_line *ln,
+			    long double *num)
+{
+	const char *str;
+	char *end = NULL;
+
+	switch (pa->type) {
+	case F_PARAM_NUMBER:
+		*num = pa->num;
+		return 0;
+	case F_PARAM_BOOLEAN:
+		*num = pa->boolean;
+		return 0;
+	default:
+		break;
+	}
+
+	str = param_get_string(pa, ln);
+	errno = 0;
+	*num = strtold(str, &end);
+	if (errno || !end || end == str)
+		return -EINVAL;
+	while (isspace((unsigned char) *end))
+		end++;
+	return *end ? -EINVAL : 0;
+}
+
+static int param_get_boolean(struct filter_param *pa, struct libscols_line *ln)
+{
+	switch (pa->type) {
+	case F_PARAM_BOOLEAN:
+		return pa->boolean;
+	case F_PARAM_NUMBER:
+		return pa->num != 0;
+	default:
+		return str_to_boolean(param_get_string(pa, ln));
+	}
+}
+
+static int cmp_result(int op, int cmp)
+{
+	switch (op) {
+	case F_OP_EQ:
+		return cmp == 0;
+	case F_OP_NE:
+		return cmp != 0;
+	case F_OP_LT:
+		return cmp < 0;
+	case F_OP_LE:
+		return cmp <= 0;
+	case F_OP_GT:
+		return cmp > 0;
+	case F_OP_GE:
+		return cmp >= 0;
+	}
+	return 0;
+}
+
+static int eval_cmp(struct filter_node *n, struct libscols_line *ln)
+{
+	struct filter_param *a = &n->a, *b = &n->b;
+
+	if (n->re) {
+		int rc = regexec(n->re, param_get_string(a, ln), 0, NULL, 0);
+
+		return n->op == F_OP_REG ? rc == 0 : rc != 0;
+	}
+
+	if (a->type == F_PARAM_BOOLEAN || b->type == F_PARAM_BOOLEAN)
+		return cmp_result(n->op,
+			param_get_boolean(a, ln) - param_get_boolean(b, ln));
+
+	if (a->type == F_PARAM_NUMBER || b->type == F_PARAM_NUMBER) {
+		long double x, y;
+
+		if (param_get_number(a, ln, &x) || param_get_number(b, ln, &y))
+			return 0;	/* not a number, does not match */
+		return cmp_result(n->op, x == y ? 0 : x < y ? -1 : 1);
+	}
+
+	return cmp_result(n->op, strcmp(param_get_string(a, ln),
+					param_get_string(b, ln)));
+}
+
+static int eval_node(struct filter_node *n, struct libscols_line *ln)
+{
+	switch (n->type) {
+	case F_NODE_AND:
+		return eval_node(n->left, ln) && eval_node(n->right, ln);
+	case F_NODE_OR:
+		return eval_node(n->left, ln) || eval_node(n->right, ln);
+	case F_NODE_NOT:
+		return !eval_node(n->left, ln);
+	case F_NODE_CMP:
+		return eval_cmp(n, ln);
+	case F_NODE_PARAM:
+		return param_get_boolean(&n->a, ln);
+	}
+	return 0;
+}
+
+/**
+ * scols_table_set_filter:
+ * @tb: table
+ * @fltr: filter instance or NULL
+ *
+ * Sets the lines filter. The column names used in the filter expression are
+ * resolved by this function, so all the columns have to be already defined
+ * (the columns may be hidden, see SCOLS_FL_HIDDEN).
+ *
+ * The line is evaluated when the next line is added to the table, or before
+ * the table is printed. The lines that do not match are removed from the
+ * table, so they are not used for columns width calculation and they do not
+ * occupy memory. It means that the line data have to be set before the next
+ * line is added, and the line cannot be used as a parent after that, unless
+ * the line is already in a parent-child relation.
+ *
+ * In tree output the lines are evaluated before printing only, and parents
+ * of the matching lines are never removed.
+ *
+ * Returns: 0, a negative value in case of an error (see
+ * scols_filter_get_errmsg() for unknown columns).
+ *
+ * Since: 2.37
+ */
+int scols_table_set_filter(struct libscols_table *tb, struct libscols_filter *fltr)
+{
+	int rc;
+
+	if (!tb)
+		return -EINVAL;
+
+	if (fltr) {
+		if (!fltr->root)
+			return -EINVAL;
+		rc = bind_node(fltr, tb, fltr->root);
+		if (rc)
+			return rc;
+		scols_ref_filter(fltr);
+	}
+
+	DBG(TAB, ul_debugobj(tb, "set filter %p", fltr));
+	scols_unref_filter(tb->filter);
+	tb->filter = fltr;
+	return 0;
+}
+
+/**
+ * scols_table_get_filter:
+ * @tb: table
+ *
+ * Returns: the filter or NULL.
+ *
+ * Since: 2.37
+ */
+struct libscols_filter *scols_table_get_filter(struct libscols_table *tb)
+{
+	return tb->filter;
+}
+
+/* returns 1 if the line matches, the line is evaluated only once */
+static int filter_line(struct libscols_table *tb, struct libscols_line *ln)
+{
+	if (!ln->filtered) {
+		ln->filtered = 1;
+		ln->filter_match = eval_node(tb->filter->root, ln);
+		DBG(FLTR, ul_debugobj(tb->filter, "line %zu: %s", ln->seqnum,
+				ln->filter_match ? "match" : "ignore"));
+	}
+	return ln->filter_match;
+}
+
+/*
+ * Removes the last line if it does not match the filter. This is called
+ * before a new line is added, so the last line is complete.
+ */
+void __scols_filter_last_line(struct libscols_table *tb)
+{
+	struct libscols_line *ln;
+
+	if (!tb->filter || list_empty(&tb->tb_lines) || scols_table_is_tree(tb))
+		return;
+
+	ln = list_entry(tb->tb_lines.prev, struct libscols_line, ln_lines);
+
+	/* lines in a hierarchy are evaluated before printing */
+	if (ln->parent || !list_empty(&ln->ln_branch)
+	    || ln->group || ln->parent_group)
+		return;
+	if (filter_line(tb, ln))
+		return;
+
+	scols_table_remove_line(tb, ln);
+}
+
+/* returns 1 if the line or any child is kept */
+static int filter_tree_line(struct libscols_table *tb, struct libscols_line *ln)
+{
+	struct list_head *p, *pnext;
+	int keep = 0;
+
+	list_for_each_safe(p, pnext, &ln->ln_branch) {
+		struct libscols_line *chld =
+				list_entry(p, struct libscols_line, ln_children);
+		if (filter_tree_line(tb, chld))
+			keep = 1;
+	}
+
+	if (keep || ln->group || ln->parent_group || filter_line(tb, ln))
+		return 1;
+
+	if (ln->parent)
+		scols_line_remove_child(ln->parent, ln);
+	scols_table_remove_line(tb, ln);
+	return 0;
+}
+
+/*
+ * Removes all not yet evaluated lines which do not match the filter. This is
+ * called before the table is printed.
+ */
+void __scols_filter_lines(struct libscols_table *tb)
+{
+	struct list_head *p, *pnext;
+
+	if (!tb->filter)
+		return;
+
+	DBG(FLTR, ul_debugobj(tb->filter, "filtering table"));
+
+	list_for_each_safe(p, pnext, &tb->tb_lines) {
+		struct libscols_line *ln = list_entry(p, struct libscols_line, ln_lines);
+
+		if (!scols_table_is_tree(tb)) {
+			if (!ln->group && !ln->parent_group && !filter_line(tb, ln))
+				scols_table_remove_line(tb, ln);
+			continue;
+		}
+
+		/* tree roots only, children are evaluated recursively */
+		if (ln->parent)
+			continue;
+
+		/* filter_tree_line() may remove the next line */
+		while (pnext != &tb->tb_lines) {
+			struct libscols_line *x = list_entry(pnext, struct libscols_line, ln_lines);
+
+			if (!x->parent)
+				break;
+			pnext = pnext->next;
+		}
+		filter_tree_line(tb, ln);
+	}
+}
@@ -35,14 +35,21 @@
  * Returns: a pointer to a new struct libscols_line instance.
  */
 struct libscols_line *scols_new_line(void)
+{
+	return __scols_new_line(NULL);
+}
+
+/* allocates line in arena @ar (if not NULL) */
+struct libscols_line *__scols_new_line(struct libscols_arena *ar)
 {
 	struct libscols_line *ln;
 
-	ln = calloc(1, sizeof(*ln));
+	ln = ar ? scols_arena_calloc(ar, sizeof(*ln)) : calloc(1, sizeof(*ln));
 	if (!ln)
 		return NULL;
 
-	DBG(LINE, ul_debugobj(ln, "alloc"));
+	DBG(LINE, ul_debugobj(ln, "alloc%s", ar ? " (arena)" : ""));
+	ln->arena = ar;
 	ln->refcount = 1;
 	INIT_LIST_HEAD(&ln->ln_lines);
 	INIT_LIST_HEAD(&ln->ln_children);
@@ -80,7 +87,8 @@ void scols_unref_line(struct libscols_line *ln)
 		scols_unref_group(ln->group);
 		scols_line_free_cells(ln);
 		free(ln->color);
-		free(ln);
+		if (!ln->arena)
+			free(ln);
 		return;
 	}
 }
@@ -103,7 +111,8 @@ void scols_line_free_cells(struct libscols_line *ln)
 	for (i = 0; i < ln->ncells; i++)
 		scols_reset_cell(&ln->cells[i]);
 
-	free(ln->cells);
+	if (!ln->arena)
+		free(ln->cells);
 	ln->ncells = 0;
 	ln->cells = NULL;
 }
@@ -136,9 +145,19 @@ int scols_line_alloc_cells(struct libscols_line *ln, size_t n)
 
 	DBG(LINE, ul_debugobj(ln, "alloc %zu cells", n));
 
-	ce = realloc(ln->cells, n * sizeof(struct libscols_cell));
-	if (!ce)
-		return -errno;
+	if (ln->arena) {
+		/* the old array is not deallocated, it's part of the arena */
+		ce = scols_arena_alloc(ln->arena, n * sizeof(struct libscols_cell));
+		if (!ce)
+			return -ENOMEM;
+		if (ln->cells)
+			memcpy(ce, ln->cells,
+			       min(n, ln->ncells) * sizeof(struct libscols_cell));
+	} else {
+		ce = realloc(ln->cells, n * sizeof(struct libscols_cell));
+		if (!ce)
+			return -errno;
+	}
 
 	if (n > ln->ncells)
 		memset(ce + ln->ncells, 0,
@@ -442,6 +461,13 @@ int scols_line_set_data(struct libscols_line *ln, size_t n, const char *data)
 
 	if (!ce)
 		return -EINVAL;
+	if (ln->arena && data) {
+		char *p = scols_arena_strdup(ln->arena, data);
+
+		if (!p)
+			return -ENOMEM;
+		return scols_cell_refer_arena_data(ce, p);
+	}
 	return scols_cell_set_data(ce, data);
 }
 
@@ -470,6 +496,10 @@ int scols_line_set_column_data(struct libscols_line *ln,
  * @n: number of the cell which will refer to @data
  * @data: actual data to refer to
  *
+ * If the line has been allocated by a table with enabled memory pool (see
+ * scols_table_enable_arena()), then @data are copied to the pool and
+ * deallocated by free() immediately.
+ *
  * Returns: 0, a negative value in case of an error.
  */
 int scols_line_refer_data(struct libscols_line *ln, size_t n, char *data)
@@ -478,6 +508,15 @@ int scols_line_refer_data(struct libscols_line *ln, size_t n, char *data)
 
 	if (!ce)
 		return -EINVAL;
+	if (ln->arena && data) {
+		/* copy to the arena, the heap memory is deallocated immediately */
+		char *p = scols_arena_strdup(ln->arena, data);
+
+		if (!p)
+			return -ENOMEM;
+		free(data);
+		return scols_cell_refer_arena_data(ce, p);
+	}
 	return scols_cell_refer_data(ce, data);
 }
 
@@ -9,6 +9,9 @@
  * If the start is the first line in the table than prints table header too.
  * The header is printed only once. This does not work for trees.
  *
+ * The table filter (see scols_table_set_filter()) is applied only if
+ * the whole table is printed (@start and @end are NULL).
+ *
  * Returns: 0, a negative value in case of an error.
  */
 int scols_table_print_range(	struct libscols_table *tb,
@@ -24,6 +27,9 @@ int scols_table_print_range(	struct libscols_table *tb,
 
 	DBG(TAB, ul_debugobj(tb, "printing range from API"));
 
+	if (tb->filter && !start && !end)
+		__scols_filter_lines(tb);
+
 	rc = __scols_initialize_printing(tb, &buf);
 	if (rc)
 		return rc;
@@ -98,6 +104,73 @@ int scols_table_print_range_to_string(
 }
 #endif
 
+static int print_table_begin(struct libscols_table *tb, struct libscols_buffer *buf)
+{
+	if (scols_table_is_json(tb)) {
+		ul_jsonwrt_root_open(&tb->json);
+		ul_jsonwrt_array_open(&tb->json, tb->name);
+	}
+
+	if (tb->format == SCOLS_FMT_HUMAN)
+		__scols_print_title(tb);
+
+	return __scols_print_header(tb, buf);
+}
+
+/*
+ * Streaming mode, called after a new line has been added to the table.
+ *
+ * Prints and removes all lines except the last one. The last line has been
+ * just added and it's probably not filled by data yet. It's also necessary to
+ * keep the line to know how to terminate JSON output.
+ */
+int __scols_print_stream(struct libscols_table *tb)
+{
+	struct libscols_buffer *buf = NULL;
+	struct libscols_line *ln, *end;
+	struct libscols_iter itr;
+	int rc;
+
+	assert(tb);
+
+	if (scols_table_is_tree(tb) || has_groups(tb) || list_empty(&tb->tb_columns))
+		return 0;	/* unsupported, print all by scols_print_table() */
+	if (tb->nlines < 2)
+		return 0;
+	if (!tb->stream_started && tb->nlines <= tb->stream_sample)
+		return 0;	/* sample is not complete yet */
+
+	end = list_entry(tb->tb_lines.prev->prev, struct libscols_line, ln_lines);
+
+	DBG(TAB, ul_debugobj(tb, "printing stream (%zu lines)", tb->nlines - 1));
+
+	if (!tb->stream_started)
+		tb->header_printed = 0;
+
+	rc = __scols_initialize_printing(tb, &buf);
+	if (rc)
+		return rc;
+
+	if (!tb->stream_started) {
+		rc = print_table_begin(tb, buf);
+		if (rc)
+			goto done;
+		tb->stream_started = 1;
+	}
+
+	scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
+	rc = __scols_print_range(tb, buf, &itr, end);
+
+	/* remove printed lines */
+	do {
+		ln = list_entry(tb->tb_lines.next, struct libscols_line, ln_lines);
+		scols_table_remove_line(tb, ln);
+	} while (ln != end);
+done:
+	__scols_cleanup_printing(tb, buf);
+	return rc;
+}
+
 static int do_print_table(struct libscols_table *tb, int *is_empty)
 {
 	int rc = 0;
@@ -110,11 +183,14 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 	if (is_empty)
 		*is_empty = 0;
 
+	if (tb->filter)
+		__scols_filter_lines(tb);
+
 	if (list_empty(&tb->tb_columns)) {
 		DBG(TAB, ul_debugobj(tb, "error -- no columns"));
 		return -EINVAL;
 	}
-	if (list_empty(&tb->tb_lines)) {
+	if (list_empty(&tb->tb_lines) && !tb->stream_started) {
 		DBG(TAB, ul_debugobj(tb, "ignore -- no lines"));
 		if (scols_table_is_json(tb)) {
 			ul_jsonwrt_init(&tb->json, tb->out, 0);
@@ -127,22 +203,21 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 		return 0;
 	}
 
-	tb->header_printed = 0;
+	if (!tb->stream_started)
+		tb->header_printed = 0;
+
 	rc = __scols_initialize_printing(tb, &buf);
-	if (rc)
+	if (rc) {
+		tb->stream_started = 0;
 		return rc;
-
-	if (scols_table_is_json(tb)) {
-		ul_jsonwrt_root_open(&tb->json);
-		ul_jsonwrt_array_open(&tb->json, tb->name);
 	}
 
-	if (tb->format == SCOLS_FMT_HUMAN)
-		__scols_print_title(tb);
-
-	rc = __scols_print_header(tb, buf);
-	if (rc)
-		goto done;
+	/* in streaming mode the beginning has been already printed */
+	if (!tb->stream_started) {
+		rc = print_table_begin(tb, buf);
+		if (rc)
+			goto done;
+	}
 
 	if (scols_table_is_tree(tb))
 		rc = __scols_print_tree(tb, buf);
@@ -154,6 +229,7 @@ static int do_print_table(struct libscols_table *tb, int *is_empty)
 		ul_jsonwrt_root_close(&tb->json);
 	}
 done:
+	tb->stream_started = 0;
 	__scols_cleanup_printing(tb, buf);
 	return rc;
 }
@@ -21,6 +21,12 @@
 #include <string.h>
 #include <termios.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
+#include <sys/uio.h>
 
 #include "mbsalign.h"
 #include "carefulputc.h"
@@ -435,7 +441,7 @@ err:
 	return -errno;
 }
 
-static void print_json_data(struct libscols_table *tb,
+static void print_json_data(struct ul_jsonwrt *json,
 			    struct libscols_column *cl,
 			    const char *name,
 			    char *data,
@@ -444,15 +450,15 @@ static void print_json_data(struct libscols_table *tb,
 	switch (cl->json_type) {
 	case SCOLS_JSON_STRING:
 		/* name: "aaa" */
-		ul_jsonwrt_value_s(&tb->json, name, data, is_last);
+		ul_jsonwrt_value_s(json, name, data, is_last);
 		break;
 	case SCOLS_JSON_NUMBER:
 		/* name: 123 */
-		ul_jsonwrt_value_raw(&tb->json, name, data, is_last);
+		ul_jsonwrt_value_raw(json, name, data, is_last);
 		break;
 	case SCOLS_JSON_BOOLEAN:
 		/* name: true|false */
-		ul_jsonwrt_value_boolean(&tb->json, name,
+		ul_jsonwrt_value_boolean(json, name,
 			!*data ? 0 :
 			*data == '0' ? 0 :
 			*data == 'N' || *data == 'n' ? 0 : 1,
@@ -461,21 +467,53 @@ static void print_json_data(struct libscols_table *tb,
 	case SCOLS_JSON_ARRAY_STRING:
 	case SCOLS_JSON_ARRAY_NUMBER:
 		/* name: [ "aaa", "bbb", "ccc" ] */
-		ul_jsonwrt_array_open(&tb->json, name);
+		ul_jsonwrt_array_open(json, name);
 
 		if (!scols_column_is_customwrap(cl))
-			ul_jsonwrt_value_s(&tb->json, NULL, data, 1);
+			ul_jsonwrt_value_s(json, NULL, data, 1);
 		else do {
 				char *next = cl->wrap_nextchunk(cl, data, cl->wrapfunc_data);
 
 				if (cl->json_type == SCOLS_JSON_ARRAY_STRING)
-					ul_jsonwrt_value_s(&tb->json, NULL, data, next ? 0 : 1);
+					ul_jsonwrt_value_s(json, NULL, data, next ? 0 : 1);
 				else
-					ul_jsonwrt_value_raw(&tb->json, NULL, data, next ? 0 : 1);
+					ul_jsonwrt_value_raw(json, NULL, data, next ? 0 : 1);
 				data = next;
 		} while (data);
 
-		ul_jsonwrt_array_close(&tb->json, is_last);
+		ul_jsonwrt_array_close(json, is_last);
+		break;
+	}
+}
+
+/* RAW, EXPORT and JSON output of the cell */
+static void print_data_nonhuman(struct libscols_table *tb,
+				struct libscols_column *cl,
+				FILE *out,
+				struct ul_jsonwrt *json,
+				const char *name,
+				char *data,
+				int is_last)
+{
+	switch (tb->format) {
+	case SCOLS_FMT_RAW:
+		fputs_nonblank(data, out);
+		if (!is_last)
+			fputs(colsep(tb), out);
+		break;
+
+	case SCOLS_FMT_EXPORT:
+		fputs_shell_ident(name, out);
+		if (endswith(name, "%"))
+			fputs("PCT", out);
+		fputc('=', out);
+		fputs_quoted(data, out);
+		if (!is_last)
+			fputs(colsep(tb), out);
+		break;
+
+	case SCOLS_FMT_JSON:
+		print_json_data(json, cl, name, data, is_last);
 		break;
 	}
 }
@@ -509,29 +547,9 @@ static int print_data(struct libscols_table *tb,
 		/* "children": [] is the real last value */
 		is_last = 0;
 
-	switch (tb->format) {
-	case SCOLS_FMT_RAW:
-		fputs_nonblank(data, tb->out);
-		if (!is_last)
-			fputs(colsep(tb), tb->out);
-		return 0;
-
-	case SCOLS_FMT_EXPORT:
-		fputs_shell_ident(name, tb->out);
-		if (endswith(name, "%"))
-			fputs("PCT", tb->out);
-		fputc('=', tb->out);
-		fputs_quoted(data, tb->out);
-		if (!is_last)
-			fputs(colsep(tb), tb->out);
-		return 0;
-
-	case SCOLS_FMT_JSON:
-		print_json_data(tb, cl, name, data, is_last);
+	if (tb->format != SCOLS_FMT_HUMAN) {
+		print_data_nonhuman(tb, cl, tb->out, &tb->json, name, data, is_last);
 		return 0;
-
-	case SCOLS_FMT_HUMAN:
-		break;		/* continue below */
 	}
 
 	color = get_cell_color(tb, cl, ln, ce);
@@ -928,10 +946,244 @@ int __scols_print_range(struct libscols_table *tb,
 
 }
 
+#if defined(HAVE_PTHREAD) && defined(HAVE_OPEN_MEMSTREAM)
+/*
+ * Parallel output for RAW, EXPORT and JSON formats. The lines are independent
+ * in these formats (no wrapping, no tree art, no header repeat), so the table
+ * is split to chunks, every chunk is rendered to memory by a separate thread
+ * and the chunks are written to the output in the original order.
+ */
+#define PARALLEL_CHUNK_LINES	4096
+
+struct print_chunk {
+	struct libscols_table	*tb;
+	struct libscols_line	*first;		/* first line of the chunk */
+	size_t			nlines;
+	int			is_last;	/* the last chunk of the table */
+
+	struct ul_jsonwrt	json;		/* JSON state at the begin of the chunk */
+	size_t			bufsz;
+
+	char			*data;		/* rendered output */
+	size_t			datasz;
+	int			rc;
+};
+
+static int print_chunk_line(struct print_chunk *ch,
+			    struct libscols_line *ln,
+			    struct libscols_buffer *buf,
+			    FILE *out, int last)
+{
+	struct libscols_table *tb = ch->tb;
+	struct libscols_column *cl;
+	struct libscols_iter itr;
+	int rc = 0;
+
+	if (scols_table_is_json(tb))
+		ul_jsonwrt_object_open(&ch->json, NULL);
+
+	scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
+	while (rc == 0 && scols_table_next_column(tb, &itr, &cl) == 0) {
+		char *data;
+
+		if (scols_column_is_hidden(cl))
+			continue;
+		rc = __cell_to_buffer(tb, ln, cl, buf);
+		if (rc)
+			break;
+		data = buffer_get_data(buf);
+		print_data_nonhuman(tb, cl, out, &ch->json,
+				scols_cell_get_data(&cl->header),
+				data ? data : "", is_last_column(cl));
+	}
+
+	if (scols_table_is_json(tb))
+		ul_jsonwrt_object_close(&ch->json, last);
+	else if (last == 0 && tb->no_linesep == 0)
+		fputs(linesep(tb), out);
+	return rc;
+}
+
+static void *print_chunk_thread(void *data)
+{
+	struct print_chunk *ch = (struct print_chunk *) data;
+	struct libscols_buffer *buf;
+	struct list_head *p = &ch->first->ln_lines;
+	FILE *out;
+	size_t i;
+
+	out = open_memstream(&ch->data, &ch->datasz);
+	if (!out) {
+		ch->rc = -errno;
+		return NULL;
+	}
+	buf = new_buffer(ch->bufsz);
+	if (!buf) {
+		ch->rc = -ENOMEM;
+		goto done;
+	}
+	ch->json.out = out;
+
+	for (i = 0; ch->rc == 0 && i < ch->nlines; i++, p = p->next) {
+		struct libscols_line *ln = list_entry(p, struct libscols_line, ln_lines);
+
+		ch->rc = print_chunk_line(ch, ln, buf, out,
+				ch->is_last && i + 1 == ch->nlines);
+	}
+	free_buffer(buf);
+done:
+	if (fclose(out) != 0 && !ch->rc)
+		ch->rc = -errno;
+	return NULL;
+}
+
+/* writes rendered chunks to the table output in the original order */
+static int write_chunks(struct libscols_table *tb,
+			struct print_chunk *chunks, size_t nchunks)
+{
+	struct iovec iov[nchunks];
+	size_t i, n = 0;
+	int fd;
+
+	if (fflush(tb->out) != 0)
+		return -errno;
+
+	fd = fileno(tb->out);
+	if (fd < 0 || nchunks > IOV_MAX) {
+		for (i = 0; i < nchunks; i++) {
+			if (chunks[i].datasz &&
+			    fwrite(chunks[i].data, 1, chunks[i].datasz, tb->out)
+						!= chunks[i].datasz)
+				return -EIO;
+		}
+		return 0;
+	}
+
+	for (i = 0; i < nchunks; i++) {
+		if (!chunks[i].datasz)
+			continue;
+		iov[n].iov_base = chunks[i].data;
+		iov[n].iov_len = chunks[i].datasz;
+		n++;
+	}
+
+	i = 0;
+	while (i < n) {
+		ssize_t sz = writev(fd, iov + i, n - i);
+
+		if (sz < 0) {
+			if (errno == EINTR)
+				continue;
+			return -errno;
+		}
+		/* partial write, skip already written buffers */
+		while (i < n && (size_t) sz >= iov[i].iov_len) {
+			sz -= iov[i].iov_len;
+			i++;
+		}
+		if (i < n) {
+			iov[i].iov_base = (char *) iov[i].iov_base + sz;
+			iov[i].iov_len -= sz;
+		}
+	}
+	return 0;
+}
+
+static int print_table_parallel(struct libscols_table *tb, struct libscols_buffer *buf)
+{
+	size_t nthreads = tb->nthreads, nchunks, i, done = 0;
+	size_t bufsz = buffer_get_size(buf);
+	struct list_head *p = tb->tb_lines.next;
+	int rc = 0;
+
+	nchunks = (tb->nlines + PARALLEL_CHUNK_LINES - 1) / PARALLEL_CHUNK_LINES;
+	if (nthreads > nchunks)
+		nthreads = nchunks;
+
+	DBG(TAB, ul_debugobj(tb, "printing %zu lines in %zu chunks by %zu threads",
+				tb->nlines, nchunks, nthreads));
+
+	/* render and write in rounds of 'nthreads' chunks to keep memory
+	 * usage limited */
+	while (rc == 0 && done < nchunks) {
+		size_t n = min(nthreads, nchunks - done);
+		struct print_chunk chunks[n];
+		pthread_t threads[n];
+		int started[n];
+
+		memset(chunks, 0, sizeof(chunks));
+
+		for (i = 0; i < n; i++) {
+			struct print_chunk *ch = &chunks[i];
+			size_t k, idx = done + i;
+
+			ch->tb = tb;
+			ch->bufsz = bufsz;
+			ch->first = list_entry(p, struct libscols_line, ln_lines);
+			ch->nlines = min((size_t) PARALLEL_CHUNK_LINES,
+					 tb->nlines - idx * PARALLEL_CHUNK_LINES);
+			ch->is_last = idx + 1 == nchunks;
+			ch->json = tb->json;
+			if (idx)
+				/* previous line has been closed by "}," */
+				ch->json.postponed_break = 1;
+
+			for (k = 0; k < ch->nlines; k++)
+				p = p->next;
+		}
+
+		for (i = 0; i < n; i++) {
+			started[i] = i > 0 && pthread_create(&threads[i], NULL,
+					print_chunk_thread, &chunks[i]) == 0;
+			if (i > 0 && !started[i])
+				DBG(TAB, ul_debugobj(tb, "cannot create thread, fallback"));
+		}
+		/* the current thread renders the first chunk, and chunks
+		 * where thread creation failed */
+		for (i = 0; i < n; i++) {
+			if (!started[i])
+				print_chunk_thread(&chunks[i]);
+		}
+		for (i = 0; i < n; i++) {
+			if (started[i])
+				pthread_join(threads[i], NULL);
+		}
+
+		for (i = 0; rc == 0 && i < n; i++)
+			rc = chunks[i].rc;
+		if (!rc)
+			rc = write_chunks(tb, chunks, n);
+		if (!rc && tb->format == SCOLS_FMT_JSON) {
+			tb->json.indent = chunks[n - 1].json.indent;
+			tb->json.postponed_break = chunks[n - 1].json.postponed_break;
+		}
+		for (i = 0; i < n; i++)
+			free(chunks[i].data);
+		done += n;
+	}
+
+	return rc;
+}
+
+static int want_parallel(struct libscols_table *tb)
+{
+	return tb->nthreads > 1
+	       && tb->format != SCOLS_FMT_HUMAN
+	       && !has_groups(tb)
+	       && tb->nlines >= 2 * PARALLEL_CHUNK_LINES;
+}
+#else
+# define want_parallel(tb)	0
+# define print_table_parallel(tb, buf)	(-ENOSYS)
+#endif /* HAVE_PTHREAD && HAVE_OPEN_MEMSTREAM */
+
 int __scols_print_table(struct libscols_table *tb, struct libscols_buffer *buf)
 {
 	struct libscols_iter itr;
 
+	if (want_parallel(tb))
+		return print_table_parallel(tb, buf);
+
 	scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
 	return __scols_print_range(tb, buf, &itr, NULL);
 }
@@ -1054,7 +1306,8 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 	if (tb->is_term) {
 		size_t width = (size_t) scols_table_get_termwidth(tb);
 
-		if (tb->termreduce > 0 && tb->termreduce < width) {
+		/* already reduced in streaming mode */
+		if (tb->termreduce > 0 && tb->termreduce < width && !tb->stream_started) {
 			width -= tb->termreduce;
 			scols_table_set_termwidth(tb, width);
 		}
@@ -1077,7 +1330,8 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 		extra_bufsz += tb->ncols;			/* separator between columns */
 		break;
 	case SCOLS_FMT_JSON:
-		ul_jsonwrt_init(&tb->json, tb->out, 0);
+		if (!tb->stream_started)
+			ul_jsonwrt_init(&tb->json, tb->out, 0);
 		extra_bufsz += tb->nlines * 3;		/* indentation */
 		/* fallthrough */
 	case SCOLS_FMT_EXPORT:
@@ -1123,7 +1377,14 @@ int __scols_initialize_printing(struct libscols_table *tb, struct libscols_buffe
 	if (has_groups(tb) && scols_table_is_tree(tb))
 		scols_groups_fix_members_order(tb);
 
-	if (tb->format == SCOLS_FMT_HUMAN) {
+	/*
+	 * In streaming mode the width is calculated only once, from the
+	 * lines sample.
+	 */
+	if (tb->format == SCOLS_FMT_HUMAN && !tb->stream_started) {
+		/* cached cells width is valid during one calculation only;
+		 * scols_line_refer_data() users may modify the data in place */
+		tb->width_gen++;
 		rc = __scols_calculate(tb, *buf);
 		if (rc != 0)
 			goto err;
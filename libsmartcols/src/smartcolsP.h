@@ -31,6 +31,7 @@
 #define SCOLS_DEBUG_COL		(1 << 5)
 #define SCOLS_DEBUG_BUFF	(1 << 6)
 #define SCOLS_DEBUG_GROUP	(1 << 7)
+#define SCOLS_DEBUG_FLTR	(1 << 8)
 #define SCOLS_DEBUG_ALL		0xFFFF
 
 UL_DEBUG_DECLARE_MASK(libsmartcols);
@@ -80,9 +81,15 @@ struct libscols_cell {
 	char	*color;
 	void    *userdata;
 	int	flags;
+
+	size_t	width;		/* cached number of cells for data */
+	size_t	width_gen;	/* libscols_table->width_gen when width cached */
+
+	unsigned int is_arena_data : 1;	/* data allocated in table arena */
 };
 
 extern int scols_line_move_cells(struct libscols_line *ln, size_t newn, size_t oldn);
+extern int scols_cell_refer_arena_data(struct libscols_cell *ce, char *data);
 
 /*
  * Table column
@@ -185,8 +192,18 @@ struct libscols_line {
 	struct libscols_line	*parent;
 	struct libscols_group	*parent_group;	/* for group childs */
 	struct libscols_group	*group;		/* for group members */
+
+	struct libscols_arena	*arena;		/* line allocated in the table arena */
+
+	unsigned int	filtered	:1,	/* evaluated by table filter */
+			filter_match	:1;	/* matches table filter */
 };
 
+/*
+ * Default number of lines used to calculate columns width in streaming mode
+ */
+#define SCOLS_STREAM_SAMPLE_DEFAULT	64
+
 enum {
 	SCOLS_FMT_HUMAN = 0,		/* default, human readable */
 	SCOLS_FMT_RAW,			/* space separated */
@@ -227,11 +244,19 @@ struct libscols_table {
 
 	struct ul_jsonwrt	json;		/* JSON formatting */
 
+	struct libscols_arena	*arena;		/* memory for lines and cells */
+	struct libscols_filter	*filter;	/* lines filter */
+
 	int	format;		/* SCOLS_FMT_* */
 
+	size_t	width_gen;	/* cells width cache generation, incremented by print */
+
 	size_t	termlines_used;	/* printed line counter */
 	size_t	header_next;	/* where repeat header */
 
+	size_t	stream_sample;	/* number of lines to calculate width in streaming mode */
+	size_t	nthreads;	/* number of threads to print RAW, EXPORT and JSON output */
+
 	/* flags */
 	unsigned int	ascii		:1,	/* don't use unicode */
 			colors_wanted	:1,	/* enable colors */
@@ -247,7 +272,10 @@ struct libscols_table {
 			no_headings	:1,	/* don't print header */
 			no_encode	:1,	/* don't care about control and non-printable chars */
 			no_linesep	:1,	/* don't print line separator */
-			no_wrap		:1;	/* never wrap lines */
+			no_wrap		:1,	/* never wrap lines */
+			streaming	:1,	/* print and remove lines as soon as possible */
+			use_arena	:1,	/* allocate new lines in the arena */
+			stream_started	:1;	/* streaming: widths calculated, header printed */
 };
 
 #define IS_ITER_FORWARD(_i)	((_i)->direction == SCOLS_ITER_FORWARD)
@@ -276,9 +304,26 @@ static inline int scols_iter_is_last(const struct libscols_iter *itr)
 	return itr->p == itr->head;
 }
 
+/*
+ * arena.c
+ */
+struct libscols_arena;
+extern struct libscols_arena *scols_new_arena(void);
+extern void scols_free_arena(struct libscols_arena *ar);
+extern void *scols_arena_alloc(struct libscols_arena *ar, size_t sz);
+extern void *scols_arena_calloc(struct libscols_arena *ar, size_t sz);
+extern char *scols_arena_strdup(struct libscols_arena *ar, const char *str);
+
+/*
+ * filter.c
+ */
+extern void __scols_filter_last_line(struct libscols_table *tb);
+extern void __scols_filter_lines(struct libscols_table *tb);
+
 /*
  * line.c
  */
+extern struct libscols_line *__scols_new_line(struct libscols_arena *ar);
 int scols_line_next_group_child(struct libscols_line *ln,
                           struct libscols_iter *itr,
                           struct libscols_line **chld);
@@ -358,6 +403,11 @@ int __scols_print_range(struct libscols_table *tb,
                         struct libscols_iter *itr,
                         struct libscols_line *end);
 
+/*
+ * print-api.c
+ */
+int __scols_print_stream(struct libscols_table *tb);
+
 static inline int is_tree_root(struct libscols_line *ln)
 {
 	return ln && !ln->parent && !ln->parent_group;
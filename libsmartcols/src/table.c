@@ -80,6 +80,8 @@ struct libscols_table *scols_new_table(void)
 	get_terminal_dimension(&c, &l);
 	tb->termwidth  = c > 0 ? c : 80;
 	tb->termheight = l > 0 ? l : 24;
+	tb->stream_sample = SCOLS_STREAM_SAMPLE_DEFAULT;
+	tb->nthreads = 1;
 
 	INIT_LIST_HEAD(&tb->tb_lines);
 	INIT_LIST_HEAD(&tb->tb_columns);
@@ -134,6 +136,8 @@ void scols_unref_table(struct libscols_table *tb)
 		free(tb->linesep);
 		free(tb->colsep);
 		free(tb->name);
+		scols_unref_filter(tb->filter);
+		scols_free_arena(tb->arena);
 		free(tb);
 		DBG(TAB, ul_debug("<- done"));
 	}
@@ -635,10 +639,17 @@ int scols_table_add_line(struct libscols_table *tb, struct libscols_line *ln)
 			return rc;
 	}
 
+	/* the last line is complete now */
+	if (tb->filter)
+		__scols_filter_last_line(tb);
+
 	DBG(TAB, ul_debugobj(tb, "add line"));
 	list_add_tail(&ln->ln_lines, &tb->tb_lines);
 	ln->seqnum = tb->nlines++;
 	scols_ref_line(ln);
+
+	if (tb->streaming)
+		return __scols_print_stream(tb);
 	return 0;
 }
 
@@ -738,14 +749,19 @@ struct libscols_line *scols_table_new_line(struct libscols_table *tb,
 	if (!tb)
 		return NULL;
 
-	ln = scols_new_line();
+	ln = __scols_new_line(tb->use_arena && !tb->streaming ? tb->arena : NULL);
 	if (!ln)
 		return NULL;
 
-	if (scols_table_add_line(tb, ln))
-		goto err;
+	/* link to the parent first, the table filter does not remove
+	 * parents when the line is added */
 	if (parent)
 		scols_line_add_child(parent, ln);
+	if (scols_table_add_line(tb, ln)) {
+		if (parent)
+			scols_line_remove_child(parent, ln);
+		goto err;
+	}
 
 	scols_unref_line(ln);	/* ref-counter incremented by scols_table_add_line() */
 	return ln;
@@ -1273,6 +1289,181 @@ int scols_table_is_noencoding(const struct libscols_table *tb)
 	return tb->no_encode;
 }
 
+/**
+ * scols_table_enable_streaming:
+ * @tb: table
+ * @enable: 1 or 0
+ *
+ * Enable streaming mode. In this mode the library does not keep all lines
+ * in memory. Columns width is calculated from the first lines (see
+ * scols_table_set_streaming_sample()) and column width hints only, then the
+ * header and the sampled lines are printed. Since then every line is printed
+ * and removed from the table when the next line is added by
+ * scols_table_add_line() or scols_table_new_line(). The rest of the table is
+ * printed by scols_print_table() as usually.
+ *
+ * It means that the line cannot be modified after the next line has been
+ * added and functions like scols_sort_table() or scols_table_get_line() work
+ * only for the lines not printed yet. The later lines wider than the sampled
+ * lines are printed in the same way as with terminal output (truncated or
+ * wrapped according to column flags).
+ *
+ * The streaming mode is ignored for tree and groups output, the lines are
+ * printed by scols_print_table() in this case.
+ *
+ * The mode has to be enabled before the first line is added to the table.
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_enable_streaming(struct libscols_table *tb, int enable)
+{
+	if (!tb || tb->stream_started)
+		return -EINVAL;
+	DBG(TAB, ul_debugobj(tb, "streaming: %s", enable ? "ENABLE" : "DISABLE"));
+	tb->streaming = enable ? 1 : 0;
+	return 0;
+}
+
+/**
+ * scols_table_enable_arena:
+ * @tb: table
+ * @enable: 1 or 0
+ *
+ * Allocate lines created by scols_table_new_line() and their cells and data
+ * from a table-scoped memory pool. The pool is deallocated at once by
+ * scols_unref_table(), it means millions of small allocations and
+ * deallocations are replaced by a few large ones.
+ *
+ * The data set by scols_line_set_data() are copied to the pool. Note that
+ * scols_line_refer_data() does not keep the @data pointer for lines from the
+ * pool: the string is copied to the pool and the caller's buffer is
+ * deallocated by free() immediately, so the caller must not use or modify the
+ * buffer after the call.
+ *
+ * The lines from the pool must not outlive the table. It means that all
+ * references to the lines (see scols_ref_line()) have to be dropped before
+ * scols_unref_table() deallocates the table; the line cannot be used, nor
+ * unreferenced, nor added to another table later. The memory is not reused if
+ * a line is removed from the table. The pool is not used in streaming mode
+ * (see scols_table_enable_streaming()).
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_enable_arena(struct libscols_table *tb, int enable)
+{
+	if (!tb)
+		return -EINVAL;
+
+	DBG(TAB, ul_debugobj(tb, "arena: %s", enable ? "ENABLE" : "DISABLE"));
+	if (enable && !tb->arena) {
+		tb->arena = scols_new_arena();
+		if (!tb->arena)
+			return -ENOMEM;
+	}
+	/* the arena is deallocated by scols_unref_table() only, it may be
+	 * still used by the lines */
+	tb->use_arena = enable ? 1 : 0;
+	return 0;
+}
+
+/**
+ * scols_table_is_arena:
+ * @tb: a pointer to a struct libscols_table instance
+ *
+ * Returns: 1 if lines are allocated in the table memory pool.
+ *
+ * Since: 2.37
+ */
+int scols_table_is_arena(const struct libscols_table *tb)
+{
+	return tb->use_arena;
+}
+
+/**
+ * scols_table_is_streaming:
+ * @tb: a pointer to a struct libscols_table instance
+ *
+ * Returns: 1 if streaming mode is enabled.
+ *
+ * Since: 2.37
+ */
+int scols_table_is_streaming(const struct libscols_table *tb)
+{
+	return tb->streaming;
+}
+
+/**
+ * scols_table_set_streaming_sample:
+ * @tb: table
+ * @nlines: number of lines
+ *
+ * Sets number of lines used to calculate columns width in streaming mode
+ * (see scols_table_enable_streaming()). The lines are kept in memory until
+ * the sample is complete. Zero means that the width is calculated from
+ * column headers, width hints and the first line only. The default is 64
+ * lines.
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_set_streaming_sample(struct libscols_table *tb, size_t nlines)
+{
+	if (!tb || tb->stream_started)
+		return -EINVAL;
+	DBG(TAB, ul_debugobj(tb, "streaming sample: %zu", nlines));
+	tb->stream_sample = nlines;
+	return 0;
+}
+
+/**
+ * scols_table_set_print_threads:
+ * @tb: table
+ * @nthreads: number of threads or zero
+ *
+ * Sets the maximal number of threads used to print large tables in RAW,
+ * EXPORT and JSON output formats. The lines are rendered to memory in chunks
+ * and the chunks are written to the output in the original order, so the
+ * output is the same as for the single-threaded print. The human-readable
+ * output, trees and tables with groups are always printed by one thread.
+ *
+ * Zero means the number of online CPUs. The default is 1 (no threads).
+ *
+ * Returns: 0 on success, negative number in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_table_set_print_threads(struct libscols_table *tb, size_t nthreads)
+{
+	if (!tb)
+		return -EINVAL;
+	if (!nthreads) {
+		long n = sysconf(_SC_NPROCESSORS_ONLN);
+
+		nthreads = n > 0 ? (size_t) n : 1;
+	}
+	DBG(TAB, ul_debugobj(tb, "print threads: %zu", nthreads));
+	tb->nthreads = nthreads;
+	return 0;
+}
+
+/**
+ * scols_table_get_print_threads:
+ * @tb: table
+ *
+ * Returns: maximal number of threads used to print the table.
+ *
+ * Since: 2.37
+ */
+size_t scols_table_get_print_threads(const struct libscols_table *tb)
+{
+	return tb->nthreads;
+}
+
 /**
  * scols_table_colors_wanted:
  * @tb: table
@@ -1449,46 +1640,242 @@ const char *scols_table_get_line_separator(const struct libscols_table *tb)
 {
 	return tb->linesep;
 }
-/* for lines in the struct libscols_line->ln_lines list */
-static int cells_cmp_wrapper_lines(struct list_head *a, struct list_head *b, void *data)
+/*
+ * Sorting
+ *
+ * The lines are sorted by an array of precomputed keys (decorate-sort-
+ * undecorate). The cells of the first sort column are resolved only once.
+ * For scols_cmpstr_cells() and scols_cmpu64_cells() the key also contains
+ * the value (or the first bytes of the string behind the common prefix), so
+ * most comparisons don't touch the lines and cells at all. The other sort
+ * columns are used only if the first column cells are equal.
+ */
+enum {
+	SORT_KEY_CELL = 0,	/* use column cmpfunc() */
+	SORT_KEY_STR,		/* scols_cmpstr_cells() */
+	SORT_KEY_U64		/* scols_cmpu64_cells() */
+};
+
+struct sort_spec {
+	struct libscols_column	**cls;		/* sort columns */
+	size_t			ncls;
+	int			type;		/* SORT_KEY_* of the first column */
+	size_t			skip;		/* common prefix of all strings */
+};
+
+struct sort_key {
+	uint64_t		val;		/* u64 or first bytes of the string */
+	const void		*data;		/* string, u64 pointer or cell */
+	struct libscols_line	*ln;
+};
+
+/* compare lines by sort columns starting at @from */
+static int cmp_lines(struct sort_spec *spec,
+		     struct libscols_line *a,
+		     struct libscols_line *b,
+		     size_t from)
+{
+	size_t i;
+	int rc = 0;
+
+	for (i = from; rc == 0 && i < spec->ncls; i++) {
+		struct libscols_column *cl = spec->cls[i];
+
+		rc = cl->cmpfunc(scols_line_get_cell(a, cl->seqnum),
+				 scols_line_get_cell(b, cl->seqnum),
+				 cl->cmpfunc_data);
+	}
+	return rc;
+}
+
+static int cmp_keys(struct sort_spec *spec,
+		    const struct sort_key *a,
+		    const struct sort_key *b)
 {
-	struct libscols_column *cl = (struct libscols_column *) data;
-	struct libscols_line *ra, *rb;
-	struct libscols_cell *ca, *cb;
+	int rc;
+
+	if (spec->type == SORT_KEY_CELL) {
+		struct libscols_column *cl = spec->cls[0];
+
+		rc = cl->cmpfunc((struct libscols_cell *) a->data,
+				 (struct libscols_cell *) b->data,
+				 cl->cmpfunc_data);
+
+	/* NULL first, the same as scols_cmp{str,u64}_cells() */
+	} else if (!a->data || !b->data)
+		rc = a->data ? 1 : b->data ? -1 : 0;
+	else if (a->val != b->val)
+		rc = a->val < b->val ? -1 : 1;
+	else if (spec->type == SORT_KEY_STR)
+		rc = strcmp((const char *) a->data + spec->skip,
+			    (const char *) b->data + spec->skip);
+	else
+		rc = 0;
 
-	assert(a);
-	assert(b);
-	assert(cl);
+	if (rc == 0 && spec->ncls > 1)
+		rc = cmp_lines(spec, a->ln, b->ln, 1);
+	return rc;
+}
 
-	ra = list_entry(a, struct libscols_line, ln_lines);
-	rb = list_entry(b, struct libscols_line, ln_lines);
-	ca = scols_line_get_cell(ra, cl->seqnum);
-	cb = scols_line_get_cell(rb, cl->seqnum);
+static uint64_t str_prefix(const char *str)
+{
+	uint64_t x = 0;
+	size_t i;
 
-	return cl->cmpfunc(ca, cb, cl->cmpfunc_data);
+	for (i = 0; i < sizeof(x) && str[i]; i++)
+		x |= (uint64_t) (unsigned char) str[i] << (8 * (sizeof(x) - 1 - i));
+	return x;
 }
 
-/* for lines in the struct libscols_line->ln_children list */
-static int cells_cmp_wrapper_children(struct list_head *a, struct list_head *b, void *data)
+#define SORT_RUN	16
+
+/*
+ * Stable merge sort of the keys. The short runs are sorted by insertion sort,
+ * then merged bottom-up. Returns @v or @tmp, depending where the result is.
+ */
+static struct sort_key *sort_keys(struct sort_spec *spec,
+				  struct sort_key *v,
+				  struct sort_key *tmp,
+				  size_t n)
 {
-	struct libscols_column *cl = (struct libscols_column *) data;
-	struct libscols_line *ra, *rb;
-	struct libscols_cell *ca, *cb;
+	size_t i, k, width;
 
-	assert(a);
-	assert(b);
-	assert(cl);
+	for (i = 0; i < n; i += SORT_RUN) {
+		size_t end = min(i + SORT_RUN, n);
 
-	ra = list_entry(a, struct libscols_line, ln_children);
-	rb = list_entry(b, struct libscols_line, ln_children);
-	ca = scols_line_get_cell(ra, cl->seqnum);
-	cb = scols_line_get_cell(rb, cl->seqnum);
+		for (k = i + 1; k < end; k++) {
+			struct sort_key x = v[k];
+			size_t j = k;
 
-	return cl->cmpfunc(ca, cb, cl->cmpfunc_data);
+			while (j > i && cmp_keys(spec, &x, &v[j - 1]) < 0) {
+				v[j] = v[j - 1];
+				j--;
+			}
+			v[j] = x;
+		}
+	}
+
+	for (width = SORT_RUN; width < n; width *= 2) {
+		struct sort_key *x;
+
+		for (i = 0; i < n; i += 2 * width) {
+			size_t mid = min(i + width, n), hi = min(i + 2 * width, n);
+			size_t l = i, r = mid;
+
+			if (mid == hi || cmp_keys(spec, &v[mid], &v[mid - 1]) >= 0) {
+				/* already ordered */
+				memcpy(tmp + i, v + i, (hi - i) * sizeof(*v));
+				continue;
+			}
+			k = i;
+			while (l < mid && r < hi)
+				tmp[k++] = cmp_keys(spec, &v[r], &v[l]) < 0 ? v[r++] : v[l++];
+			if (l < mid)
+				memcpy(tmp + k, v + l, (mid - l) * sizeof(*v));
+			else if (r < hi)
+				memcpy(tmp + k, v + r, (hi - r) * sizeof(*v));
+		}
+		x = v, v = tmp, tmp = x;
+	}
+	return v;
 }
 
+#define sort_entry(_p, _children) ((_children) ? \
+		list_entry(_p, struct libscols_line, ln_children) : \
+		list_entry(_p, struct libscols_line, ln_lines))
 
-static int sort_line_children(struct libscols_line *ln, struct libscols_column *cl)
+/* fallback for list_sort() if there is no memory for the keys */
+static int cells_cmp_wrapper_lines(struct list_head *a, struct list_head *b, void *data)
+{
+	return cmp_lines((struct sort_spec *) data,
+			 list_entry(a, struct libscols_line, ln_lines),
+			 list_entry(b, struct libscols_line, ln_lines), 0);
+}
+
+static int cells_cmp_wrapper_children(struct list_head *a, struct list_head *b, void *data)
+{
+	return cmp_lines((struct sort_spec *) data,
+			 list_entry(a, struct libscols_line, ln_children),
+			 list_entry(b, struct libscols_line, ln_children), 0);
+}
+
+/* sort list of lines, @children means ln_children rather than ln_lines list */
+static void sort_lines(struct sort_spec *spec, struct list_head *head, int children)
+{
+	struct libscols_column *cl = spec->cls[0];
+	struct sort_key *keys, *res;
+	const char *first = NULL;
+	struct list_head *p;
+	size_t n = 0, i;
+
+	list_for_each(p, head)
+		n++;
+	if (n < 2)
+		return;
+
+	keys = malloc(2 * n * sizeof(*keys));
+	if (!keys) {
+		DBG(TAB, ul_debug("sort: no memory for keys, fallback to list_sort()"));
+		list_sort(head, children ? cells_cmp_wrapper_children :
+					   cells_cmp_wrapper_lines, spec);
+		return;
+	}
+
+	i = 0;
+	spec->skip = 0;
+	list_for_each(p, head) {
+		struct sort_key *k = &keys[i++];
+		struct libscols_cell *ce;
+
+		k->ln = sort_entry(p, children);
+		ce = scols_line_get_cell(k->ln, cl->seqnum);
+
+		switch (spec->type) {
+		case SORT_KEY_CELL:
+			k->data = ce;
+			break;
+		case SORT_KEY_U64:
+			k->data = ce ? scols_cell_get_userdata(ce) : NULL;
+			k->val = k->data ? *((const uint64_t *) k->data) : 0;
+			break;
+		case SORT_KEY_STR:
+			k->data = ce ? scols_cell_get_data(ce) : NULL;
+			if (!k->data)
+				break;
+			if (!first) {
+				first = k->data;
+				spec->skip = strlen(first);
+			} else {
+				const char *str = k->data;
+				size_t x = 0;
+
+				while (x < spec->skip && str[x] == first[x])
+					x++;
+				spec->skip = x;
+			}
+			break;
+		}
+	}
+
+	/* use string bytes behind the common prefix as the key */
+	if (spec->type == SORT_KEY_STR) {
+		for (i = 0; i < n; i++) {
+			if (keys[i].data)
+				keys[i].val = str_prefix((const char *) keys[i].data + spec->skip);
+		}
+	}
+
+	res = sort_keys(spec, keys, keys + n, n);
+
+	/* undecorate -- relink the lines in the new order */
+	INIT_LIST_HEAD(head);
+	for (i = 0; i < n; i++)
+		list_add_tail(children ? &res[i].ln->ln_children :
+					 &res[i].ln->ln_lines, head);
+	free(keys);
+}
+
+static void sort_line_children(struct sort_spec *spec, struct libscols_line *ln)
 {
 	struct list_head *p;
 
@@ -1496,23 +1883,21 @@ static int sort_line_children(struct libscols_line *ln, struct libscols_column *
 		list_for_each(p, &ln->ln_branch) {
 			struct libscols_line *chld =
 					list_entry(p, struct libscols_line, ln_children);
-			sort_line_children(chld, cl);
+			sort_line_children(spec, chld);
 		}
 
-		list_sort(&ln->ln_branch, cells_cmp_wrapper_children, cl);
+		sort_lines(spec, &ln->ln_branch, 1);
 	}
 
 	if (is_first_group_member(ln)) {
 		list_for_each(p, &ln->group->gr_children) {
 			struct libscols_line *chld =
 					list_entry(p, struct libscols_line, ln_children);
-			sort_line_children(chld, cl);
+			sort_line_children(spec, chld);
 		}
 
-		list_sort(&ln->group->gr_children, cells_cmp_wrapper_children, cl);
+		sort_lines(spec, &ln->group->gr_children, 1);
 	}
-
-	return 0;
 }
 
 /**
@@ -1527,11 +1912,45 @@ static int sort_line_children(struct libscols_line *ln, struct libscols_column *
  */
 int scols_sort_table(struct libscols_table *tb, struct libscols_column *cl)
 {
-	if (!tb || !cl || !cl->cmpfunc)
+	return scols_sort_table_by_columns(tb, &cl, 1);
+}
+
+/**
+ * scols_sort_table_by_columns:
+ * @tb: table
+ * @cls: array of columns
+ * @ncls: number of columns in the array
+ *
+ * Orders the table by the columns. The lines with equal cells in the first
+ * column are ordered by the second column, etc. The sort is stable, the
+ * lines with equal cells in all the columns keep the original order. All the
+ * columns have to define compare function, see scols_column_set_cmpfunc(). If
+ * the tree output is enabled then children in the tree are recursively
+ * sorted too.
+ *
+ * Returns: 0, a negative value in case of an error.
+ *
+ * Since: 2.37
+ */
+int scols_sort_table_by_columns(struct libscols_table *tb,
+				struct libscols_column **cls, size_t ncls)
+{
+	struct sort_spec spec = { .cls = cls, .ncls = ncls };
+	size_t i;
+
+	if (!tb || !cls || !ncls)
 		return -EINVAL;
+	for (i = 0; i < ncls; i++) {
+		if (!cls[i] || !cls[i]->cmpfunc)
+			return -EINVAL;
+	}
+	if (cls[0]->cmpfunc == scols_cmpstr_cells)
+		spec.type = SORT_KEY_STR;
+	else if (cls[0]->cmpfunc == scols_cmpu64_cells)
+		spec.type = SORT_KEY_U64;
 
-	DBG(TAB, ul_debugobj(tb, "sorting table"));
-	list_sort(&tb->tb_lines, cells_cmp_wrapper_lines, cl);
+	DBG(TAB, ul_debugobj(tb, "sorting table by %zu column(s)", ncls));
+	sort_lines(&spec, &tb->tb_lines, 0);
 
 	if (scols_table_is_tree(tb)) {
 		struct libscols_line *ln;
@@ -1539,7 +1958,7 @@ int scols_sort_table(struct libscols_table *tb, struct libscols_column *cl)
 
 		scols_reset_iter(&itr, SCOLS_ITER_FORWARD);
 		while (scols_table_next_line(tb, &itr, &ln) == 0)
-			sort_line_children(ln, cl);
+			sort_line_children(&spec, ln);
 	}
 
 	return 0;
@@ -1248,6 +1248,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(_("     --output-all       output all available columns\n"), out);
 	fputs(_(" -P, --pairs            use key=\"value\" output format\n"), out);
 	fputs(_("     --pseudo           print only pseudo-filesystems\n"), out);
+	fputs(_(" -Q, --filter <expr>    print only lines matching the expression\n"), out);
 	fputs(_(" -R, --submounts        print all submounts for the matching filesystems\n"), out);
 	fputs(_(" -r, --raw              use raw output format\n"), out);
 	fputs(_("     --real             print only real filesystems\n"), out);
@@ -1289,6 +1290,7 @@ int main(int argc, char *argv[])
 	char *outarg = NULL;
 	size_t i;
 	int force_tree = 0, istree = 0;
+	const char *filter = NULL;
 
 	struct libscols_table *table = NULL;
 
@@ -1325,6 +1327,7 @@ int main(int argc, char *argv[])
 		{ "output-all",	    no_argument,       NULL, FINDMNT_OPT_OUTPUT_ALL },
 		{ "poll",	    optional_argument, NULL, 'p'		 },
 		{ "pairs",	    no_argument,       NULL, 'P'		 },
+		{ "filter",	    required_argument, NULL, 'Q'		 },
 		{ "raw",	    no_argument,       NULL, 'r'		 },
 		{ "types",	    required_argument, NULL, 't'		 },
 		{ "nocanonicalize", no_argument,       NULL, 'C'		 },
@@ -1369,7 +1372,7 @@ int main(int argc, char *argv[])
 	flags |= FL_TREE;
 
 	while ((c = getopt_long(argc, argv,
-				"AabCcDd:ehiJfF:o:O:p::PklmM:nN:rst:uvRS:T:Uw:Vx",
+				"AabCcDd:ehiJfF:o:O:p::PQ:klmM:nN:rst:uvRS:T:Uw:Vx",
 				longopts, NULL)) != -1) {
 
 		err_exclusive_options(c, longopts, excl, excl_st);
@@ -1449,6 +1452,9 @@ int main(int argc, char *argv[])
 			flags |= FL_EXPORT;
 			flags &= ~FL_TREE;
 			break;
+		case 'Q':
+			filter = optarg;
+			break;
 		case 'm':		/* mtab */
 			tabtype = TABTYPE_MTAB;
 			flags &= ~FL_TREE;
@@ -1648,6 +1654,10 @@ int main(int argc, char *argv[])
 	scols_table_enable_ascii(table,      !!(flags & FL_ASCII));
 	scols_table_enable_noheadings(table, !!(flags & FL_NOHEADINGS));
 
+	/* --poll removes lines after each event, the arena would grow */
+	if (!(flags & FL_POLL))
+		scols_table_enable_arena(table, 1);
+
 	if (flags & FL_JSON)
 		scols_table_set_name(table, "filesystems");
 
@@ -1692,6 +1702,21 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (filter) {
+		struct libscols_filter *fltr = scols_new_filter(filter);
+
+		if (!fltr)
+			err(EXIT_FAILURE, _("failed to allocate filter"));
+		if (scols_filter_get_errmsg(fltr)
+		    || scols_table_set_filter(table, fltr) != 0) {
+			const char *msg = scols_filter_get_errmsg(fltr);
+
+			errx(EXIT_FAILURE, _("failed to use filter: %s"),
+					msg ? msg : _("invalid expression"));
+		}
+		scols_unref_filter(fltr);
+	}
+
 	/*
 	 * Fill in data to the output table
 	 */
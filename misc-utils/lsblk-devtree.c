@@ -57,6 +57,22 @@ void lsblk_ref_device(struct lsblk_device *dev)
 		dev->refcount++;
 }
 
+/* deallocates prefetched column data which has not been used yet */
+void lsblk_device_free_coldata(struct lsblk_device *dev)
+{
+	size_t i;
+
+	if (!dev || !dev->coldata)
+		return;
+
+	for (i = 0; i < dev->ncoldata; i++)
+		free(dev->coldata[i].data);
+
+	free(dev->coldata);
+	dev->coldata = NULL;
+	dev->ncoldata = 0;
+}
+
 /* removes dependence from child as well as from parent */
 static int remove_dependence(struct lsblk_devdep *dep)
 {
@@ -106,6 +122,7 @@ void lsblk_unref_device(struct lsblk_device *dev)
 
 		device_remove_dependences(dev);
 		lsblk_device_free_properties(dev->properties);
+		lsblk_device_free_coldata(dev);
 		lsblk_device_free_filesystems(dev);
 
 		lsblk_unref_device(dev->wholedisk);
@@ -14,7 +14,13 @@
 #include "lsblk.h"
 
 #ifdef HAVE_LIBUDEV
+/* libudev context must not be shared between threads, so every thread which
+ * reads properties has its own handler, see lsblk_properties_deinit() */
+# ifdef HAVE_TLS
+static __thread struct udev *udev;
+# else
 static struct udev *udev;
+# endif
 #endif
 
 void lsblk_device_free_properties(struct lsblk_devprop *p)
@@ -58,7 +64,7 @@ static struct lsblk_devprop *get_properties_by_udev(struct lsblk_device *ld)
 		return ld->properties;
 
 	if (!udev)
-		udev = udev_new();	/* global handler */
+		udev = udev_new();	/* per-thread handler */
 	if (!udev)
 		goto done;
 
@@ -312,10 +318,12 @@ struct lsblk_devprop *lsblk_device_get_properties(struct lsblk_device *dev)
 	return p;
 }
 
+/* deallocates the handler used by the current thread */
 void lsblk_properties_deinit(void)
 {
 #ifdef HAVE_LIBUDEV
 	udev_unref(udev);
+	udev = NULL;
 #endif
 }
 
@@ -39,6 +39,11 @@
 
 #include <blkid.h>
 
+#if defined(HAVE_PTHREAD) && defined(HAVE_TLS)
+# include <pthread.h>
+# define USE_PARALLEL_SCAN 1
+#endif
+
 #include "c.h"
 #include "pathnames.h"
 #include "blkdev.h"
@@ -52,6 +57,7 @@
 #include "fileutils.h"
 #include "loopdev.h"
 #include "buffer.h"
+#include "parallel.h"
 
 #include "lsblk.h"
 
@@ -572,7 +578,7 @@ static char *mk_dm_name(const char *name)
 }
 
 /* stores data to scols cell userdata (invisible and independent on output)
- * to make the original values accessible for sort functions
+ * to make the original values accessible for scols_cmpu64_cells()
  */
 static void set_sortdata_u64(struct libscols_line *ln, int col, uint64_t x)
 {
@@ -1142,8 +1148,16 @@ static void device_to_scols(
 	for (i = 0; i < ncolumns; i++) {
 		char *data;
 		int id = get_column_id(i);
-
-		if (lsblk->sort_id != id)
+		struct lsblk_coldata *cd = i < dev->ncoldata ? &dev->coldata[i] : NULL;
+
+		if (cd && cd->ready) {
+			/* already read by devtree_prefetch_data() */
+			data = cd->data;
+			cd->data = NULL;
+			cd->ready = 0;
+			if (lsblk->sort_id == id && data && cd->sortdata != (uint64_t) -1)
+				set_sortdata_u64(ln, i, cd->sortdata);
+		} else if (lsblk->sort_id != id)
 			data = device_get_data(dev, parent, id, NULL);
 		else {
 			uint64_t sortdata = (uint64_t) -1;
@@ -1158,6 +1172,7 @@ static void device_to_scols(
 	}
 
 	dev->scols_line = ln;
+	lsblk_device_free_coldata(dev);
 
 	if (dev->npartitions == 0)
 		/* For partitions we often read from parental whole-disk sysfs,
@@ -1203,6 +1218,119 @@ static int ignore_empty(struct lsblk_device *dev)
 	return 0;
 }
 
+/*
+ * Reads all sysfs attributes used by initialize_device() and by the output
+ * columns at once, device_get_data() then does not access sysfs for them.
+ */
+static void device_prefetch_sysfs(struct lsblk_device *dev)
+{
+	const char *attrs[64];
+	size_t i, n = 0;
+	int dm = is_dm(dev->name), part = device_is_partition(dev);
+
+	attrs[n++] = "size";
+	if (dm)
+		attrs[n++] = "dm/name";
+
+	for (i = 0; i < ncolumns && n + 2 <= ARRAY_SIZE(attrs); i++) {
+		switch (get_column_id(i)) {
+		case COL_RA:
+			attrs[n++] = "queue/read_ahead_kb";
+			break;
+		case COL_RO:
+			attrs[n++] = "ro";
+			break;
+		case COL_RM:
+			attrs[n++] = "removable";
+			break;
+		case COL_ROTA:
+			attrs[n++] = "queue/rotational";
+			break;
+		case COL_RAND:
+			attrs[n++] = "queue/add_random";
+			break;
+		case COL_MODEL:
+			if (!part)
+				attrs[n++] = "device/model";
+			break;
+		case COL_SERIAL:
+			if (!part)
+				attrs[n++] = "device/serial";
+			break;
+		case COL_REV:
+			if (!part)
+				attrs[n++] = "device/rev";
+			break;
+		case COL_VENDOR:
+			if (!part)
+				attrs[n++] = "device/vendor";
+			break;
+		case COL_STATE:
+			if (dm)
+				attrs[n++] = "dm/suspended";
+			else if (!part)
+				attrs[n++] = "device/state";
+			break;
+		case COL_ALIOFF:
+			attrs[n++] = "alignment_offset";
+			break;
+		case COL_MINIO:
+			attrs[n++] = "queue/minimum_io_size";
+			break;
+		case COL_OPTIO:
+			attrs[n++] = "queue/optimal_io_size";
+			break;
+		case COL_PHYSEC:
+			attrs[n++] = "queue/physical_block_size";
+			break;
+		case COL_LOGSEC:
+			attrs[n++] = "queue/logical_block_size";
+			break;
+		case COL_SCHED:
+			attrs[n++] = "queue/scheduler";
+			break;
+		case COL_RQ_SIZE:
+			attrs[n++] = "queue/nr_requests";
+			break;
+		case COL_TYPE:
+			if (dm)
+				attrs[n++] = "dm/uuid";
+			else if (!strncmp(dev->name, "md", 2))
+				attrs[n++] = "md/level";
+			else if (!part && strncmp(dev->name, "loop", 4) != 0)
+				attrs[n++] = "device/type";
+			break;
+		case COL_DALIGN:
+			attrs[n++] = "queue/discard_granularity";
+			attrs[n++] = "discard_alignment";
+			break;
+		case COL_DGRAN:
+			attrs[n++] = "queue/discard_granularity";
+			break;
+		case COL_DMAX:
+			attrs[n++] = "queue/discard_max_bytes";
+			break;
+		case COL_DZERO:
+			attrs[n++] = "queue/discard_granularity";
+			attrs[n++] = "queue/discard_zeroes_data";
+			break;
+		case COL_WSAME:
+			attrs[n++] = "queue/write_same_max_bytes";
+			break;
+		case COL_ZONED:
+			attrs[n++] = "queue/zoned";
+			break;
+		case COL_DAX:
+			attrs[n++] = "queue/dax";
+			break;
+		default:
+			break;
+		}
+	}
+
+	ul_path_prefetch(dev->sysfs, attrs, n);
+}
+
 /*
  * Reads very basic information about the device from sysfs into the device struct
  */
@@ -1250,6 +1378,8 @@ static int initialize_device(struct lsblk_device *dev,
 	dev->min = minor(devno);
 	dev->size = 0;
 
+	device_prefetch_sysfs(dev);
+
 	if (ul_path_read_u64(dev->sysfs, &dev->size, "size") == 0)	/* in sectors */
 		dev->size <<= 9;					/* in bytes */
 
@@ -1283,13 +1413,75 @@ static int initialize_device(struct lsblk_device *dev,
 	return 0;
 }
 
+/*
+ * Devices from /sys/block and their partitions initialized in advance by
+ * prefetch_devices(). The device tree is always assembled in one thread,
+ * devtree_get_device_or_new() only uses the already initialized devices from
+ * the pool rather than read sysfs again.
+ */
+struct lsblk_poolent {
+	char			*name;		/* sysfs name */
+	struct lsblk_device	*dev;		/* initialized device or NULL */
+	struct lsblk_device	*disk;		/* whole-disk for partitions */
+
+	unsigned int		failed : 1;	/* initialize_device() failed */
+};
+
+static struct lsblk_poolent *devpool;
+static size_t ndevpool;
+
+static int cmp_poolent(const void *a, const void *b)
+{
+	return strcmp(((const struct lsblk_poolent *) a)->name,
+		      ((const struct lsblk_poolent *) b)->name);
+}
+
+static struct lsblk_poolent *devpool_get_entry(const char *name)
+{
+	struct lsblk_poolent key = { .name = (char *) name };
+
+	if (!ndevpool)
+		return NULL;
+	return bsearch(&key, devpool, ndevpool, sizeof(key), cmp_poolent);
+}
+
+static void free_devpool(void)
+{
+	size_t i;
+
+	for (i = 0; i < ndevpool; i++) {
+		struct lsblk_poolent *pe = &devpool[i];
+
+		lsblk_unref_device(pe->dev);
+		lsblk_unref_device(pe->disk);
+		free(pe->name);
+	}
+	free(devpool);
+	devpool = NULL;
+	ndevpool = 0;
+}
+
 static struct lsblk_device *devtree_get_device_or_new(struct lsblk_devtree *tr,
 					       struct lsblk_device *disk,
 					       const char *name)
 {
 	struct lsblk_device *dev = lsblk_devtree_get_device(tr, name);
+	struct lsblk_poolent *pe;
+
+	if (!dev && (pe = devpool_get_entry(name)) && pe->disk == disk
+	    && (pe->dev || pe->failed)) {
+		if (pe->failed) {
+			DBG(DEV, ul_debug("%s: ignore (prefetched)", name));
+			return NULL;
+		}
+		DBG(DEV, ul_debugobj(pe->dev, "%s: use prefetched", name));
+		dev = pe->dev;
+		pe->dev = NULL;
 
-	if (!dev) {
+		lsblk_devtree_add_device(tr, dev);
+		lsblk_unref_device(dev);		/* keep it referenced by devtree only */
+
+	} else if (!dev) {
 		dev = lsblk_new_device();
 		if (!dev)
 			err(EXIT_FAILURE, _("failed to allocate device"));
@@ -1611,6 +1803,361 @@ static int process_one_device(struct lsblk_devtree *tr, char *devname)
 	return __process_one_device(tr, devname, 0);
 }
 
+/*
+ * Worker threads to read sysfs (and udev or blkid) for more devices at once.
+ * It's used only for large number of devices, the threads overhead is
+ * larger than the gain for usual systems.
+ */
+#ifdef USE_PARALLEL_SCAN
+# define LSBLK_MAXTHREADS	16
+# define LSBLK_PARALLEL_MIN	64	/* minimal number of devices */
+
+struct lsblk_workq {
+	pthread_mutex_t	lock;
+	void		**items;
+	size_t		nitems;
+	size_t		next;		/* the first not-processed item */
+	void		(*fn)(void *);
+};
+
+static size_t get_nthreads(size_t nitems)
+{
+	return ul_get_nthreads("LSBLK_THREADS", nitems,
+			       LSBLK_PARALLEL_MIN, LSBLK_MAXTHREADS);
+}
+
+static void workq_process(struct lsblk_workq *wq)
+{
+	do {
+		void *item = NULL;
+
+		pthread_mutex_lock(&wq->lock);
+		if (wq->next < wq->nitems)
+			item = wq->items[wq->next++];
+		pthread_mutex_unlock(&wq->lock);
+
+		if (!item)
+			break;
+		wq->fn(item);
+	} while (1);
+}
+
+static void *workq_thread(void *data)
+{
+	workq_process((struct lsblk_workq *) data);
+
+	lsblk_properties_deinit();	/* per-thread udev handler */
+	return NULL;
+}
+
+/* Calls @fn for all @items; the current thread works as one of the workers */
+static void workq_run(void **items, size_t nitems, void (*fn)(void *))
+{
+	struct lsblk_workq wq = {
+		.items = items,
+		.nitems = nitems,
+		.fn = fn
+	};
+	pthread_t threads[LSBLK_MAXTHREADS];
+	size_t i, n = 0, nthreads = get_nthreads(nitems);
+
+	/* initialize debug masks before the threads are created */
+	ul_path_init_debug();
+	ul_sysfs_init_debug();
+	blkid_init_debug(0);
+
+	pthread_mutex_init(&wq.lock, NULL);
+
+	for (i = 1; i < nthreads; i++) {
+		if (pthread_create(&threads[n], NULL, workq_thread, &wq) != 0)
+			break;
+		n++;
+	}
+	DBG(DEV, ul_debug("processing %zu items by %zu threads", nitems, n + 1));
+
+	workq_process(&wq);
+
+	for (i = 0; i < n; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&wq.lock);
+}
+#else
+static inline size_t get_nthreads(size_t nitems __attribute__((__unused__)))
+{
+	return 1;
+}
+
+static void workq_run(void **items, size_t nitems, void (*fn)(void *))
+{
+	size_t i;
+
+	for (i = 0; i < nitems; i++)
+		fn(items[i]);
+}
+#endif /* USE_PARALLEL_SCAN */
+
+/* One /sys/block entry and its partitions */
+struct lsblk_devinit {
+	struct lsblk_poolent	ent;
+	struct lsblk_poolent	*parts;
+	size_t			nparts;
+};
+
+static struct lsblk_device *devpool_init_device(struct lsblk_poolent *pe,
+						struct lsblk_device *disk)
+{
+	struct lsblk_device *dev = lsblk_new_device();
+
+	if (!dev)
+		err(EXIT_FAILURE, _("failed to allocate device"));
+
+	if (initialize_device(dev, disk, pe->name) != 0) {
+		lsblk_unref_device(dev);
+		dev = NULL;
+		pe->failed = 1;
+	}
+	pe->dev = dev;
+	pe->disk = disk;
+	lsblk_ref_device(disk);
+
+	return dev;
+}
+
+/* Called in worker thread; the partitions share sysfs handler with the
+ * whole-disk, so they are always initialized in the same thread */
+static void prefetch_device(void *data)
+{
+	struct lsblk_devinit *di = (struct lsblk_devinit *) data;
+	struct lsblk_device *disk;
+	struct dirent *d;
+	DIR *dir;
+
+	disk = devpool_init_device(&di->ent, NULL);
+	if (!disk || lsblk->nodeps || !disk->npartitions)
+		goto done;
+
+	dir = ul_path_opendir(disk->sysfs, NULL);
+	if (!dir)
+		goto done;
+
+	while ((d = xreaddir(dir))) {
+		struct lsblk_poolent *pe;
+		struct lsblk_device *part;
+
+		if (!(sysfs_blkdev_is_partition_dirent(dir, d, disk->name)))
+			continue;
+
+		di->parts = xrealloc(di->parts, (di->nparts + 1) * sizeof(*di->parts));
+		pe = &di->parts[di->nparts++];
+		memset(pe, 0, sizeof(*pe));
+		pe->name = xstrdup(d->d_name);
+
+		part = devpool_init_device(pe, disk);
+		if (part)
+			ul_path_close_dirfd(part->sysfs);
+	}
+	closedir(dir);
+done:
+	/* Let's be careful with number of open files */
+	if (disk)
+		ul_path_close_dirfd(disk->sysfs);
+}
+
+/*
+ * Initializes all devices from /sys/block (and partitions) in worker threads
+ * and keeps them in the pool for devtree_get_device_or_new().
+ */
+static void prefetch_devices(void)
+{
+	struct lsblk_devinit *dis = NULL;
+	struct path_cxt *pc;
+	struct dirent *d;
+	DIR *dir;
+	void **items;
+	size_t i, j, n = 0;
+
+	pc = ul_new_path(_PATH_SYS_BLOCK);
+	if (!pc)
+		err(EXIT_FAILURE, _("failed to allocate /sys handler"));
+
+	ul_path_set_prefix(pc, lsblk->sysroot);
+	dir = ul_path_opendir(pc, NULL);
+	if (!dir)
+		goto done;
+
+	while ((d = xreaddir(dir))) {
+		dis = xrealloc(dis, (n + 1) * sizeof(*dis));
+		memset(&dis[n], 0, sizeof(*dis));
+		dis[n++].ent.name = xstrdup(d->d_name);
+	}
+	closedir(dir);
+
+	if (get_nthreads(n) <= 1)
+		goto done;
+
+	DBG(DEV, ul_debug("prefetch %zu devices", n));
+
+	items = xmalloc(n * sizeof(void *));
+	for (i = 0; i < n; i++)
+		items[i] = &dis[i];
+
+	workq_run(items, n, prefetch_device);
+	free(items);
+
+	/* create one sorted array from all devices and partitions */
+	ndevpool = n;
+	for (i = 0; i < n; i++)
+		ndevpool += dis[i].nparts;
+
+	devpool = xcalloc(ndevpool, sizeof(*devpool));
+	for (i = 0, j = 0; i < n; i++) {
+		devpool[j++] = dis[i].ent;
+		if (dis[i].nparts)
+			memcpy(&devpool[j], dis[i].parts,
+			       dis[i].nparts * sizeof(*devpool));
+		j += dis[i].nparts;
+		free(dis[i].parts);
+	}
+	qsort(devpool, ndevpool, sizeof(*devpool), cmp_poolent);
+	n = 0;
+done:
+	for (i = 0; i < n; i++)
+		free(dis[i].ent.name);
+	free(dis);
+	ul_unref_path(pc);
+}
+
+/* Returns false for columns where the data depend on the position in the
+ * tree or on not thread-safe libraries (libmount, getpwuid(), ...) */
+static int is_prefetch_column(int id)
+{
+	switch (id) {
+	case COL_PKNAME:
+	case COL_OWNER:
+	case COL_GROUP:
+	case COL_TARGET:
+	case COL_TARGETS:
+	case COL_FSROOTS:
+	case COL_FSSIZE:
+	case COL_FSAVAIL:
+	case COL_FSUSED:
+	case COL_FSUSEPERC:
+		return 0;
+	default:
+		break;
+	}
+	return 1;
+}
+
+/* Devices which share the same whole-disk (and sysfs handler) */
+struct lsblk_devfamily {
+	struct lsblk_device	**devs;
+	size_t			ndevs;
+};
+
+static inline uintptr_t device_family_key(const struct lsblk_device *dev)
+{
+	return (uintptr_t) (dev->wholedisk ? dev->wholedisk : dev);
+}
+
+static int cmp_device_family(const void *a, const void *b)
+{
+	uintptr_t x = device_family_key(*(struct lsblk_device * const *) a),
+		  y = device_family_key(*(struct lsblk_device * const *) b);
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Called in worker thread */
+static void prefetch_family_data(void *data)
+{
+	struct lsblk_devfamily *fa = (struct lsblk_devfamily *) data;
+	size_t i, col;
+
+	for (i = 0; i < fa->ndevs; i++) {
+		struct lsblk_device *dev = fa->devs[i];
+
+		dev->coldata = xcalloc(ncolumns, sizeof(struct lsblk_coldata));
+		dev->ncoldata = ncolumns;
+
+		for (col = 0; col < ncolumns; col++) {
+			struct lsblk_coldata *cd = &dev->coldata[col];
+			int id = get_column_id(col);
+
+			if (!is_prefetch_column(id))
+				continue;
+
+			cd->sortdata = (uint64_t) -1;
+			cd->data = device_get_data(dev, dev->wholedisk, id,
+					lsblk->sort_id == id ? &cd->sortdata : NULL);
+			cd->ready = 1;
+		}
+	}
+
+	/* Let's be careful with number of open files */
+	for (i = 0; i < fa->ndevs; i++) {
+		struct lsblk_device *dev = fa->devs[i];
+
+		ul_path_close_dirfd(dev->sysfs);
+		if (dev->wholedisk)
+			ul_path_close_dirfd(dev->wholedisk->sysfs);
+	}
+}
+
+/*
+ * Reads data for output columns for all devices in worker threads. The
+ * data are later used (in the tree order) by device_to_scols().
+ */
+static void devtree_prefetch_data(struct lsblk_devtree *tr)
+{
+	struct lsblk_iter itr;
+	struct lsblk_device *dev = NULL, **devs;
+	struct lsblk_devfamily *fams;
+	void **items;
+	size_t i, n = 0, nfams = 0;
+
+	lsblk_reset_iter(&itr, LSBLK_ITER_FORWARD);
+	while (lsblk_devtree_next_device(tr, &itr, &dev) == 0)
+		n++;
+
+	if (get_nthreads(n) <= 1)
+		return;
+	for (i = 0; i < ncolumns; i++) {
+		if (is_prefetch_column(get_column_id(i)))
+			break;
+	}
+	if (i == ncolumns)
+		return;
+
+	DBG(DEV, ul_debug("prefetch data for %zu devices", n));
+
+	devs = xmalloc(n * sizeof(*devs));
+	lsblk_reset_iter(&itr, LSBLK_ITER_FORWARD);
+	for (i = 0; lsblk_devtree_next_device(tr, &itr, &dev) == 0; i++)
+		devs[i] = dev;
+
+	qsort(devs, n, sizeof(*devs), cmp_device_family);
+
+	fams = xcalloc(n, sizeof(*fams));
+	items = xmalloc(n * sizeof(void *));
+
+	for (i = 0; i < n; i++) {
+		if (i == 0 || cmp_device_family(&devs[i - 1], &devs[i]) != 0) {
+			fams[nfams].devs = &devs[i];
+			items[nfams] = &fams[nfams];
+			nfams++;
+		}
+		fams[nfams - 1].ndevs++;
+	}
+
+	workq_run(items, nfams, prefetch_family_data);
+
+	free(items);
+	free(fams);
+	free(devs);
+}
+
 /*
  * The /sys/block contains only root devices, and no partitions. It seems more
  * simple to scan /sys/dev/block where are all devices without exceptions to get
@@ -1778,25 +2325,6 @@ static void parse_includes(const char *str0)
 	}
 }
 
-/*
- * see set_sortdata_u64() and columns initialization in main()
- */
-static int cmp_u64_cells(struct libscols_cell *a,
-			 struct libscols_cell *b,
-			 __attribute__((__unused__)) void *data)
-{
-	uint64_t *adata = (uint64_t *) scols_cell_get_userdata(a),
-		 *bdata = (uint64_t *) scols_cell_get_userdata(b);
-
-	if (adata == NULL && bdata == NULL)
-		return 0;
-	if (adata == NULL)
-		return -1;
-	if (bdata == NULL)
-		return 1;
-	return *adata == *bdata ? 0 : *adata >= *bdata ? 1 : -1;
-}
-
 static void device_set_dedupkey(
 			struct lsblk_device *dev,
 			struct lsblk_device *parent,
@@ -1852,6 +2380,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(_(" -J, --json           use JSON output format\n"), out);
 	fputs(_(" -O, --output-all     output all columns\n"), out);
 	fputs(_(" -P, --pairs          use key=\"value\" output format\n"), out);
+	fputs(_(" -Q, --filter <expr>  print only lines matching the expression\n"), out);
 	fputs(_(" -S, --scsi           output info about SCSI devices\n"), out);
 	fputs(_(" -T, --tree[=<column>] use tree format output\n"), out);
 	fputs(_(" -a, --all            print all devices\n"), out);
@@ -1907,6 +2436,7 @@ int main(int argc, char *argv[])
 	size_t i;
 	unsigned int width = 0;
 	int force_tree = 0, has_tree_col = 0;
+	const char *filter = NULL;
 
 	enum {
 		OPT_SYSROOT = CHAR_MAX + 1
@@ -1936,6 +2466,7 @@ int main(int argc, char *argv[])
 		{ "topology",   no_argument,       NULL, 't' },
 		{ "paths",      no_argument,       NULL, 'p' },
 		{ "pairs",      no_argument,       NULL, 'P' },
+		{ "filter",     required_argument, NULL, 'Q' },
 		{ "scsi",       no_argument,       NULL, 'S' },
 		{ "sort",	required_argument, NULL, 'x' },
 		{ "sysroot",    required_argument, NULL, OPT_SYSROOT },
@@ -1969,7 +2500,7 @@ int main(int argc, char *argv[])
 	lsblk_init_debug();
 
 	while((c = getopt_long(argc, argv,
-			       "abdDzE:e:fhJlnMmo:OpPiI:rstVST::w:x:", longopts, NULL)) != -1) {
+			       "abdDzE:e:fhJlnMmo:OpPiI:Q:rstVST::w:x:", longopts, NULL)) != -1) {
 
 		err_exclusive_options(c, longopts, excl, excl_st);
 
@@ -2036,6 +2567,9 @@ int main(int argc, char *argv[])
 		case 's':
 			lsblk->inverse = 1;
 			break;
+		case 'Q':
+			filter = optarg;
+			break;
 		case 'f':
 			add_uniq_column(COL_NAME);
 			add_uniq_column(COL_FSTYPE);
@@ -2173,6 +2707,7 @@ int main(int argc, char *argv[])
 	scols_table_enable_ascii(lsblk->table, !!(lsblk->flags & LSBLK_ASCII));
 	scols_table_enable_json(lsblk->table, !!(lsblk->flags & LSBLK_JSON));
 	scols_table_enable_noheadings(lsblk->table, !!(lsblk->flags & LSBLK_NOHEADINGS));
+	scols_table_enable_arena(lsblk->table, 1);
 
 	if (lsblk->flags & LSBLK_JSON)
 		scols_table_set_name(lsblk->table, "blockdevices");
@@ -2216,9 +2751,9 @@ int main(int argc, char *argv[])
 		if (!lsblk->sort_col && lsblk->sort_id == id) {
 			lsblk->sort_col = cl;
 			scols_column_set_cmpfunc(cl,
-				ci->type == COLTYPE_NUM     ? cmp_u64_cells :
-				ci->type == COLTYPE_SIZE    ? cmp_u64_cells :
-			        ci->type == COLTYPE_SORTNUM ? cmp_u64_cells : scols_cmpstr_cells,
+				ci->type == COLTYPE_NUM     ? scols_cmpu64_cells :
+				ci->type == COLTYPE_SIZE    ? scols_cmpu64_cells :
+			        ci->type == COLTYPE_SORTNUM ? scols_cmpu64_cells : scols_cmpstr_cells,
 				NULL);
 		}
 		/* multi-line cells (now used for MOUNTPOINTS) */
@@ -2252,15 +2787,35 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (filter) {
+		struct libscols_filter *fltr = scols_new_filter(filter);
+
+		if (!fltr)
+			err(EXIT_FAILURE, _("failed to allocate filter"));
+		if (scols_filter_get_errmsg(fltr)
+		    || scols_table_set_filter(lsblk->table, fltr) != 0) {
+			const char *msg = scols_filter_get_errmsg(fltr);
+
+			errx(EXIT_FAILURE, _("failed to use filter: %s"),
+					msg ? msg : _("invalid expression"));
+		}
+		scols_unref_filter(fltr);
+	}
+
 	tr = lsblk_new_devtree();
 	if (!tr)
 		err(EXIT_FAILURE, _("failed to allocate device tree"));
 
 	if (optind == argc) {
-		int rc = lsblk->inverse ?
+		int rc;
+
+		prefetch_devices();
+
+		rc = lsblk->inverse ?
 			process_all_devices_inverse(tr) :
 			process_all_devices(tr);
 
+		free_devpool();
 		status = rc == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 	} else {
 		int cnt = 0, cnt_err = 0;
@@ -2281,19 +2836,20 @@ int main(int argc, char *argv[])
 		lsblk_devtree_deduplicate_devices(tr);
 	}
 
+	devtree_prefetch_data(tr);
 	devtree_to_scols(tr, lsblk->table);
 
-	if (lsblk->sort_col)
+	if (lsblk->sort_col) {
 		scols_sort_table(lsblk->table, lsblk->sort_col);
+		/* not needed for printing, and the filter removes lines */
+		unref_sortdata(lsblk->table);
+	}
 	if (lsblk->force_tree_order)
 		scols_sort_table_by_tree(lsblk->table);
 
 	scols_print_table(lsblk->table);
 
 leave:
-	if (lsblk->sort_col)
-		unref_sortdata(lsblk->table);
-
 	scols_unref_table(lsblk->table);
 
 	lsblk_mnt_deinit();
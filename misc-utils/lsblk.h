@@ -81,6 +81,13 @@ struct lsblk_devprop {
 	char *mode;		/* access mode in ls(1)-like notation */
 };
 
+/* Column data read in advance by worker threads, see devtree_prefetch_data() */
+struct lsblk_coldata {
+	char		*data;
+	uint64_t	sortdata;	/* (uint64_t) -1 if undefined */
+	unsigned int	ready : 1;	/* not used yet */
+};
+
 /* Device dependence
  *
  * Note that the same device may be slave/holder for more another devices. It
@@ -107,6 +114,8 @@ struct lsblk_device {
 	struct libscols_line	*scols_line;
 
 	struct lsblk_devprop	*properties;
+	struct lsblk_coldata	*coldata;	/* prefetched data for output columns */
+	size_t			ncoldata;	/* number of items in coldata[] */
 	struct stat	st;
 
 	char *name;		/* kernel name in /sys/block */
@@ -225,6 +234,7 @@ void lsblk_reset_iter(struct lsblk_iter *itr, int direction);
 struct lsblk_device *lsblk_new_device(void);
 void lsblk_ref_device(struct lsblk_device *dev);
 void lsblk_unref_device(struct lsblk_device *dev);
+void lsblk_device_free_coldata(struct lsblk_device *dev);
 int lsblk_device_new_dependence(struct lsblk_device *parent, struct lsblk_device *child);
 int lsblk_device_has_child(struct lsblk_device *dev, struct lsblk_device *child);
 int lsblk_device_next_child(struct lsblk_device *dev,
@@ -95,6 +95,7 @@ static int no_inaccessible;
 static int raw;
 static int json;
 static int bytes;
+static const char *filter;
 
 struct lock {
 	struct list_head locks;
@@ -462,6 +463,10 @@ static int show_locks(struct list_head *locks)
 	if (json)
 		scols_table_set_name(table, "locks");
 
+	/* columns width does not matter, don't keep all lines in memory */
+	if (raw || json)
+		scols_table_enable_streaming(table, 1);
+
 	for (i = 0; i < ncolumns; i++) {
 		struct libscols_column *cl;
 		struct colinfo *col = get_column_info(i);
@@ -495,6 +500,21 @@ static int show_locks(struct list_head *locks)
 
 	}
 
+	if (filter) {
+		struct libscols_filter *fltr = scols_new_filter(filter);
+
+		if (!fltr)
+			err(EXIT_FAILURE, _("failed to allocate filter"));
+		if (scols_filter_get_errmsg(fltr)
+		    || scols_table_set_filter(table, fltr) != 0) {
+			const char *msg = scols_filter_get_errmsg(fltr);
+
+			errx(EXIT_FAILURE, _("failed to use filter: %s"),
+					msg ? msg : _("invalid expression"));
+		}
+		scols_unref_filter(fltr);
+	}
+
 	/* prepare data for output */
 	list_for_each(p, locks) {
 		struct lock *l = list_entry(p, struct lock, locks);
@@ -538,6 +558,7 @@ static void __attribute__((__noreturn__)) usage(void)
 	fputs(_(" -o, --output <list>    define which output columns to use\n"), out);
 	fputs(_("     --output-all       output all columns\n"), out);
 	fputs(_(" -p, --pid <pid>        display only locks held by this process\n"), out);
+	fputs(_(" -Q, --filter <expr>    print only locks matching the expression\n"), out);
 	fputs(_(" -r, --raw              use the raw output format\n"), out);
 	fputs(_(" -u, --notruncate       don't truncate text in columns\n"), out);
 
@@ -566,6 +587,7 @@ int main(int argc, char *argv[])
 		{ "bytes",      no_argument,       NULL, 'b' },
 		{ "json",       no_argument,       NULL, 'J' },
 		{ "pid",	required_argument, NULL, 'p' },
+		{ "filter",	required_argument, NULL, 'Q' },
 		{ "help",	no_argument,       NULL, 'h' },
 		{ "output",     required_argument, NULL, 'o' },
 		{ "output-all",	no_argument,       NULL, OPT_OUTPUT_ALL },
@@ -588,7 +610,7 @@ int main(int argc, char *argv[])
 	close_stdout_atexit();
 
 	while ((c = getopt_long(argc, argv,
-				"biJp:o:nruhV", long_opts, NULL)) != -1) {
+				"biJp:o:nQ:ruhV", long_opts, NULL)) != -1) {
 
 		err_exclusive_options(c, long_opts, excl, excl_st);
 
@@ -605,6 +627,9 @@ int main(int argc, char *argv[])
 		case 'p':
 			pid = strtos32_or_err(optarg, _("invalid PID argument"));
 			break;
+		case 'Q':
+			filter = optarg;
+			break;
 		case 'o':
 			outarg = optarg;
 			break;
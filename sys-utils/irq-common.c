@@ -20,7 +20,9 @@
  */
 
 #include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <locale.h>
 #include <stdio.h>
@@ -34,12 +36,16 @@
 #include "c.h"
 #include "nls.h"
 #include "pathnames.h"
+#include "path.h"
 #include "strutils.h"
 #include "xalloc.h"
 
 #include "irq-common.h"
 
-#define IRQ_INFO_LEN	64
+/* initial size of the buffer for /proc/interrupts */
+#define IRQ_BUFSIZ	(64 * 1024)
+
+#define _PATH_SYS_NODE	"/sys/devices/system/node"
 
 struct colinfo {
 	const char *name;
@@ -73,19 +79,15 @@ struct softirq_desc {
 	{ .irq = "RCU", .desc = "RCU softirq" },
 };
 
-static void get_softirq_desc(struct irq_info *curr)
+static const char *get_softirq_desc(const char *irq)
 {
-	int i, size = ARRAY_SIZE(softirq_descs);
+	size_t i;
 
-	for (i = 0; i < size; i++) {
-		if (!strcmp(curr->irq, softirq_descs[i].irq))
-			break;
+	for (i = 0; i < ARRAY_SIZE(softirq_descs); i++) {
+		if (!strcmp(irq, softirq_descs[i].irq))
+			return softirq_descs[i].desc;
 	}
-
-	if (i < size)
-		curr->name = xstrdup(softirq_descs[i].desc);
-	else
-		curr->name = xstrdup("");
+	return "";
 }
 
 int irq_column_name_to_id(const char *name, size_t namesz)
@@ -159,6 +161,18 @@ static struct libscols_table *new_scols_table(struct irq_output *out)
 			scols_column_set_json_type(cl, col->json_type);
 	}
 
+	for (i = 0; i < out->ngroups; i++) {
+		struct libscols_column *cl;
+
+		cl = scols_table_new_column(table, out->groups[i].name, 0.05, SCOLS_FL_RIGHT);
+		if (cl == NULL) {
+			warnx(_("failed to initialize output column"));
+			goto err;
+		}
+		if (out->json)
+			scols_column_set_json_type(cl, SCOLS_JSON_NUMBER);
+	}
+
 	return table;
  err:
 	scols_unref_table(table);
@@ -201,6 +215,14 @@ static void add_scols_line(struct irq_output *out,
 		if (str && scols_line_refer_data(line, i, str) != 0)
 			err_oom();
 	}
+
+	for (i = 0; info->cpugroups && i < out->ngroups; i++) {
+		char *str = NULL;
+
+		xasprintf(&str, "%lu", info->cpugroups[i]);
+		if (scols_line_refer_data(line, out->ncolumns + i, str) != 0)
+			err_oom();
+	}
 }
 
 static char *remove_repeated_spaces(char *str)
@@ -224,100 +246,252 @@ static char *remove_repeated_spaces(char *str)
 	return str;
 }
 
+/*
+ * Reads all file to stat->buf. The buffer from the previous update is
+ * reused if available.
+ */
+static int read_irqfile(const char *path, struct irq_stat *stat,
+			struct irq_stat *prev, size_t *datasz)
+{
+	size_t sz = 0;
+	int fd, rc = 0;
+
+	*datasz = 0;
+
+	if (prev && prev->buf) {
+		stat->buf = prev->buf;
+		stat->bufsz = prev->bufsz;
+		prev->buf = NULL;
+		prev->bufsz = 0;
+	} else {
+		stat->bufsz = IRQ_BUFSIZ;
+		stat->buf = xmalloc(stat->bufsz);
+	}
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	while (1) {
+		ssize_t ret;
+
+		if (sz + 1 >= stat->bufsz) {
+			stat->bufsz *= 2;
+			stat->buf = xrealloc(stat->buf, stat->bufsz);
+		}
+		ret = read(fd, stat->buf + sz, stat->bufsz - sz - 1);
+		if (ret < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+			rc = -errno;
+			break;
+		}
+		if (ret == 0)
+			break;
+		sz += ret;
+	}
+	close(fd);
+
+	stat->buf[sz] = '\0';
+	*datasz = sz;
+	return rc;
+}
+
+/*
+ * Parses up to @max decimal numbers separated by blanks. Returns number
+ * of the parsed numbers, @str is moved behind the last number.
+ */
+static size_t parse_counters(char **str, unsigned long *res, size_t max)
+{
+	char *p = *str;
+	size_t n;
+
+	for (n = 0; n < max; n++) {
+		unsigned long num = 0;
+
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (!isdigit((unsigned char) *p))
+			break;
+		do {
+			num = num * 10 + (*p - '0');
+			p++;
+		} while (isdigit((unsigned char) *p));
+
+		res[n] = num;
+	}
+
+	*str = p;
+	return n;
+}
+
+/*
+ * Returns index of @irq in the previous stat. The lines are usually in the
+ * same order, so @hint (the expected index) is tried first.
+ */
+static ssize_t get_prev_index(struct irq_stat *prev, const char *irq, size_t *hint)
+{
+	size_t i;
+
+	if (*hint < prev->nr_irq
+	    && prev->irq_info[*hint].irq
+	    && strcmp(prev->irq_info[*hint].irq, irq) == 0)
+		i = *hint;
+	else {
+		for (i = 0; i < prev->nr_irq; i++) {
+			if (prev->irq_info[i].irq
+			    && strcmp(prev->irq_info[i].irq, irq) == 0)
+				break;
+		}
+		if (i == prev->nr_irq)
+			return -1;
+	}
+
+	*hint = i + 1;
+	return i;
+}
+
+/* Returns @str, a string from @prev is reused if the same */
+static char *reuse_string(char **prev, const char *str)
+{
+	char *res;
+
+	if (prev && *prev && strcmp(*prev, str) == 0) {
+		res = *prev;
+		*prev = NULL;
+	} else
+		res = xstrdup(str);
+	return res;
+}
+
 /*
  * irqinfo - parse the system's interrupts
+ *
+ * The deltas are calculated against @prev. The strings and buffers are
+ * moved from @prev to the new stat if possible, @prev is expected to be
+ * deallocated after this call.
  */
-static struct irq_stat *get_irqinfo(int softirq)
+static struct irq_stat *get_irqinfo(struct irq_output *out, int softirq,
+				     struct irq_stat *prev)
 {
-	FILE *irqfile;
-	char *line = NULL, *tmp;
-	size_t len = 0;
+	char *path = NULL, *p, *end, *eol;
+	size_t sz, nlines = 0, hint = 0, ncpus;
 	struct irq_stat *stat;
-	struct irq_info *curr;
+	int rc;
 
-	/* NAME + ':' + 11 bytes/cpu + IRQ_NAME_LEN */
 	stat = xcalloc(1, sizeof(*stat));
 
-	stat->irq_info = xmalloc(sizeof(*stat->irq_info) * IRQ_INFO_LEN);
-	stat->nr_irq_info = IRQ_INFO_LEN;
+	xasprintf(&path, "%s%s", out->sysroot ? out->sysroot : "",
+			softirq ? _PATH_PROC_SOFTIRQS : _PATH_PROC_INTERRUPTS);
 
-	if (softirq)
-		irqfile = fopen(_PATH_PROC_SOFTIRQS, "r");
-	else
-		irqfile = fopen(_PATH_PROC_INTERRUPTS, "r");
-	if (!irqfile) {
-		warn(_("cannot open %s"), _PATH_PROC_INTERRUPTS);
+	rc = read_irqfile(path, stat, prev, &sz);
+	if (rc || !sz) {
+		errno = -rc;
+		warn(_("cannot read %s"), path);
 		goto free_stat;
 	}
+	free(path);
+	p = stat->buf;
+	end = p + sz;
 
 	/* read header firstly */
-	if (getline(&line, &len, irqfile) < 0) {
-		warn(_("cannot read %s"), _PATH_PROC_INTERRUPTS);
-		goto close_file;
+	eol = memchr(p, '\n', end - p);
+	if (eol)
+		*eol = '\0';
+	while ((p = strstr(p, "CPU")) != NULL) {
+		p += 3;	/* skip this "CPU", find next */
+		stat->cpus = xrealloc(stat->cpus,
+				(stat->nr_active_cpu + 1) * sizeof(*stat->cpus));
+		stat->cpus[stat->nr_active_cpu++] = strtol(p, NULL, 10);
 	}
+	p = eol ? eol + 1 : end;
+	ncpus = stat->nr_active_cpu;
 
-	tmp = line;
-	while ((tmp = strstr(tmp, "CPU")) != NULL) {
-		tmp += 3;	/* skip this "CPU", find next */
-		stat->nr_active_cpu++;
-	}
+	for (eol = p; eol < end && (eol = memchr(eol, '\n', end - eol)); eol++)
+		nlines++;
+	nlines++;	/* the last line may be without \n */
 
-	/* parse each line of _PATH_PROC_INTERRUPTS */
-	while (getline(&line, &len, irqfile) >= 0) {
-		unsigned long count;
-		int index, length;
+	stat->nr_irq_info = nlines;
+	stat->irq_info = xcalloc(nlines, sizeof(*stat->irq_info));
+	stat->cpu_total = xcalloc(nlines * ncpus ?: 1, sizeof(unsigned long));
+
+	if (prev && prev->cpu_total && prev->nr_active_cpu == stat->nr_active_cpu)
+		stat->cpu_delta = xcalloc(nlines * ncpus ?: 1, sizeof(unsigned long));
+	else
+		prev = NULL;
 
-		tmp = strchr(line, ':');
+	/* parse each line of _PATH_PROC_INTERRUPTS */
+	for (; p < end; p = eol + 1) {
+		struct irq_info *curr, *pre = NULL;
+		unsigned long *counts;
+		char *irq, *tmp;
+		ssize_t idx = -1;
+		size_t i, n;
+
+		eol = memchr(p, '\n', end - p);
+		if (!eol)
+			eol = end;
+		*eol = '\0';
+
+		tmp = strchr(p, ':');
 		if (!tmp)
 			continue;
+		*tmp++ = '\0';
+
+		irq = (char *) skip_blank(p);
 
-		length = strlen(line);
+		curr = &stat->irq_info[stat->nr_irq];
+		counts = &stat->cpu_total[stat->nr_irq * ncpus];
 
-		curr = stat->irq_info + stat->nr_irq++;
-		memset(curr, 0, sizeof(*curr));
-		*tmp = '\0';
-		curr->irq = xstrdup(line);
-		ltrim_whitespace((unsigned char *)curr->irq);
+		n = parse_counters(&tmp, counts, ncpus);
+		for (i = 0; i < n; i++)
+			curr->total += counts[i];
+		stat->total_irq += curr->total;
 
-		tmp += 1;
-		for (index = 0; (index < stat->nr_active_cpu) && (tmp - line < length); index++) {
-			sscanf(tmp, " %10lu", &count);
-			curr->total += count;
-			stat->total_irq += count;
-			tmp += 11;
+		if (prev) {
+			idx = get_prev_index(prev, irq, &hint);
+			if (idx >= 0)
+				pre = &prev->irq_info[idx];
 		}
 
+		/* per-CPU and per-IRQ deltas */
+		if (pre) {
+			const unsigned long *old = &prev->cpu_total[idx * ncpus];
+			unsigned long *delta = &stat->cpu_delta[stat->nr_irq * ncpus];
+
+			for (i = 0; i < ncpus; i++)
+				delta[i] = counts[i] - old[i];
+			curr->delta = curr->total - pre->total;
+		} else if (prev) {
+			/* new IRQ since previous update */
+			memcpy(&stat->cpu_delta[stat->nr_irq * ncpus], counts,
+					ncpus * sizeof(unsigned long));
+			curr->delta = curr->total;
+		}
+		stat->delta_irq += curr->delta;
+
+		curr->irq = reuse_string(pre ? &pre->irq : NULL, irq);
+
 		/* softirq always has no desc, add additional desc for softirq */
 		if (softirq)
-			get_softirq_desc(curr);
+			tmp = (char *) get_softirq_desc(curr->irq);
 		else {
-			if (tmp - line < length) {
-				/* strip all space before desc */
-				while (isspace(*tmp))
-					tmp++;
-				tmp = remove_repeated_spaces(tmp);
-				rtrim_whitespace((unsigned char *)tmp);
-				curr->name = xstrdup(tmp);
-			} else /* no irq name string, we have to set '\0' here */
-				curr->name = xstrdup("");
+			/* strip all space before desc */
+			while (isspace(*tmp))
+				tmp++;
+			tmp = remove_repeated_spaces(tmp);
+			rtrim_whitespace((unsigned char *)tmp);
 		}
+		curr->name = reuse_string(pre ? &pre->name : NULL, tmp);
 
-		if (stat->nr_irq == stat->nr_irq_info) {
-			stat->nr_irq_info *= 2;
-			stat->irq_info = xrealloc(stat->irq_info,
-						  sizeof(*stat->irq_info) * stat->nr_irq_info);
-		}
+		stat->nr_irq++;
 	}
-	fclose(irqfile);
-	free(line);
+
 	return stat;
 
- close_file:
-	fclose(irqfile);
  free_stat:
-	free(stat->irq_info);
-	free(stat);
-	free(line);
+	free(path);
+	free_irqstat(stat);
 	return NULL;
 }
 
@@ -334,35 +508,40 @@ void free_irqstat(struct irq_stat *stat)
 	}
 
 	free(stat->irq_info);
+	free(stat->cpu_total);
+	free(stat->cpu_delta);
+	free(stat->cpus);
+	free(stat->cpugroups);
+	free(stat->buf);
 	free(stat);
 }
 
-static inline int cmp_name(const struct irq_info *a,
-		     const struct irq_info *b)
+static inline int cmp_name(const struct irq_info *const *a,
+		     const struct irq_info *const *b)
 {
-	return (strcmp(a->name, b->name) > 0) ? 1 : 0;
+	return (strcmp((*a)->name, (*b)->name) > 0) ? 1 : 0;
 }
 
-static inline int cmp_total(const struct irq_info *a,
-		      const struct irq_info *b)
+static inline int cmp_total(const struct irq_info *const *a,
+		      const struct irq_info *const *b)
 {
-	return a->total < b->total;
+	return (*a)->total < (*b)->total;
 }
 
-static inline int cmp_delta(const struct irq_info *a,
-		      const struct irq_info *b)
+static inline int cmp_delta(const struct irq_info *const *a,
+		      const struct irq_info *const *b)
 {
-	return a->delta < b->delta;
+	return (*a)->delta < (*b)->delta;
 }
 
-static inline int cmp_interrupts(const struct irq_info *a,
-			   const struct irq_info *b)
+static inline int cmp_interrupts(const struct irq_info *const *a,
+			   const struct irq_info *const *b)
 {
-	return (strcmp(a->irq, b->irq) > 0) ? 1 : 0;
+	return (strcmp((*a)->irq, (*b)->irq) > 0) ? 1 : 0;
 }
 
 static void sort_result(struct irq_output *out,
-			struct irq_info *result,
+			struct irq_info **result,
 			size_t nmemb)
 {
 	irq_cmp_t *func = cmp_total;	/* default */
@@ -374,6 +553,191 @@ static void sort_result(struct irq_output *out,
 			(int (*)(const void *, const void *)) func);
 }
 
+static int get_maxcpus(void)
+{
+	int maxcpus = get_max_number_of_cpus();
+
+	return maxcpus > 0 ? maxcpus : 2048;
+}
+
+static void add_cpugroup(struct irq_output *out, char *name,
+			 cpu_set_t *set, size_t setsize)
+{
+	struct irq_cpugroup *grp;
+
+	out->groups = xrealloc(out->groups, (out->ngroups + 1) * sizeof(*grp));
+	grp = &out->groups[out->ngroups++];
+
+	grp->name = name;
+	grp->set = set;
+	grp->setsize = setsize;
+}
+
+/*
+ * Adds output column with sum of the counts for CPUs in @cpulist.
+ */
+int irq_add_cpugroup(struct irq_output *out, const char *cpulist)
+{
+	cpu_set_t *set;
+	size_t setsize;
+	char *name;
+
+	set = cpuset_alloc(get_maxcpus(), &setsize, NULL);
+	if (!set)
+		return -ENOMEM;
+	if (cpulist_parse(cpulist, set, setsize, 0) != 0) {
+		cpuset_free(set);
+		return -EINVAL;
+	}
+
+	xasprintf(&name, "CPU%s", cpulist);
+	add_cpugroup(out, name, set, setsize);
+	return 0;
+}
+
+static int cmp_nodes(const void *a, const void *b)
+{
+	return *(const int *) a - *(const int *) b;
+}
+
+/*
+ * Adds output column for every NUMA node. Returns number of the nodes.
+ *
+ * Without NUMA support in kernel (no /sys/devices/system/node) all CPUs are
+ * in one NODE0 column, the same way lscpu reports a non-NUMA system.
+ */
+int irq_add_numa_cpugroups(struct irq_output *out)
+{
+	struct path_cxt *sys;
+	struct dirent *de;
+	int *nodes = NULL, maxcpus = get_maxcpus();
+	size_t i, nnodes = 0;
+	DIR *dir;
+
+	sys = ul_new_path(_PATH_SYS_NODE);
+	if (!sys)
+		return -ENOMEM;
+	if (out->sysroot && ul_path_set_prefix(sys, out->sysroot) != 0) {
+		ul_unref_path(sys);
+		return -ENOMEM;
+	}
+
+	dir = ul_path_opendir(sys, NULL);
+	if (!dir && errno != ENOENT) {
+		int rc = -errno;
+
+		ul_unref_path(sys);
+		return rc;
+	}
+	while (dir && (de = readdir(dir))) {
+		if (strncmp(de->d_name, "node", 4) != 0
+		    || !isdigit_string(de->d_name + 4))
+			continue;
+		nodes = xrealloc(nodes, (nnodes + 1) * sizeof(*nodes));
+		nodes[nnodes++] = strtol(de->d_name + 4, NULL, 10);
+	}
+	if (dir)
+		closedir(dir);
+
+	if (!nnodes) {
+		cpu_set_t *set;
+		size_t setsize;
+
+		ul_unref_path(sys);
+
+		set = cpuset_alloc(maxcpus, &setsize, NULL);
+		if (!set)
+			return -ENOMEM;
+		for (i = 0; i < (size_t) maxcpus; i++)
+			CPU_SET_S(i, setsize, set);
+
+		add_cpugroup(out, xstrdup("NODE0"), set, setsize);
+		return 1;
+	}
+
+	qsort(nodes, nnodes, sizeof(*nodes), cmp_nodes);
+
+	for (i = 0; i < nnodes; i++) {
+		cpu_set_t *set = NULL;
+		char *name;
+
+		if (ul_path_readf_cpulist(sys, &set, maxcpus,
+					"node%d/cpulist", nodes[i]) != 0 || !set)
+			continue;
+
+		xasprintf(&name, "NODE%d", nodes[i]);
+		add_cpugroup(out, name, set, CPU_ALLOC_SIZE(maxcpus));
+	}
+
+	free(nodes);
+	ul_unref_path(sys);
+	return nnodes;
+}
+
+void irq_free_cpugroups(struct irq_output *out)
+{
+	size_t i;
+
+	for (i = 0; i < out->ngroups; i++) {
+		free(out->groups[i].name);
+		cpuset_free(out->groups[i].set);
+	}
+	free(out->groups);
+	out->groups = NULL;
+	out->ngroups = 0;
+}
+
+/*
+ * Sums per-CPU totals (or deltas) for all CPU groups.
+ */
+static void sum_cpugroups(struct irq_output *out, struct irq_stat *stat)
+{
+	const unsigned long *data = out->groups_delta ? stat->cpu_delta : stat->cpu_total;
+	size_t ncpus = stat->nr_active_cpu, ngroups = out->ngroups;
+	size_t *cols, *ncols, i, g;
+
+	if (!ngroups)
+		return;
+
+	stat->cpugroups = xcalloc(stat->nr_irq * ngroups ?: 1, sizeof(unsigned long));
+
+	/* per-CPU columns of the groups */
+	cols = xcalloc(ngroups * ncpus ?: 1, sizeof(size_t));
+	ncols = xcalloc(ngroups, sizeof(size_t));
+
+	for (g = 0; g < ngroups; g++) {
+		struct irq_cpugroup *grp = &out->groups[g];
+
+		for (i = 0; i < ncpus; i++) {
+			int cpu = stat->cpus[i];
+
+			if (cpu >= 0 && (size_t) cpu < grp->setsize * 8
+			    && CPU_ISSET_S(cpu, grp->setsize, grp->set))
+				cols[g * ncpus + ncols[g]++] = i;
+		}
+	}
+
+	for (i = 0; i < stat->nr_irq; i++) {
+		unsigned long *res = &stat->cpugroups[i * ngroups];
+
+		stat->irq_info[i].cpugroups = res;
+		if (!data)
+			continue;	/* no deltas yet */
+
+		for (g = 0; g < ngroups; g++) {
+			const unsigned long *counts = &data[i * ncpus];
+			const size_t *c = &cols[g * ncpus];
+			size_t n;
+
+			for (n = 0; n < ncols[g]; n++)
+				res[g] += counts[c[n]];
+		}
+	}
+
+	free(cols);
+	free(ncols);
+}
+
 void set_sort_func_by_name(struct irq_output *out, const char *name)
 {
 	if (strcasecmp(name, "IRQ") == 0)
@@ -412,38 +776,37 @@ struct libscols_table *get_scols_table(struct irq_output *out,
 					      int softirq)
 {
 	struct libscols_table *table;
-	struct irq_info *result;
+	struct irq_info **result;
 	struct irq_stat *stat;
-	size_t size;
 	size_t i;
 
-	/* the stats */
-	stat = get_irqinfo(softirq);
+	/* the stats, including deltas */
+	stat = get_irqinfo(out, softirq, prev);
 	if (!stat)
 		return NULL;
 
-	size = sizeof(*stat->irq_info) * stat->nr_irq;
-	result = xmalloc(size);
-	memcpy(result, stat->irq_info, size);
+	sum_cpugroups(out, stat);
 
-	if (prev) {
-		stat->delta_irq = 0;
-		for (i = 0; i < stat->nr_irq; i++) {
-			struct irq_info *cur = &result[i];
-			struct irq_info *pre = &prev->irq_info[i];
+	/*
+	 * Sort pointers, stat->irq_info[] has to stay in the file order: it's
+	 * the row order of the per-CPU arrays, and the next update looks up
+	 * the previous lines by the position first.
+	 */
+	result = xmalloc((stat->nr_irq ?: 1) * sizeof(*result));
+	for (i = 0; i < stat->nr_irq; i++)
+		result[i] = &stat->irq_info[i];
 
-			cur->delta = cur->total - pre->total;
-			stat->delta_irq += cur->delta;
-		}
-	}
 	sort_result(out, result, stat->nr_irq);
 
 	table = new_scols_table(out);
-	if (!table)
+	if (!table) {
+		free(result);
+		free_irqstat(stat);
 		return NULL;
+	}
 
 	for (i = 0; i < stat->nr_irq; i++)
-		add_scols_line(out, &result[i], table);
+		add_scols_line(out, result[i], table);
 
 	free(result);
 
@@ -454,3 +817,66 @@ struct libscols_table *get_scols_table(struct irq_output *out,
 
 	return table;
 }
+
+#ifdef TEST_PROGRAM_IRQ
+#include <getopt.h>
+
+/*
+ * Prints interrupts from every <sysroot>/proc/interrupts, the deltas are
+ * calculated against the previous <sysroot> as irqtop does on refresh.
+ */
+int main(int argc, char **argv)
+{
+	struct irq_output out = {
+		.groups_delta = 1
+	};
+	static const struct option longopts[] = {
+		{"cpu-group", required_argument, NULL, 'c'},
+		{"softirq", no_argument, NULL, 'S'},
+		{NULL, 0, NULL, 0}
+	};
+	struct irq_stat *prev = NULL;
+	int c, softirq = 0;
+
+	while ((c = getopt_long(argc, argv, "c:S", longopts, NULL)) != -1) {
+		switch (c) {
+		case 'c':
+			if (irq_add_cpugroup(&out, optarg) != 0)
+				errx(EXIT_FAILURE, "failed to parse CPU list: %s", optarg);
+			break;
+		case 'S':
+			softirq = 1;
+			break;
+		default:
+			errx(EXIT_FAILURE, "usage: %s [--softirq] [--cpu-group <list>] "
+					   "<sysroot> [...]", program_invocation_short_name);
+		}
+	}
+
+	out.columns[out.ncolumns++] = COL_IRQ;
+	out.columns[out.ncolumns++] = COL_TOTAL;
+	out.columns[out.ncolumns++] = COL_DELTA;
+	out.columns[out.ncolumns++] = COL_NAME;
+	out.sort_cmp_func = cmp_interrupts;
+
+	for (; optind < argc; optind++) {
+		struct libscols_table *table;
+		struct irq_stat *stat = NULL;
+
+		out.sysroot = argv[optind];
+		table = get_scols_table(&out, prev, &stat, softirq);
+		if (!table)
+			return EXIT_FAILURE;
+
+		scols_print_table(table);
+		scols_unref_table(table);
+
+		free_irqstat(prev);
+		prev = stat;
+	}
+
+	free_irqstat(prev);
+	irq_free_cpugroups(&out);
+	return EXIT_SUCCESS;
+}
+#endif /* TEST_PROGRAM_IRQ */
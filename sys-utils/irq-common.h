@@ -3,6 +3,7 @@
 
 #include "c.h"
 #include "nls.h"
+#include "cpuset.h"
 
 /* supported columns */
 enum {
@@ -19,6 +20,7 @@ struct irq_info {
 	char *name;			/* descriptive name of this irq */
 	unsigned long total;		/* total count since system start up */
 	unsigned long delta;		/* delta count since previous update */
+	unsigned long *cpugroups;	/* counts per CPU group (irq_output) */
 };
 
 
@@ -29,21 +31,43 @@ struct irq_stat {
 	long nr_active_cpu;		/* number of active cpu */
 	unsigned long total_irq;	/* total irqs */
 	unsigned long delta_irq;	/* delta irqs */
+
+	/* per-CPU counters, nr_irq x nr_active_cpu, irq_info[] order */
+	unsigned long *cpu_total;	/* count since system start up */
+	unsigned long *cpu_delta;	/* count since previous update */
+	int *cpus;			/* CPU numbers of the per-CPU columns */
+	unsigned long *cpugroups;	/* nr_irq x ngroups */
+
+	char *buf;			/* file content, reused by next update */
+	size_t bufsz;
 };
 
-typedef int (irq_cmp_t)(const struct irq_info *, const struct irq_info *);
+typedef int (irq_cmp_t)(const struct irq_info *const *, const struct irq_info *const *);
+
+/* CPUs aggregated to one output column */
+struct irq_cpugroup {
+	char *name;			/* column name */
+	cpu_set_t *set;
+	size_t setsize;
+};
 
 /* output definition */
 struct irq_output {
 	int columns[__COL_COUNT * 2];
 	size_t ncolumns;
 
+	struct irq_cpugroup *groups;	/* columns after the regular columns */
+	size_t ngroups;
+
 	irq_cmp_t *sort_cmp_func;
 
+	const char *sysroot;		/* prefix for /proc and /sys paths */
+
 	unsigned int
 		json:1,		/* JSON output */
 		pairs:1,	/* export, NAME="value" aoutput */
-		no_headings:1;	/* don't print header */
+		no_headings:1,	/* don't print header */
+		groups_delta:1;	/* CPU groups show deltas rather than totals */
 };
 
 int irq_column_name_to_id(char const *const name, size_t const namesz);
@@ -51,6 +75,10 @@ void free_irqstat(struct irq_stat *stat);
 
 void irq_print_columns(FILE *f, int nodelta);
 
+int irq_add_cpugroup(struct irq_output *out, const char *cpulist);
+int irq_add_numa_cpugroups(struct irq_output *out);
+void irq_free_cpugroups(struct irq_output *out);
+
 void set_sort_func_by_name(struct irq_output *out, const char *name);
 void set_sort_func_by_key(struct irq_output *out, const char c);
 
@@ -221,7 +221,10 @@ static void __attribute__((__noreturn__)) usage(void)
 	puts(_("Interactive utility to display kernel interrupt information."));
 
 	fputs(USAGE_OPTIONS, stdout);
+	fputs(_(" -c, --cpu-group <list>\n"
+		"                      add column with deltas for CPUs in <list>\n"), stdout);
 	fputs(_(" -d, --delay <secs>   delay updates\n"), stdout);
+	fputs(_(" -N, --numa           add column with deltas for every NUMA node\n"), stdout);
 	fputs(_(" -o, --output <list>  define which output columns to use\n"), stdout);
 	fputs(_(" -s, --sort <column>  specify sort column\n"), stdout);
 	fputs(_(" -S, --softirq        show softirqs instead of interrupts\n"), stdout);
@@ -248,18 +251,24 @@ static void parse_args(	struct irqtop_ctl *ctl,
 			char **argv)
 {
 	const char *outarg = NULL;
+	enum {
+		OPT_SYSROOT = CHAR_MAX + 1
+	};
 	static const struct option longopts[] = {
+		{"cpu-group", required_argument, NULL, 'c'},
 		{"delay", required_argument, NULL, 'd'},
+		{"numa", no_argument, NULL, 'N'},
 		{"sort", required_argument, NULL, 's'},
 		{"output", required_argument, NULL, 'o'},
 		{"softirq", no_argument, NULL, 'S'},
+		{"sysroot", required_argument, NULL, OPT_SYSROOT},	/* for tests */
 		{"help", no_argument, NULL, 'h'},
 		{"version", no_argument, NULL, 'V'},
 		{NULL, 0, NULL, 0}
 	};
-	int o;
+	int o, numa = 0;
 
-	while ((o = getopt_long(argc, argv, "d:o:s:ShV", longopts, NULL)) != -1) {
+	while ((o = getopt_long(argc, argv, "c:d:No:s:ShV", longopts, NULL)) != -1) {
 		switch (o) {
 		case 'd':
 			{
@@ -271,6 +280,13 @@ static void parse_args(	struct irqtop_ctl *ctl,
 				ctl->timer.it_value = ctl->timer.it_interval;
 			}
 			break;
+		case 'c':
+			if (irq_add_cpugroup(out, optarg) != 0)
+				errx(EXIT_FAILURE, _("failed to parse CPU list: %s"), optarg);
+			break;
+		case 'N':
+			numa = 1;
+			break;
 		case 's':
 			set_sort_func_by_name(out, optarg);
 			break;
@@ -280,6 +296,9 @@ static void parse_args(	struct irqtop_ctl *ctl,
 		case 'S':
 			ctl->softirq = 1;
 			break;
+		case OPT_SYSROOT:
+			out->sysroot = optarg;
+			break;
 		case 'V':
 			print_version(EXIT_SUCCESS);
 		case 'h':
@@ -289,6 +308,10 @@ static void parse_args(	struct irqtop_ctl *ctl,
 		}
 	}
 
+	/* after --sysroot, and only once for repeated -N */
+	if (numa && irq_add_numa_cpugroups(out) < 0)
+		err(EXIT_FAILURE, _("cannot read NUMA nodes"));
+
 	/* default */
 	if (!out->ncolumns) {
 		out->columns[out->ncolumns++] = COL_IRQ;
@@ -310,7 +333,8 @@ int main(int argc, char **argv)
 	int is_tty = 0;
 	struct termios saved_tty;
 	struct irq_output out = {
-		.ncolumns = 0
+		.ncolumns = 0,
+		.groups_delta = 1
 	};
 	struct irqtop_ctl ctl = {
 		.timer.it_interval = {3, 0},
@@ -336,6 +360,7 @@ int main(int argc, char **argv)
 	event_loop(&ctl, &out);
 
 	free_irqstat(ctl.prev_stat);
+	irq_free_cpugroups(&out);
 	free(ctl.hostname);
 
 	if (is_tty)
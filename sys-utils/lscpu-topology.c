@@ -6,28 +6,101 @@
 #include <unistd.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #include "lscpu.h"
+#include "fnv.h"
+#include "parallel.h"
+
+#define LSCPU_MAXTHREADS	16
+#define LSCPU_PARALLEL_MIN	64	/* minimal number of CPUs to use threads */
+
+/*
+ * Per-CPU data from sysfs. The data are read for all CPUs (maybe in more
+ * threads) before the topology and caches are composed in the CPUs order.
+ */
+struct lscpu_cachedata {
+	int	id;
+	int	level;
+	char	type[32];
+	unsigned int	valid : 1;
+};
+
+struct lscpu_cpudata {
+	cpu_set_t	*thread_siblings,
+			*core_siblings,
+			*book_siblings,
+			*drawer_siblings;
+
+	struct lscpu_cachedata	*caches;
+	size_t			ncaches;
+
+	unsigned int	has_topology : 1,
+			has_polarization : 1,
+			has_address : 1,
+			has_configured : 1;
+};
 
-/* add @set to the @ary, unnecessary set is deallocated. */
-static int add_cpuset_to_array(cpu_set_t **ary, size_t *items, cpu_set_t *set, size_t setsize)
+/*
+ * Open addressing hash index for cpusets and caches, the slots contain
+ * index in the indexed array + 1; zero is empty slot.
+ */
+struct lscpu_hashidx {
+	size_t	*slots;
+	size_t	mask;
+};
+
+static void init_hashidx(struct lscpu_hashidx *idx, size_t nitems)
 {
-	size_t i;
+	size_t sz = 16;
 
-	if (!ary)
+	while (sz < nitems * 2)
+		sz <<= 1;
+
+	idx->slots = xcalloc(sz, sizeof(size_t));
+	idx->mask = sz - 1;
+}
+
+static void free_hashidx(struct lscpu_hashidx *idx)
+{
+	free(idx->slots);
+	idx->slots = NULL;
+	idx->mask = 0;
+}
+
+static uint64_t hash_cpuset(const cpu_set_t *set, size_t setsize)
+{
+	return ul_hash_mix64(ul_fnv1a64_buf(UL_FNV64_INIT, set, setsize));
+}
+
+/* add @set to the @ary, unnecessary set is deallocated. The @idx has to be
+ * large enough for all possible items. */
+static int add_cpuset_to_array(cpu_set_t **ary, size_t *items, cpu_set_t *set,
+			       size_t setsize, struct lscpu_hashidx *idx)
+{
+	size_t i, *slot;
+
+	if (!ary || !set)
 		return -EINVAL;
 
-	for (i = 0; i < *items; i++) {
-		if (CPU_EQUAL_S(setsize, set, ary[i]))
+	for (i = hash_cpuset(set, setsize) & idx->mask; ; i = (i + 1) & idx->mask) {
+		slot = &idx->slots[i];
+		if (!*slot)
 			break;
+		if (CPU_EQUAL_S(setsize, set, ary[*slot - 1])) {
+			CPU_FREE(set);
+			return 1;
+		}
 	}
-	if (i == *items) {
-		ary[*items] = set;
-		++*items;
-		return 0;
-	}
-	CPU_FREE(set);
-	return 1;
+
+	ary[*items] = set;
+	++*items;
+	*slot = *items;
+	return 0;
 }
 
 static void free_cpuset_array(cpu_set_t **ary, int items)
@@ -88,43 +161,42 @@ void lscpu_sort_caches(struct lscpu_cache *caches, size_t n)
 }
 
 
-/* Read topology for specified type */
-static int cputype_read_topology(struct lscpu_cxt *cxt, struct lscpu_cputype *ct)
+/* Compose topology for specified type from per-CPU data */
+static int cputype_read_topology(struct lscpu_cxt *cxt, struct lscpu_cputype *ct,
+				 struct lscpu_cpudata *data)
 {
 	size_t i, npos;
-	struct path_cxt *sys;
 	int nthreads = 0, sw_topo = 0;
+	struct lscpu_hashidx coreidx, socketidx, bookidx, draweridx;
 	FILE *fd;
 
-	sys = cxt->syscpu;				/* /sys/devices/system/cpu/ */
 	npos = cxt->npossibles;				/* possible CPUs */
 
 	DBG(TYPE, ul_debugobj(ct, "reading %s/%s/%s topology",
 				ct->vendor ?: "", ct->model ?: "", ct->modelname ?:""));
 
+	init_hashidx(&coreidx, npos);
+	init_hashidx(&socketidx, npos);
+	init_hashidx(&bookidx, npos);
+	init_hashidx(&draweridx, npos);
+
 	for (i = 0; i < cxt->npossibles; i++) {
 		struct lscpu_cpu *cpu = cxt->cpus[i];
-		cpu_set_t *thread_siblings = NULL, *core_siblings = NULL;
-		cpu_set_t *book_siblings = NULL, *drawer_siblings = NULL;
-		int num, n;
+		struct lscpu_cpudata *d = &data[i];
+		cpu_set_t *thread_siblings, *core_siblings;
+		cpu_set_t *book_siblings, *drawer_siblings;
+		int n;
 
-		if (!cpu || cpu->type != ct)
+		if (!cpu || cpu->type != ct || !d->has_topology)
 			continue;
 
-		num = cpu->logical_id;
-		if (ul_path_accessf(sys, F_OK,
-					"cpu%d/topology/thread_siblings", num) != 0)
-			continue;
-
-		/* read topology maps */
-		ul_path_readf_cpuset(sys, &thread_siblings, cxt->maxcpus,
-					"cpu%d/topology/thread_siblings", num);
-		ul_path_readf_cpuset(sys, &core_siblings, cxt->maxcpus,
-					"cpu%d/topology/core_siblings", num);
-		ul_path_readf_cpuset(sys, &book_siblings, cxt->maxcpus,
-					"cpu%d/topology/book_siblings", num);
-		ul_path_readf_cpuset(sys, &drawer_siblings, cxt->maxcpus,
-					"cpu%d/topology/drawer_siblings", num);
+		/* the maps are owned by the topology arrays now */
+		thread_siblings = d->thread_siblings;
+		core_siblings = d->core_siblings;
+		book_siblings = d->book_siblings;
+		drawer_siblings = d->drawer_siblings;
+		d->thread_siblings = d->core_siblings = NULL;
+		d->book_siblings = d->drawer_siblings = NULL;
 
 		n = CPU_COUNT_S(cxt->setsize, thread_siblings);
 		if (!n)
@@ -150,16 +222,25 @@ static int cputype_read_topology(struct lscpu_cxt *cxt, struct lscpu_cputype *ct
 			ct->drawermaps = xcalloc(npos, sizeof(cpu_set_t *));
 
 		/* add to topology maps */
-		add_cpuset_to_array(ct->coremaps, &ct->ncores, thread_siblings, cxt->setsize);
-		add_cpuset_to_array(ct->socketmaps, &ct->nsockets, core_siblings, cxt->setsize);
+		add_cpuset_to_array(ct->coremaps, &ct->ncores, thread_siblings,
+				    cxt->setsize, &coreidx);
+		add_cpuset_to_array(ct->socketmaps, &ct->nsockets, core_siblings,
+				    cxt->setsize, &socketidx);
 
 		if (book_siblings)
-			add_cpuset_to_array(ct->bookmaps, &ct->nbooks, book_siblings, cxt->setsize);
+			add_cpuset_to_array(ct->bookmaps, &ct->nbooks, book_siblings,
+					    cxt->setsize, &bookidx);
 		if (drawer_siblings)
-			add_cpuset_to_array(ct->drawermaps, &ct->ndrawers, drawer_siblings, cxt->setsize);
+			add_cpuset_to_array(ct->drawermaps, &ct->ndrawers, drawer_siblings,
+					    cxt->setsize, &draweridx);
 
 	}
 
+	free_hashidx(&coreidx);
+	free_hashidx(&socketidx);
+	free_hashidx(&bookidx);
+	free_hashidx(&draweridx);
+
 	/* s390 detects its cpu topology via /proc/sysinfo, if present.
 	 * Using simply the cpu topology masks in sysfs will not give
 	 * usable results since everything is virtualized. E.g.
@@ -237,16 +318,28 @@ struct lscpu_cache *lscpu_cpu_get_cache(struct lscpu_cxt *cxt,
 	return NULL;
 }
 
+static uint64_t hash_cache(const char *type, int level, int id)
+{
+	uint64_t h = ul_fnv1a64_str(UL_FNV64_INIT, type);
+
+	h = ul_fnv1a64_add(h, (uint32_t) level);
+	h = ul_fnv1a64_add(h, (uint32_t) id);
+
+	return ul_hash_mix64(h);
+}
+
 /*
  * The cache is identifued by type+level+id.
  */
-static struct lscpu_cache *get_cache(struct lscpu_cxt *cxt,
+static struct lscpu_cache *get_cache(struct lscpu_cxt *cxt, struct lscpu_hashidx *idx,
 				const char *type, int level, int id)
 {
 	size_t i;
 
-	for (i = 0; i < cxt->ncaches; i++) {
-		struct lscpu_cache *ca = &cxt->caches[i];
+	for (i = hash_cache(type, level, id) & idx->mask; idx->slots[i];
+	     i = (i + 1) & idx->mask) {
+		struct lscpu_cache *ca = &cxt->caches[idx->slots[i] - 1];
+
 		if (ca->id == id &&
 		    ca->level == level &&
 		    strcmp(ca->type, type) == 0)
@@ -255,7 +348,17 @@ static struct lscpu_cache *get_cache(struct lscpu_cxt *cxt,
 	return NULL;
 }
 
-static struct lscpu_cache *add_cache(struct lscpu_cxt *cxt,
+static void hashidx_add_cache(struct lscpu_hashidx *idx, struct lscpu_cache *ca, size_t n)
+{
+	size_t i;
+
+	for (i = hash_cache(ca->type, ca->level, ca->id) & idx->mask; idx->slots[i];
+	     i = (i + 1) & idx->mask)
+		;
+	idx->slots[i] = n + 1;
+}
+
+static struct lscpu_cache *add_cache(struct lscpu_cxt *cxt, struct lscpu_hashidx *idx,
 				const char *type, int level, int id)
 {
 	struct lscpu_cache *ca;
@@ -271,6 +374,17 @@ static struct lscpu_cache *add_cache(struct lscpu_cxt *cxt,
 	ca->level = level;
 	ca->type = xstrdup(type);
 
+	/* keep the index at most half full */
+	if (cxt->ncaches * 2 > idx->mask + 1) {
+		size_t i;
+
+		free_hashidx(idx);
+		init_hashidx(idx, cxt->ncaches);
+		for (i = 0; i < cxt->ncaches; i++)
+			hashidx_add_cache(idx, &cxt->caches[i], i);
+	} else
+		hashidx_add_cache(idx, ca, cxt->ncaches - 1);
+
 	DBG(GATHER, ul_debugobj(cxt, "add cache %s%d::%d", type, level, id));
 	return ca;
 }
@@ -294,10 +408,11 @@ static int mk_cache_id(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu, char *type,
 	return idx;
 }
 
-static int read_caches(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+/* Reads type, level and ID of all CPU caches */
+static int read_caches(struct lscpu_cxt *cxt __attribute__((__unused__)),
+		       struct path_cxt *sys, struct lscpu_cpu *cpu,
+		       struct lscpu_cpudata *d)
 {
-	char buf[256];
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 	size_t i, ncaches = 0;
 
@@ -308,24 +423,52 @@ static int read_caches(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 
 	DBG(CPU, ul_debugobj(cpu, "#%d reading %zd caches", num, ncaches));
 
+	if (!ncaches)
+		return 0;
+
+	d->caches = xcalloc(ncaches, sizeof(*d->caches));
+	d->ncaches = ncaches;
+
 	for (i = 0; i < ncaches; i++) {
-		struct lscpu_cache *ca;
-		int id, level;
+		struct lscpu_cachedata *cd = &d->caches[i];
 
-		if (ul_path_readf_s32(sys, &id, "cpu%d/cache/index%zu/id", num, i) != 0)
-			id = -1;
-		if (ul_path_readf_s32(sys, &level, "cpu%d/cache/index%zu/level", num, i) != 0)
+		if (ul_path_readf_s32(sys, &cd->id, "cpu%d/cache/index%zu/id", num, i) != 0)
+			cd->id = -1;
+		if (ul_path_readf_s32(sys, &cd->level, "cpu%d/cache/index%zu/level", num, i) != 0)
 			continue;
-		if (ul_path_readf_buffer(sys, buf, sizeof(buf),
+		if (ul_path_readf_buffer(sys, cd->type, sizeof(cd->type),
                                         "cpu%d/cache/index%zu/type", num, i) <= 0)
 			continue;
+		cd->valid = 1;
+	}
+
+	return 0;
+}
+
+/* Adds CPU caches to the list of all caches, the cache attributes are read
+ * only once for each cache instance */
+static int add_cpu_caches(struct lscpu_cxt *cxt, struct lscpu_hashidx *idx,
+			  struct lscpu_cpu *cpu, struct lscpu_cpudata *d)
+{
+	char buf[256];
+	struct path_cxt *sys = cxt->syscpu;
+	int num = cpu->logical_id;
+	size_t i;
+
+	for (i = 0; i < d->ncaches; i++) {
+		struct lscpu_cachedata *cd = &d->caches[i];
+		struct lscpu_cache *ca;
+		int id = cd->id;
+
+		if (!cd->valid)
+			continue;
 
 		if (id == -1)
-			id = mk_cache_id(cxt, cpu, buf, level);
+			id = mk_cache_id(cxt, cpu, cd->type, cd->level);
 
-		ca = get_cache(cxt, buf, level, id);
+		ca = get_cache(cxt, idx, cd->type, cd->level, id);
 		if (!ca)
-			ca = add_cache(cxt, buf, level, id);
+			ca = add_cache(cxt, idx, cd->type, cd->level, id);
 
 		if (!ca->name) {
 			int type = 0;
@@ -375,9 +518,30 @@ static int read_caches(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	return 0;
 }
 
-static int read_ids(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+static int read_topology_maps(struct lscpu_cxt *cxt, struct path_cxt *sys,
+			      struct lscpu_cpu *cpu, struct lscpu_cpudata *d)
+{
+	int num = cpu->logical_id;
+
+	if (ul_path_accessf(sys, F_OK,
+				"cpu%d/topology/thread_siblings", num) != 0)
+		return 0;
+
+	d->has_topology = 1;
+
+	ul_path_readf_cpuset(sys, &d->thread_siblings, cxt->maxcpus,
+				"cpu%d/topology/thread_siblings", num);
+	ul_path_readf_cpuset(sys, &d->core_siblings, cxt->maxcpus,
+				"cpu%d/topology/core_siblings", num);
+	ul_path_readf_cpuset(sys, &d->book_siblings, cxt->maxcpus,
+				"cpu%d/topology/book_siblings", num);
+	ul_path_readf_cpuset(sys, &d->drawer_siblings, cxt->maxcpus,
+				"cpu%d/topology/drawer_siblings", num);
+	return 0;
+}
+
+static int read_ids(struct path_cxt *sys, struct lscpu_cpu *cpu)
 {
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 
 	if (ul_path_accessf(sys, F_OK, "cpu%d/topology", num) != 0)
@@ -397,9 +561,9 @@ static int read_ids(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	return 0;
 }
 
-static int read_polarization(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+static int read_polarization(struct path_cxt *sys, struct lscpu_cpu *cpu,
+			     struct lscpu_cpudata *d)
 {
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 	char mode[64];
 
@@ -421,14 +585,13 @@ static int read_polarization(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	else
 		cpu->polarization = POLAR_UNKNOWN;
 
-	if (cpu->type)
-		cpu->type->has_polarization = 1;
+	d->has_polarization = 1;
 	return 0;
 }
 
-static int read_address(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+static int read_address(struct path_cxt *sys, struct lscpu_cpu *cpu,
+			struct lscpu_cpudata *d)
 {
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 
 	if (ul_path_accessf(sys, F_OK, "cpu%d/address", num) != 0)
@@ -437,14 +600,13 @@ static int read_address(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	DBG(CPU, ul_debugobj(cpu, "#%d reading address", num));
 
 	ul_path_readf_s32(sys, &cpu->address, "cpu%d/address", num);
-	if (cpu->type)
-		cpu->type->has_addresses = 1;
+	d->has_address = 1;
 	return 0;
 }
 
-static int read_configure(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+static int read_configure(struct path_cxt *sys, struct lscpu_cpu *cpu,
+			  struct lscpu_cpudata *d)
 {
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 
 	if (ul_path_accessf(sys, F_OK, "cpu%d/configure", num) != 0)
@@ -453,14 +615,12 @@ static int read_configure(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	DBG(CPU, ul_debugobj(cpu, "#%d reading configure", num));
 
 	ul_path_readf_s32(sys, &cpu->configured, "cpu%d/configure", num);
-	if (cpu->type)
-		cpu->type->has_configured = 1;
+	d->has_configured = 1;
 	return 0;
 }
 
-static int read_mhz(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
+static int read_mhz(struct path_cxt *sys, struct lscpu_cpu *cpu)
 {
-	struct path_cxt *sys = cxt->syscpu;
 	int num = cpu->logical_id;
 	int mhz;
 
@@ -471,9 +631,6 @@ static int read_mhz(struct lscpu_cxt *cxt, struct lscpu_cpu *cpu)
 	if (ul_path_readf_s32(sys, &mhz, "cpu%d/cpufreq/cpuinfo_min_freq", num) == 0)
 		cpu->mhz_min_freq = (float) mhz / 1000;
 
-	if (cpu->type && (cpu->mhz_min_freq || cpu->mhz_max_freq))
-		cpu->type->has_freq = 1;
-
 	return 0;
 }
 
@@ -508,35 +665,180 @@ float lsblk_cputype_get_minmhz(struct lscpu_cxt *cxt, struct lscpu_cputype *ct)
 	return res;
 }
 
-int lscpu_read_topology(struct lscpu_cxt *cxt)
+/* Reads all per-CPU data from sysfs, the @sys is private for the thread */
+static int read_cpudata(struct lscpu_cxt *cxt, struct path_cxt *sys,
+			size_t from, size_t to, struct lscpu_cpudata *data)
 {
 	size_t i;
 	int rc = 0;
 
-
-	for (i = 0; i < cxt->ncputypes; i++)
-		rc += cputype_read_topology(cxt, cxt->cputypes[i]);
-
-	for (i = 0; rc == 0 && i < cxt->npossibles; i++) {
+	for (i = from; rc == 0 && i < to; i++) {
 		struct lscpu_cpu *cpu = cxt->cpus[i];
+		struct lscpu_cpudata *d = &data[i];
 
 		if (!cpu || !cpu->type)
 			continue;
 
 		DBG(CPU, ul_debugobj(cpu, "#%d reading topology", cpu->logical_id));
 
-		rc = read_ids(cxt, cpu);
+		rc = read_topology_maps(cxt, sys, cpu, d);
 		if (!rc)
-			rc = read_polarization(cxt, cpu);
+			rc = read_ids(sys, cpu);
 		if (!rc)
-			rc = read_address(cxt, cpu);
+			rc = read_polarization(sys, cpu, d);
 		if (!rc)
-			rc = read_configure(cxt, cpu);
+			rc = read_address(sys, cpu, d);
 		if (!rc)
-			rc = read_mhz(cxt, cpu);
+			rc = read_configure(sys, cpu, d);
 		if (!rc)
-			rc = read_caches(cxt, cpu);
+			rc = read_mhz(sys, cpu);
+		if (!rc)
+			rc = read_caches(cxt, sys, cpu, d);
+	}
+	return rc;
+}
+
+#ifdef HAVE_PTHREAD
+struct lscpu_reader {
+	pthread_t		thread;
+	struct lscpu_cxt	*cxt;
+	struct lscpu_cpudata	*data;
+	size_t			from, to;
+	int			rc;
+};
+
+static void *cpudata_thread(void *arg)
+{
+	struct lscpu_reader *rd = (struct lscpu_reader *) arg;
+	struct path_cxt *sys;
+
+	/* path_cxt is not thread-safe, use private one */
+	sys = ul_new_path(_PATH_SYS_CPU);
+	if (!sys) {
+		rd->rc = -ENOMEM;
+		return NULL;
 	}
+	if (rd->cxt->prefix)
+		ul_path_set_prefix(sys, rd->cxt->prefix);
+
+	/* open the directory before ul_path_*f() use the path buffer */
+	if (ul_path_get_dirfd(sys) < 0)
+		rd->rc = -errno;
+	else
+		rd->rc = read_cpudata(rd->cxt, sys, rd->from, rd->to, rd->data);
+
+	ul_unref_path(sys);
+	return NULL;
+}
+
+static size_t get_nthreads(struct lscpu_cxt *cxt)
+{
+	return ul_get_nthreads("LSCPU_THREADS", cxt->npossibles,
+			       LSCPU_PARALLEL_MIN, LSCPU_MAXTHREADS);
+}
+
+/* Reads per-CPU data in more threads, every thread reads a range of CPUs */
+static int read_cpudata_parallel(struct lscpu_cxt *cxt, struct lscpu_cpudata *data)
+{
+	struct lscpu_reader rds[LSCPU_MAXTHREADS];
+	size_t i, nthreads = get_nthreads(cxt), chunk;
+	int rc = 0;
+
+	if (nthreads <= 1)
+		return read_cpudata(cxt, cxt->syscpu, 0, cxt->npossibles, data);
+
+	DBG(GATHER, ul_debugobj(cxt, "reading %zu CPUs in %zu threads",
+				cxt->npossibles, nthreads));
+	ul_path_init_debug();
+
+	chunk = (cxt->npossibles + nthreads - 1) / nthreads;
+
+	for (i = 0; i < nthreads; i++) {
+		struct lscpu_reader *rd = &rds[i];
+
+		rd->cxt = cxt;
+		rd->data = data;
+		rd->from = min(i * chunk, cxt->npossibles);
+		rd->to = min(rd->from + chunk, cxt->npossibles);
+		rd->rc = 0;
+
+		if (pthread_create(&rd->thread, NULL, cpudata_thread, rd) != 0) {
+			/* read the rest in this thread */
+			rc = read_cpudata(cxt, cxt->syscpu, rd->from, cxt->npossibles, data);
+			break;
+		}
+	}
+	nthreads = i;
+
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(rds[i].thread, NULL);
+		if (!rc)
+			rc = rds[i].rc;
+	}
+	return rc;
+}
+#else
+static int read_cpudata_parallel(struct lscpu_cxt *cxt, struct lscpu_cpudata *data)
+{
+	return read_cpudata(cxt, cxt->syscpu, 0, cxt->npossibles, data);
+}
+#endif /* HAVE_PTHREAD */
+
+static void free_cpudata(struct lscpu_cpudata *data, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		struct lscpu_cpudata *d = &data[i];
+
+		cpuset_free(d->thread_siblings);
+		cpuset_free(d->core_siblings);
+		cpuset_free(d->book_siblings);
+		cpuset_free(d->drawer_siblings);
+		free(d->caches);
+	}
+	free(data);
+}
+
+int lscpu_read_topology(struct lscpu_cxt *cxt)
+{
+	struct lscpu_cpudata *data;
+	struct lscpu_hashidx cacheidx;
+	size_t i;
+	int rc;
+
+	data = xcalloc(cxt->npossibles ?: 1, sizeof(*data));
+
+	rc = read_cpudata_parallel(cxt, data);
+
+	for (i = 0; i < cxt->ncputypes; i++)
+		rc += cputype_read_topology(cxt, cxt->cputypes[i], data);
+
+	init_hashidx(&cacheidx, cxt->ncaches);
+	for (i = 0; i < cxt->ncaches; i++)
+		hashidx_add_cache(&cacheidx, &cxt->caches[i], i);
+
+	for (i = 0; rc == 0 && i < cxt->npossibles; i++) {
+		struct lscpu_cpu *cpu = cxt->cpus[i];
+		struct lscpu_cpudata *d = &data[i];
+
+		if (!cpu || !cpu->type)
+			continue;
+
+		if (d->has_polarization)
+			cpu->type->has_polarization = 1;
+		if (d->has_address)
+			cpu->type->has_addresses = 1;
+		if (d->has_configured)
+			cpu->type->has_configured = 1;
+		if (cpu->mhz_min_freq || cpu->mhz_max_freq)
+			cpu->type->has_freq = 1;
+
+		rc = add_cpu_caches(cxt, &cacheidx, cpu, d);
+	}
+
+	free_hashidx(&cacheidx);
+	free_cpudata(data, cxt->npossibles);
 
 	lscpu_sort_caches(cxt->caches, cxt->ncaches);
 	DBG(GATHER, ul_debugobj(cxt, " L1d: %zu", lscpu_get_cache_full_size(cxt, "L1d")));
@@ -546,5 +848,3 @@ int lscpu_read_topology(struct lscpu_cxt *cxt)
 
 	return rc;
 }
-
-
@@ -60,9 +60,12 @@ static void __attribute__((__noreturn__)) usage(void)
 	puts(_("Utility to display kernel interrupt information."));
 
 	fputs(USAGE_OPTIONS, stdout);
+	fputs(_(" -c, --cpu-group <list>\n"
+		"                      add column with counts for CPUs in <list>\n"), stdout);
 	fputs(_(" -J, --json           use JSON output format\n"), stdout);
 	fputs(_(" -P, --pairs          use key=\"value\" output format\n"), stdout);
 	fputs(_(" -n, --noheadings     don't print headings\n"), stdout);
+	fputs(_(" -N, --numa           add column with counts for every NUMA node\n"), stdout);
 	fputs(_(" -o, --output <list>  define which output columns to use\n"), stdout);
 	fputs(_(" -s, --sort <column>  specify sort column\n"), stdout);
 	fputs(_(" -S, --softirq        show softirqs instead of interrupts\n"), stdout);
@@ -81,13 +84,19 @@ int main(int argc, char **argv)
 	struct irq_output out = {
 		.ncolumns = 0
 	};
+	enum {
+		OPT_SYSROOT = CHAR_MAX + 1
+	};
 	static const struct option longopts[] = {
 		{"sort", required_argument, NULL, 's'},
+		{"cpu-group", required_argument, NULL, 'c'},
 		{"noheadings", no_argument, NULL, 'n'},
+		{"numa", no_argument, NULL, 'N'},
 		{"output", required_argument, NULL, 'o'},
 		{"softirq", no_argument, NULL, 'S'},
 		{"json", no_argument, NULL, 'J'},
 		{"pairs", no_argument, NULL, 'P'},
+		{"sysroot", required_argument, NULL, OPT_SYSROOT},	/* for tests */
 		{"help", no_argument, NULL, 'h'},
 		{"version", no_argument, NULL, 'V'},
 		{NULL, 0, NULL, 0}
@@ -99,11 +108,11 @@ int main(int argc, char **argv)
 		{0}
 	};
 	int excl_st[ARRAY_SIZE(excl)] = UL_EXCL_STATUS_INIT;
-	int softirq = 0;
+	int softirq = 0, numa = 0;
 
 	setlocale(LC_ALL, "");
 
-	while ((c = getopt_long(argc, argv, "no:s:ShJPV", longopts, NULL)) != -1) {
+	while ((c = getopt_long(argc, argv, "c:nNo:s:ShJPV", longopts, NULL)) != -1) {
 		err_exclusive_options(c, longopts, excl, excl_st);
 
 		switch (c) {
@@ -113,9 +122,16 @@ int main(int argc, char **argv)
 		case 'P':
 			out.pairs = 1;
 			break;
+		case 'c':
+			if (irq_add_cpugroup(&out, optarg) != 0)
+				errx(EXIT_FAILURE, _("failed to parse CPU list: %s"), optarg);
+			break;
 		case 'n':
 			out.no_headings = 1;
 			break;
+		case 'N':
+			numa = 1;
+			break;
 		case 'o':
 			outarg = optarg;
 			break;
@@ -125,6 +141,9 @@ int main(int argc, char **argv)
 		case 'S':
 			softirq = 1;
 			break;
+		case OPT_SYSROOT:
+			out.sysroot = optarg;
+			break;
 		case 'V':
 			print_version(EXIT_SUCCESS);
 		case 'h':
@@ -134,6 +153,10 @@ int main(int argc, char **argv)
 		}
 	}
 
+	/* after --sysroot, and only once for repeated -N */
+	if (numa && irq_add_numa_cpugroups(&out) < 0)
+		err(EXIT_FAILURE, _("cannot read NUMA nodes"));
+
 	/* default */
 	if (!out.ncolumns) {
 		out.columns[out.ncolumns++] = COL_IRQ;
@@ -148,5 +171,8 @@ int main(int argc, char **argv)
 				irq_column_name_to_id) < 0)
 		exit(EXIT_FAILURE);
 
-	return print_irq_data(&out, softirq) == 0 ?  EXIT_SUCCESS : EXIT_FAILURE;
+	c = print_irq_data(&out, softirq);
+	irq_free_cpugroups(&out);
+
+	return c == 0 ?  EXIT_SUCCESS : EXIT_FAILURE;
 }
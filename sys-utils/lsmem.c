@@ -24,6 +24,7 @@
 #include <strutils.h>
 #include <closestream.h>
 #include <xalloc.h>
+#include <parallel.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -33,9 +34,16 @@
 #include <assert.h>
 #include <optutils.h>
 #include <libsmartcols.h>
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif
 
 #define _PATH_SYS_MEMORY		"/sys/devices/system/memory"
 
+/* read memory blocks attributes in more threads if there is many blocks */
+#define LSMEM_MAXTHREADS		16
+#define LSMEM_PARALLEL_MIN		1024
+
 #define MEMORY_STATE_ONLINE		0
 #define MEMORY_STATE_OFFLINE		1
 #define MEMORY_STATE_GOING_OFFLINE	2
@@ -65,10 +73,11 @@ struct memory_block {
 
 struct lsmem {
 	struct path_cxt		*sysmem;		/* _PATH_SYS_MEMORY directory handler */
-	struct dirent		**dirs;
-	int			ndirs;
+	uint64_t		*indexes;		/* sorted memory<N> numbers */
+	size_t			nindexes;
 	struct memory_block	*blocks;
 	int			nblocks;
+	int			blocks_alloc;		/* allocated size of blocks[] */
 	uint64_t		block_size;
 	uint64_t		mem_online;
 	uint64_t		mem_offline;
@@ -88,7 +97,10 @@ struct lsmem {
 				split_by_state : 1,
 				split_by_removable : 1,
 				split_by_zones : 1,
-				have_zones : 1;
+				have_zones : 1,
+				want_removable : 1,	/* read only what is necessary */
+				want_node : 1,
+				want_zones : 1;
 };
 
 
@@ -332,13 +344,17 @@ static void print_summary(struct lsmem *lsmem)
 	}
 }
 
-static int memory_block_get_node(struct lsmem *lsmem, char *name)
+static int memory_block_get_node(struct path_cxt *sys, char *name, int hint)
 {
 	struct dirent *de;
 	DIR *dir;
 	int node;
 
-	dir = ul_path_opendir(lsmem->sysmem, name);
+	/* the neighbour blocks are usually on the same node */
+	if (hint >= 0 && ul_path_accessf(sys, F_OK, "%s/node%d", name, hint) == 0)
+		return hint;
+
+	dir = ul_path_opendir(sys, name);
 	if (!dir)
 		err(EXIT_FAILURE, _("Failed to open %s"), name);
 
@@ -355,47 +371,51 @@ static int memory_block_get_node(struct lsmem *lsmem, char *name)
 	return node;
 }
 
-static void memory_block_read_attrs(struct lsmem *lsmem, char *name,
-				    struct memory_block *blk)
+static void memory_block_read_attrs(struct lsmem *lsmem, struct path_cxt *sys,
+				    uint64_t index, struct memory_block *blk,
+				    int *nodehint)
 {
-	char *line = NULL;
+	char name[sizeof("memory") + sizeof(stringify_value(UINT64_MAX))];
+	char buf[BUFSIZ];
 	int i, x = 0;
 
 	memset(blk, 0, sizeof(*blk));
 
 	blk->count = 1;
 	blk->state = MEMORY_STATE_UNKNOWN;
-	blk->index = strtoumax(name + 6, NULL, 10); /* get <num> of "memory<num>" */
+	blk->index = index;
+
+	snprintf(name, sizeof(name), "memory%"PRIu64, index);
 
-	if (ul_path_readf_s32(lsmem->sysmem, &x, "%s/removable", name) == 0)
+	if (lsmem->want_removable &&
+	    ul_path_readf_s32(sys, &x, "%s/removable", name) == 0)
 		blk->removable = x == 1;
 
-	if (ul_path_readf_string(lsmem->sysmem, &line, "%s/state", name) > 0) {
-		if (strcmp(line, "offline") == 0)
+	if (ul_path_readf_buffer(sys, buf, sizeof(buf), "%s/state", name) > 0) {
+		if (strcmp(buf, "offline") == 0)
 			blk->state = MEMORY_STATE_OFFLINE;
-		else if (strcmp(line, "online") == 0)
+		else if (strcmp(buf, "online") == 0)
 			blk->state = MEMORY_STATE_ONLINE;
-		else if (strcmp(line, "going-offline") == 0)
+		else if (strcmp(buf, "going-offline") == 0)
 			blk->state = MEMORY_STATE_GOING_OFFLINE;
-		free(line);
 	}
 
-	if (lsmem->have_nodes)
-		blk->node = memory_block_get_node(lsmem, name);
+	if (lsmem->have_nodes) {
+		blk->node = memory_block_get_node(sys, name, *nodehint);
+		*nodehint = blk->node;
+	}
 
 	blk->nr_zones = 0;
 	if (lsmem->have_zones &&
-	    ul_path_readf_string(lsmem->sysmem, &line, "%s/valid_zones", name) > 0) {
+	    ul_path_readf_buffer(sys, buf, sizeof(buf), "%s/valid_zones", name) > 0) {
 
-		char *token = strtok(line, " ");
+		char *save = NULL, *token = strtok_r(buf, " ", &save);
 
 		for (i = 0; token && i < MAX_NR_ZONES; i++) {
 			blk->zones[i] = zone_name_to_id(token);
 			blk->nr_zones++;
-			token = strtok(NULL, " ");
+			token = strtok_r(NULL, " ", &save);
 		}
-
-		free(line);
 	}
 }
 
@@ -433,39 +453,139 @@ static int is_mergeable(struct lsmem *lsmem, struct memory_block *blk)
 
 static void free_info(struct lsmem *lsmem)
 {
-	int i;
-
 	if (!lsmem)
 		return;
 	free(lsmem->blocks);
-	for (i = 0; i < lsmem->ndirs; i++)
-		free(lsmem->dirs[i]);
-	free(lsmem->dirs);
+	free(lsmem->indexes);
+}
+
+/* Adds the block to the last range or starts a new range */
+static void add_block(struct lsmem *lsmem, struct memory_block *blk)
+{
+	if (blk->state == MEMORY_STATE_ONLINE)
+		lsmem->mem_online += lsmem->block_size;
+	else
+		lsmem->mem_offline += lsmem->block_size;
+
+	if (is_mergeable(lsmem, blk)) {
+		lsmem->blocks[lsmem->nblocks - 1].count++;
+		return;
+	}
+	if (lsmem->nblocks == lsmem->blocks_alloc) {
+		lsmem->blocks_alloc = lsmem->blocks_alloc ? lsmem->blocks_alloc * 2 : 64;
+		lsmem->blocks = xrealloc(lsmem->blocks,
+				lsmem->blocks_alloc * sizeof(*blk));
+	}
+	lsmem->blocks[lsmem->nblocks++] = *blk;
+}
+
+#ifdef HAVE_PTHREAD
+struct lsmem_reader {
+	pthread_t		thread;
+	struct lsmem		*lsmem;
+	struct memory_block	*blocks;
+	size_t			from, to;
+};
+
+static void *read_blocks_thread(void *arg)
+{
+	struct lsmem_reader *rd = (struct lsmem_reader *) arg;
+	struct path_cxt *sys;
+	int nodehint = -1;
+	size_t i;
+
+	/* path_cxt is not thread-safe, use private one */
+	sys = ul_new_path(_PATH_SYS_MEMORY);
+	if (!sys)
+		err_oom();
+	if (ul_path_get_prefix(rd->lsmem->sysmem))
+		ul_path_set_prefix(sys, ul_path_get_prefix(rd->lsmem->sysmem));
+
+	/* open the directory before ul_path_*f() use the path buffer */
+	if (ul_path_get_dirfd(sys) < 0)
+		err(EXIT_FAILURE, _("cannot open %s"), _PATH_SYS_MEMORY);
+
+	for (i = rd->from; i < rd->to; i++)
+		memory_block_read_attrs(rd->lsmem, sys, rd->lsmem->indexes[i],
+					&rd->blocks[i], &nodehint);
+
+	ul_unref_path(sys);
+	return NULL;
+}
+
+static size_t get_nthreads(struct lsmem *lsmem)
+{
+	return ul_get_nthreads("LSMEM_THREADS", lsmem->nindexes,
+			       LSMEM_PARALLEL_MIN, LSMEM_MAXTHREADS);
+}
+
+/*
+ * Reads the blocks in threads, every thread reads a contiguous range of
+ * blocks. The blocks are merged to the ranges in order afterwards.
+ */
+static int read_blocks_parallel(struct lsmem *lsmem)
+{
+	struct lsmem_reader rds[LSMEM_MAXTHREADS];
+	struct memory_block *blocks;
+	size_t i, nthreads = get_nthreads(lsmem), chunk;
+
+	if (nthreads <= 1)
+		return -1;
+
+	blocks = xcalloc(lsmem->nindexes, sizeof(*blocks));
+	chunk = (lsmem->nindexes + nthreads - 1) / nthreads;
+
+	for (i = 0; i < nthreads; i++) {
+		struct lsmem_reader *rd = &rds[i];
+
+		rd->lsmem = lsmem;
+		rd->blocks = blocks;
+		rd->from = min(i * chunk, lsmem->nindexes);
+		rd->to = min(rd->from + chunk, lsmem->nindexes);
+
+		if (pthread_create(&rd->thread, NULL, read_blocks_thread, rd) != 0) {
+			/* read the rest in this thread */
+			rd->to = lsmem->nindexes;
+			read_blocks_thread(rd);
+			break;
+		}
+	}
+	nthreads = i;
+
+	for (i = 0; i < nthreads; i++)
+		pthread_join(rds[i].thread, NULL);
+
+	for (i = 0; i < lsmem->nindexes; i++)
+		add_block(lsmem, &blocks[i]);
+
+	free(blocks);
+	return 0;
 }
+#else
+static int read_blocks_parallel(struct lsmem *lsmem __attribute__((__unused__)))
+{
+	return -1;
+}
+#endif /* HAVE_PTHREAD */
 
 static void read_info(struct lsmem *lsmem)
 {
 	struct memory_block blk;
 	char buf[128];
-	int i;
+	int nodehint = -1;
+	size_t i;
 
 	if (ul_path_read_buffer(lsmem->sysmem, buf, sizeof(buf), "block_size_bytes") <= 0)
 		err(EXIT_FAILURE, _("failed to read memory block size"));
 	lsmem->block_size = strtoumax(buf, NULL, 16);
 
-	for (i = 0; i < lsmem->ndirs; i++) {
-		memory_block_read_attrs(lsmem, lsmem->dirs[i]->d_name, &blk);
-		if (blk.state == MEMORY_STATE_ONLINE)
-			lsmem->mem_online += lsmem->block_size;
-		else
-			lsmem->mem_offline += lsmem->block_size;
-		if (is_mergeable(lsmem, &blk)) {
-			lsmem->blocks[lsmem->nblocks - 1].count++;
-			continue;
-		}
-		lsmem->nblocks++;
-		lsmem->blocks = xrealloc(lsmem->blocks, lsmem->nblocks * sizeof(blk));
-		*&lsmem->blocks[lsmem->nblocks - 1] = blk;
+	if (read_blocks_parallel(lsmem) == 0)
+		return;
+
+	for (i = 0; i < lsmem->nindexes; i++) {
+		memory_block_read_attrs(lsmem, lsmem->sysmem, lsmem->indexes[i],
+					&blk, &nodehint);
+		add_block(lsmem, &blk);
 	}
 }
 
@@ -476,27 +596,87 @@ static int memory_block_filter(const struct dirent *de)
 	return isdigit_string(de->d_name + 6);
 }
 
+static int cmp_indexes(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
 static void read_basic_info(struct lsmem *lsmem)
 {
-	char dir[PATH_MAX];
+	struct dirent *de;
+	size_t nalloc = 0;
+	DIR *dir;
 
 	if (ul_path_access(lsmem->sysmem, F_OK, "block_size_bytes") != 0)
 		errx(EXIT_FAILURE, _("This system does not support memory blocks"));
 
-	ul_path_get_abspath(lsmem->sysmem, dir, sizeof(dir), NULL);
+	/* readdir() and numeric sort is cheaper than scandir() and
+	 * versionsort() for hundreds of thousands of blocks */
+	dir = ul_path_opendir(lsmem->sysmem, NULL);
+	if (!dir)
+		err(EXIT_FAILURE, _("Failed to read %s"), _PATH_SYS_MEMORY);
+
+	while ((de = readdir(dir))) {
+		if (!memory_block_filter(de))
+			continue;
+		if (lsmem->nindexes == nalloc) {
+			nalloc = nalloc ? nalloc * 2 : 256;
+			lsmem->indexes = xrealloc(lsmem->indexes,
+					nalloc * sizeof(*lsmem->indexes));
+		}
+		lsmem->indexes[lsmem->nindexes++] = strtoumax(de->d_name + 6, NULL, 10);
+	}
+	closedir(dir);
+
+	if (!lsmem->nindexes)
+		errx(EXIT_FAILURE, _("Failed to read %s"), _PATH_SYS_MEMORY);
 
-	lsmem->ndirs = scandir(dir, &lsmem->dirs, memory_block_filter, versionsort);
-	if (lsmem->ndirs <= 0)
-		err(EXIT_FAILURE, _("Failed to read %s"), dir);
+	qsort(lsmem->indexes, lsmem->nindexes, sizeof(*lsmem->indexes), cmp_indexes);
 
-	if (memory_block_get_node(lsmem, lsmem->dirs[0]->d_name) != -1)
-		lsmem->have_nodes = 1;
+	if (lsmem->want_node) {
+		char name[sizeof("memory") + sizeof(stringify_value(UINT64_MAX))];
+
+		snprintf(name, sizeof(name), "memory%"PRIu64, lsmem->indexes[0]);
+		if (memory_block_get_node(lsmem->sysmem, name, -1) != -1)
+			lsmem->have_nodes = 1;
+	}
 
 	/* The valid_zones sysmem attribute was introduced with kernel 3.18 */
-	if (ul_path_access(lsmem->sysmem, F_OK, "memory0/valid_zones") == 0)
+	if (lsmem->want_zones &&
+	    ul_path_access(lsmem->sysmem, F_OK, "memory0/valid_zones") == 0)
 		lsmem->have_zones = 1;
 }
 
+/* Returns 1 if the column is in the output or used to split ranges */
+static int is_column_wanted(struct lsmem *lsmem, int id)
+{
+	size_t i;
+
+	for (i = 0; i < ncolumns; i++) {
+		if (get_column_id(i) == id)
+			return 1;
+	}
+
+	switch (id) {
+	case COL_REMOVABLE:
+		return lsmem->split_by_removable;
+	case COL_NODE:
+		return lsmem->split_by_node;
+	case COL_ZONES:
+		return lsmem->split_by_zones;
+	}
+	return 0;
+}
+
+static void set_wanted_attrs(struct lsmem *lsmem)
+{
+	lsmem->want_removable = is_column_wanted(lsmem, COL_REMOVABLE);
+	lsmem->want_node = is_column_wanted(lsmem, COL_NODE);
+	lsmem->want_zones = is_column_wanted(lsmem, COL_ZONES);
+}
+
 static void __attribute__((__noreturn__)) usage(void)
 {
 	FILE *out = stdout;
@@ -740,6 +920,7 @@ int main(int argc, char **argv)
 	/*
 	 * Read data and print output
 	 */
+	set_wanted_attrs(lsmem);
 	read_basic_info(lsmem);
 	read_info(lsmem);
 
@@ -786,6 +786,7 @@ static struct libscols_table *init_scols_table(struct lsns *ls)
 	scols_table_enable_raw(tab, ls->raw);
 	scols_table_enable_json(tab, ls->json);
 	scols_table_enable_noheadings(tab, ls->no_headings);
+	scols_table_enable_arena(tab, 1);
 
 	if (ls->json)
 		scols_table_set_name(tab, "namespaces");
@@ -202,7 +202,8 @@ int main(int argc, char **argv)
 	}
 	if (ctl.dev_devno)
 		return print_devno(&ctl) ? EXIT_FAILURE : EXIT_SUCCESS;
-	if ((ctl.nofollow && S_ISLNK(ctl.st.st_mode)) || dir_to_device(&ctl)) {
+	if ((ctl.nofollow && S_ISLNK(ctl.st.st_mode)) ||
+	    (ctl.fs_devno ? dir_to_device(&ctl) : mnt_is_mountpoint(ctl.path) != 1)) {
 		if (!ctl.quiet)
 			printf(_("%s is not a mountpoint\n"), ctl.path);
 		return EXIT_FAILURE;
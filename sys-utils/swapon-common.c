@@ -43,6 +43,7 @@ struct libmnt_table *get_swaps(void)
 			return NULL;
 		mnt_table_set_cache(swaps, mntcache);
 		mnt_table_set_parser_errcb(swaps, table_parser_errcb);
+		mnt_table_enable_index(swaps, 1);
 		if (mnt_table_parse_swaps(swaps, NULL) != 0)
 			return NULL;
 	}
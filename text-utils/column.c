@@ -210,6 +210,8 @@ static void init_table(struct column_control *ctl)
 		err(EXIT_FAILURE, _("failed to allocate output table"));
 
 	scols_table_set_column_separator(ctl->tab, ctl->output_separator);
+	scols_table_enable_arena(ctl->tab, 1);
+	scols_table_set_print_threads(ctl->tab, 0);
 	if (ctl->json) {
 		scols_table_enable_json(ctl->tab, 1);
 		scols_table_set_name(ctl->tab, ctl->tab_name ? : "table");